@@ -0,0 +1,36 @@
+#include "arena.h"
+#include <cstdlib>
+#include <cstring>
+
+void* Arena::allocate_slow(size_t size, size_t align) {
+    // Oversized requests get a block of their own so the current one keeps filling
+    size_t block_size = size + align > BLOCK_SIZE / 4 ? size + align : BLOCK_SIZE;
+    char* block = static_cast<char*>(malloc(block_size));
+    if (!block) throw std::bad_alloc();
+    blocks.push_back(block);
+    reserved += block_size;
+
+    uintptr_t p = (reinterpret_cast<uintptr_t>(block) + align - 1) & ~(uintptr_t)(align - 1);
+    if (block_size == BLOCK_SIZE) {
+        cursor = reinterpret_cast<char*>(p + size);
+        limit = block + block_size;
+    }
+    used += size;
+    return reinterpret_cast<void*>(p);
+}
+
+const char* Arena::copy_string(const char* s, size_t len) {
+    char* copy = static_cast<char*>(allocate(len + 1, 1));
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void Arena::release() {
+    for (char* block : blocks) {
+        free(block);
+    }
+    blocks.clear();
+    cursor = limit = nullptr;
+    used = reserved = 0;
+}
@@ -0,0 +1,98 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for AST nodes and parser values. Allocations are carved out
+// of large blocks and all released together when the arena goes away;
+// destructors never run, so only trivially destructible types may live here.
+class Arena {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<char*> blocks;
+    char* cursor;
+    char* limit;
+    size_t used;
+    size_t reserved;
+
+    void* allocate_slow(size_t size, size_t align);
+
+public:
+    Arena() : cursor(nullptr), limit(nullptr), used(0), reserved(0) {}
+    ~Arena() { release(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        if (cursor && p + size <= reinterpret_cast<uintptr_t>(limit)) {
+            cursor = reinterpret_cast<char*>(p + size);
+            used += size;
+            return reinterpret_cast<void*>(p);
+        }
+        return allocate_slow(size, align);
+    }
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // NUL-terminated copy of s[0..len)
+    const char* copy_string(const char* s, size_t len);
+
+    size_t bytes_used() const { return used; }
+    size_t bytes_reserved() const { return reserved; }
+    size_t block_count() const { return blocks.size(); }
+    void release();
+};
+
+// Growable array whose storage lives in an Arena. It is a plain handle:
+// copies share the same elements and nothing is freed until the arena is.
+template<typename T>
+class ArenaList {
+private:
+    T* items;
+    uint32_t count;
+    uint32_t capacity;
+    Arena* arena;
+
+public:
+    ArenaList() : items(nullptr), count(0), capacity(0), arena(nullptr) {}
+    explicit ArenaList(Arena* a) : items(nullptr), count(0), capacity(0), arena(a) {}
+
+    void push_back(const T& value) {
+        if (count == capacity) {
+            assert(arena && "push_back on a list without an arena");
+            uint32_t new_capacity = capacity ? capacity * 2 : 4;
+            T* grown = static_cast<T*>(arena->allocate(sizeof(T) * new_capacity, alignof(T)));
+            for (uint32_t i = 0; i < count; i++) grown[i] = items[i];
+            items = grown;
+            capacity = new_capacity;
+        }
+        items[count++] = value;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    T& back() { return items[count - 1]; }
+    const T& back() const { return items[count - 1]; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    Arena* get_arena() const { return arena; }
+};
+
+#endif // ARENA_H
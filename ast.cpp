@@ -0,0 +1,144 @@
+#include "ast.h"
+
+void collect_calls(ExprNode* expr, std::vector<CallNode*>& calls) {
+    if (!expr) return;
+    switch (expr->type) {
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            collect_calls(node->left, calls);
+            collect_calls(node->right, calls);
+            break;
+        }
+        case NodeType::UNARY_OP:
+            collect_calls(static_cast<UnaryOpNode*>(expr)->operand, calls);
+            break;
+        case NodeType::CALL: {
+            CallNode* node = static_cast<CallNode*>(expr);
+            calls.push_back(node);
+            for (ExprNode* arg : node->args) collect_calls(arg, calls);
+            break;
+        }
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            collect_calls(node->value, calls);
+            collect_calls(node->length, calls);
+            break;
+        }
+        case NodeType::INDEX:
+            collect_calls(static_cast<IndexNode*>(expr)->index, calls);
+            break;
+        default:
+            break;
+    }
+}
+
+void collect_calls(const StmtList& stmts, std::vector<CallNode*>& calls) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                collect_calls(static_cast<AssignNode*>(stmt)->value, calls);
+                break;
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                collect_calls(node->index, calls);
+                collect_calls(node->value, calls);
+                break;
+            }
+            case NodeType::RETURN_STMT:
+                collect_calls(static_cast<ReturnNode*>(stmt)->value, calls);
+                break;
+            case NodeType::EXPR_STMT:
+                collect_calls(static_cast<ExprStmtNode*>(stmt)->expr, calls);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                collect_calls(node->condition, calls);
+                collect_calls(node->then_block, calls);
+                collect_calls(node->else_block, calls);
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                collect_calls(node->condition, calls);
+                collect_calls(node->body, calls);
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                collect_calls(node->start, calls);
+                collect_calls(node->stop, calls);
+                collect_calls(node->body, calls);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+size_t count_nodes(ExprNode* expr) {
+    if (!expr) return 0;
+    switch (expr->type) {
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            return 1 + count_nodes(node->left) + count_nodes(node->right);
+        }
+        case NodeType::UNARY_OP:
+            return 1 + count_nodes(static_cast<UnaryOpNode*>(expr)->operand);
+        case NodeType::CALL: {
+            size_t count = 1;
+            for (ExprNode* arg : static_cast<CallNode*>(expr)->args) count += count_nodes(arg);
+            return count;
+        }
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            return 1 + count_nodes(node->value) + count_nodes(node->length);
+        }
+        case NodeType::INDEX:
+            return 1 + count_nodes(static_cast<IndexNode*>(expr)->index);
+        default:
+            return 1;
+    }
+}
+
+size_t count_nodes(const StmtList& stmts) {
+    size_t count = 0;
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                count += 1 + count_nodes(static_cast<AssignNode*>(stmt)->value);
+                break;
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                count += 1 + count_nodes(node->index) + count_nodes(node->value);
+                break;
+            }
+            case NodeType::RETURN_STMT:
+                count += 1 + count_nodes(static_cast<ReturnNode*>(stmt)->value);
+                break;
+            case NodeType::EXPR_STMT:
+                count += 1 + count_nodes(static_cast<ExprStmtNode*>(stmt)->expr);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                count += 1 + count_nodes(node->condition) + count_nodes(node->then_block) +
+                         count_nodes(node->else_block);
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                count += 1 + count_nodes(node->condition) + count_nodes(node->body);
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                count += 1 + count_nodes(node->start) + count_nodes(node->stop) + count_nodes(node->body);
+                break;
+            }
+            default:
+                count += 1;
+                break;
+        }
+    }
+    return count;
+}
@@ -2,8 +2,8 @@
 #define AST_H
 
 #include <vector>
-#include <string>
-#include <memory>
+#include "arena.h"
+#include "symbol.h"
 
 enum class NodeType {
     PROGRAM,
@@ -12,11 +12,16 @@ enum class NodeType {
     RETURN_STMT,
     IF_STMT,
     WHILE_STMT,
+    FOR_RANGE_STMT,
     EXPR_STMT,
     ASSIGN,
+    INDEX_ASSIGN,
     BINARY_OP,
     UNARY_OP,
     CALL,
+    NEW_LIST,
+    INDEX,
+    LEN,
     IDENTIFIER,
     INTEGER
 };
@@ -31,10 +36,17 @@ enum class UnaryOp {
     NEG, NOT
 };
 
+// All nodes are allocated in an Arena and released with it, so they hold
+// children as raw pointers, lists as ArenaLists and names as interned Symbols.
+class ExprNode;
+class StmtNode;
+typedef ArenaList<ExprNode*> ExprList;
+typedef ArenaList<StmtNode*> StmtList;
+typedef ArenaList<Symbol> NameList;
+
 class ASTNode {
 public:
     NodeType type;
-    virtual ~ASTNode() = default;
 protected:
     ASTNode(NodeType t) : type(t) {}
 };
@@ -52,33 +64,57 @@ public:
 
 class IdentifierNode : public ExprNode {
 public:
-    std::string name;
-    IdentifierNode(const std::string& n) : ExprNode(NodeType::IDENTIFIER), name(n) {}
+    Symbol name;
+    IdentifierNode(Symbol n) : ExprNode(NodeType::IDENTIFIER), name(n) {}
 };
 
 class BinaryOpNode : public ExprNode {
 public:
     BinaryOp op;
-    std::unique_ptr<ExprNode> left;
-    std::unique_ptr<ExprNode> right;
-    BinaryOpNode(BinaryOp o, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r)
-        : ExprNode(NodeType::BINARY_OP), op(o), left(std::move(l)), right(std::move(r)) {}
+    ExprNode* left;
+    ExprNode* right;
+    BinaryOpNode(BinaryOp o, ExprNode* l, ExprNode* r)
+        : ExprNode(NodeType::BINARY_OP), op(o), left(l), right(r) {}
 };
 
 class UnaryOpNode : public ExprNode {
 public:
     UnaryOp op;
-    std::unique_ptr<ExprNode> operand;
-    UnaryOpNode(UnaryOp o, std::unique_ptr<ExprNode> operand)
-        : ExprNode(NodeType::UNARY_OP), op(o), operand(std::move(operand)) {}
+    ExprNode* operand;
+    UnaryOpNode(UnaryOp o, ExprNode* operand)
+        : ExprNode(NodeType::UNARY_OP), op(o), operand(operand) {}
 };
 
 class CallNode : public ExprNode {
 public:
-    std::string function_name;
-    std::vector<std::unique_ptr<ExprNode>> args;
-    CallNode(const std::string& name, std::vector<std::unique_ptr<ExprNode>> a)
-        : ExprNode(NodeType::CALL), function_name(name), args(std::move(a)) {}
+    Symbol function_name;
+    ExprList args;
+    CallNode(Symbol name, ExprList a)
+        : ExprNode(NodeType::CALL), function_name(name), args(a) {}
+};
+
+// [value] * length, the only way to make a list. Lists hold ints and live
+// in local variables of the function that made them.
+class NewListNode : public ExprNode {
+public:
+    ExprNode* value;
+    ExprNode* length;
+    NewListNode(ExprNode* v, ExprNode* len)
+        : ExprNode(NodeType::NEW_LIST), value(v), length(len) {}
+};
+
+class IndexNode : public ExprNode {
+public:
+    Symbol list_name;
+    ExprNode* index;
+    IndexNode(Symbol name, ExprNode* i)
+        : ExprNode(NodeType::INDEX), list_name(name), index(i) {}
+};
+
+class LenNode : public ExprNode {
+public:
+    Symbol list_name;
+    LenNode(Symbol name) : ExprNode(NodeType::LEN), list_name(name) {}
 };
 
 class StmtNode : public ASTNode {
@@ -88,60 +124,95 @@ public:
 
 class AssignNode : public StmtNode {
 public:
-    std::string var_name;
-    std::unique_ptr<ExprNode> value;
-    AssignNode(const std::string& name, std::unique_ptr<ExprNode> val)
-        : StmtNode(NodeType::ASSIGN), var_name(name), value(std::move(val)) {}
+    Symbol var_name;
+    ExprNode* value;
+    AssignNode(Symbol name, ExprNode* val)
+        : StmtNode(NodeType::ASSIGN), var_name(name), value(val) {}
+};
+
+class IndexAssignNode : public StmtNode {
+public:
+    Symbol list_name;
+    ExprNode* index;
+    ExprNode* value;
+    IndexAssignNode(Symbol name, ExprNode* i, ExprNode* val)
+        : StmtNode(NodeType::INDEX_ASSIGN), list_name(name), index(i), value(val) {}
 };
 
 class ExprStmtNode : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> expr;
-    ExprStmtNode(std::unique_ptr<ExprNode> e)
-        : StmtNode(NodeType::EXPR_STMT), expr(std::move(e)) {}
+    ExprNode* expr;
+    ExprStmtNode(ExprNode* e)
+        : StmtNode(NodeType::EXPR_STMT), expr(e) {}
 };
 
 class ReturnNode : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> value;
-    ReturnNode(std::unique_ptr<ExprNode> val)
-        : StmtNode(NodeType::RETURN_STMT), value(std::move(val)) {}
+    ExprNode* value;
+    ReturnNode(ExprNode* val)
+        : StmtNode(NodeType::RETURN_STMT), value(val) {}
 };
 
 class IfNode : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> condition;
-    std::vector<std::unique_ptr<StmtNode>> then_block;
-    std::vector<std::unique_ptr<StmtNode>> else_block;
-    IfNode(std::unique_ptr<ExprNode> cond,
-           std::vector<std::unique_ptr<StmtNode>> then_b,
-           std::vector<std::unique_ptr<StmtNode>> else_b)
-        : StmtNode(NodeType::IF_STMT), condition(std::move(cond)),
-          then_block(std::move(then_b)), else_block(std::move(else_b)) {}
+    ExprNode* condition;
+    StmtList then_block;
+    StmtList else_block;
+    IfNode(ExprNode* cond, StmtList then_b, StmtList else_b)
+        : StmtNode(NodeType::IF_STMT), condition(cond),
+          then_block(then_b), else_block(else_b) {}
 };
 
 class WhileNode : public StmtNode {
 public:
-    std::unique_ptr<ExprNode> condition;
-    std::vector<std::unique_ptr<StmtNode>> body;
-    WhileNode(std::unique_ptr<ExprNode> cond, std::vector<std::unique_ptr<StmtNode>> b)
-        : StmtNode(NodeType::WHILE_STMT), condition(std::move(cond)), body(std::move(b)) {}
+    ExprNode* condition;
+    StmtList body;
+    WhileNode(ExprNode* cond, StmtList b)
+        : StmtNode(NodeType::WHILE_STMT), condition(cond), body(b) {}
+};
+
+// for var_name in range(start, stop, step). The step is a nonzero constant,
+// so the loop's direction is known and its trip count is fixed on entry.
+// prange instead of range runs the iterations in parallel.
+class ForRangeNode : public StmtNode {
+public:
+    Symbol var_name;
+    ExprNode* start;
+    ExprNode* stop;
+    int step;
+    StmtList body;
+    bool parallel;
+    ForRangeNode(Symbol name, ExprNode* start, ExprNode* stop, int step, StmtList b, bool parallel)
+        : StmtNode(NodeType::FOR_RANGE_STMT), var_name(name), start(start), stop(stop),
+          step(step), body(b), parallel(parallel) {}
 };
 
 class FunctionDefNode : public ASTNode {
 public:
-    std::string name;
-    std::vector<std::string> params;
-    std::vector<std::unique_ptr<StmtNode>> body;
-    FunctionDefNode(const std::string& n, std::vector<std::string> p,
-                    std::vector<std::unique_ptr<StmtNode>> b)
-        : ASTNode(NodeType::FUNCTION_DEF), name(n), params(std::move(p)), body(std::move(b)) {}
+    Symbol name;
+    NameList params;
+    StmtList body;
+    bool memoize;   // Decorated with @cache or @lru_cache
+    FunctionDefNode(Symbol n, NameList p, StmtList b)
+        : ASTNode(NodeType::FUNCTION_DEF), name(n), params(p), body(b), memoize(false) {}
 };
 
 class ProgramNode : public ASTNode {
 public:
-    std::vector<std::unique_ptr<FunctionDefNode>> functions;
-    ProgramNode() : ASTNode(NodeType::PROGRAM) {}
+    ArenaList<FunctionDefNode*> functions;
+    const Interner* symbols;   // Names of the Symbols in this program
+    ProgramNode(ArenaList<FunctionDefNode*> f, const Interner* s)
+        : ASTNode(NodeType::PROGRAM), functions(f), symbols(s) {}
 };
 
+// Append every call made by expr or stmts, nested ones included, to calls;
+// expr may be null
+void collect_calls(ExprNode* expr, std::vector<CallNode*>& calls);
+void collect_calls(const StmtList& stmts, std::vector<CallNode*>& calls);
+
+// Number of AST nodes in expr or stmts, their children included; expr may
+// be null
+size_t count_nodes(ExprNode* expr);
+size_t count_nodes(const StmtList& stmts);
+
 #endif // AST_H
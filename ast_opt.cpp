@@ -0,0 +1,571 @@
+#include "ast_opt.h"
+#include <climits>
+#include <cstdint>
+#include "purity.h"
+
+void ASTOptStats::print(std::ostream& os) const {
+    os << "AST optimizer statistics:\n";
+    os << "  constant-fold: " << constants_folded << " expressions folded\n";
+    os << "  simplify:      " << identities_simplified << " identities simplified\n";
+    os << "  dce:           " << branches_pruned << " branches pruned, "
+       << statements_removed << " statements removed\n";
+    os << "  ipcp:          " << parameters_propagated << " parameters replaced by constants\n";
+}
+
+static bool get_constant(ExprNode* expr, int* value) {
+    if (expr->type != NodeType::INTEGER) return false;
+    *value = static_cast<IntegerNode*>(expr)->value;
+    return true;
+}
+
+// Comparisons and logic operators already produce 0 or 1
+static bool is_boolean(ExprNode* expr) {
+    if (expr->type == NodeType::UNARY_OP) {
+        return static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NOT;
+    }
+    if (expr->type != NodeType::BINARY_OP) return false;
+    switch (static_cast<BinaryOpNode*>(expr)->op) {
+        case BinaryOp::ADD: case BinaryOp::SUB: case BinaryOp::MUL:
+        case BinaryOp::DIV: case BinaryOp::MOD:
+            return false;
+        default:
+            return true;
+    }
+}
+
+static ExprNode* to_boolean(Arena& arena, ExprNode* expr) {
+    if (is_boolean(expr)) return expr;
+    return arena.make<BinaryOpNode>(BinaryOp::NEQ, expr, arena.make<IntegerNode>(0));
+}
+
+static ExprNode* make_integer(Arena& arena, int value) {
+    return arena.make<IntegerNode>(value);
+}
+
+static ExprNode* make_negate(Arena& arena, ExprNode* expr) {
+    return arena.make<UnaryOpNode>(UnaryOp::NEG, expr);
+}
+
+// i32 arithmetic wraps, exactly like the add/sub/mul the code generator emits
+static int wrap(int64_t value) {
+    return static_cast<int>(static_cast<uint32_t>(value));
+}
+
+// Evaluate a binary operator on constants. Division and modulo round toward
+// negative infinity as in Python; division by zero and INT_MIN / -1 are left
+// for run time.
+static bool fold_constants(BinaryOp op, int a, int b, int* result) {
+    switch (op) {
+        case BinaryOp::ADD: *result = wrap(static_cast<int64_t>(a) + b); return true;
+        case BinaryOp::SUB: *result = wrap(static_cast<int64_t>(a) - b); return true;
+        case BinaryOp::MUL: *result = wrap(static_cast<int64_t>(a) * b); return true;
+        case BinaryOp::DIV:
+        case BinaryOp::MOD: {
+            if (b == 0 || (a == INT_MIN && b == -1)) return false;
+            int quotient = a / b;
+            int remainder = a % b;
+            if (remainder != 0 && ((remainder < 0) != (b < 0))) {
+                quotient -= 1;
+                remainder += b;
+            }
+            *result = (op == BinaryOp::DIV) ? quotient : remainder;
+            return true;
+        }
+        case BinaryOp::EQ: *result = a == b; return true;
+        case BinaryOp::NEQ: *result = a != b; return true;
+        case BinaryOp::GT: *result = a > b; return true;
+        case BinaryOp::LT: *result = a < b; return true;
+        case BinaryOp::GTE: *result = a >= b; return true;
+        case BinaryOp::LTE: *result = a <= b; return true;
+        case BinaryOp::AND: *result = a != 0 && b != 0; return true;
+        case BinaryOp::OR: *result = a != 0 || b != 0; return true;
+    }
+    return false;
+}
+
+ExprNode* ASTOptimizer::optimize_expr(ExprNode* expr) {
+    switch (expr->type) {
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            node->left = optimize_expr(node->left);
+            node->right = optimize_expr(node->right);
+            ExprNode* folded = fold_binary(node);
+            if (folded) return folded;
+            return simplify_binary(expr);
+        }
+
+        case NodeType::UNARY_OP: {
+            UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
+            node->operand = optimize_expr(node->operand);
+            return optimize_unary(expr);
+        }
+
+        case NodeType::CALL: {
+            CallNode* node = static_cast<CallNode*>(expr);
+            for (ExprNode*& arg : node->args) {
+                arg = optimize_expr(arg);
+            }
+            return expr;
+        }
+
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            node->value = optimize_expr(node->value);
+            node->length = optimize_expr(node->length);
+            return expr;
+        }
+
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            node->index = optimize_expr(node->index);
+            return expr;
+        }
+
+        default:
+            return expr;
+    }
+}
+
+ExprNode* ASTOptimizer::fold_binary(BinaryOpNode* node) {
+    int a, b, result;
+    if (!get_constant(node->left, &a) || !get_constant(node->right, &b)) {
+        return nullptr;
+    }
+    if (!fold_constants(node->op, a, b, &result)) {
+        return nullptr;
+    }
+    stats.constants_folded++;
+    return make_integer(arena, result);
+}
+
+ExprNode* ASTOptimizer::simplify_binary(ExprNode* expr) {
+    BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+    int value;
+    bool left_const = get_constant(node->left, &value);
+    int left_value = value;
+    bool right_const = get_constant(node->right, &value);
+    int right_value = value;
+
+    ExprNode* result = nullptr;
+    switch (node->op) {
+        case BinaryOp::AND:
+            if (left_const) {
+                // Short-circuit: a false left side never evaluates the right
+                result = left_value == 0 ? make_integer(arena, 0) : to_boolean(arena, node->right);
+            } else if (right_const) {
+                if (right_value != 0) {
+                    result = to_boolean(arena, node->left);
+                } else if (is_effect_free(node->left)) {
+                    result = make_integer(arena, 0);
+                }
+            }
+            break;
+
+        case BinaryOp::OR:
+            if (left_const) {
+                result = left_value != 0 ? make_integer(arena, 1) : to_boolean(arena, node->right);
+            } else if (right_const) {
+                if (right_value == 0) {
+                    result = to_boolean(arena, node->left);
+                } else if (is_effect_free(node->left)) {
+                    result = make_integer(arena, 1);
+                }
+            }
+            break;
+
+        case BinaryOp::ADD:
+            if (right_const && right_value == 0) {
+                result = node->left;
+            } else if (left_const && left_value == 0) {
+                result = node->right;
+            }
+            break;
+
+        case BinaryOp::SUB:
+            if (right_const && right_value == 0) {
+                result = node->left;
+            } else if (left_const && left_value == 0) {
+                result = make_negate(arena, node->right);
+            } else if (node->left->type == NodeType::IDENTIFIER &&
+                       node->right->type == NodeType::IDENTIFIER &&
+                       static_cast<IdentifierNode*>(node->left)->name ==
+                       static_cast<IdentifierNode*>(node->right)->name) {
+                result = make_integer(arena, 0);
+            }
+            break;
+
+        case BinaryOp::MUL:
+            if (right_const && right_value == 1) {
+                result = node->left;
+            } else if (left_const && left_value == 1) {
+                result = node->right;
+            } else if (right_const && right_value == -1) {
+                result = make_negate(arena, node->left);
+            } else if (left_const && left_value == -1) {
+                result = make_negate(arena, node->right);
+            } else if (right_const && right_value == 0 && is_effect_free(node->left)) {
+                result = make_integer(arena, 0);
+            } else if (left_const && left_value == 0 && is_effect_free(node->right)) {
+                result = make_integer(arena, 0);
+            }
+            break;
+
+        case BinaryOp::DIV:
+            if (right_const && right_value == 1) {
+                result = node->left;
+            } else if (right_const && right_value == -1) {
+                result = make_negate(arena, node->left);
+            }
+            break;
+
+        case BinaryOp::MOD:
+            if (right_const && (right_value == 1 || right_value == -1) && is_effect_free(node->left)) {
+                result = make_integer(arena, 0);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (!result) return expr;
+    stats.identities_simplified++;
+    return result;
+}
+
+ExprNode* ASTOptimizer::optimize_unary(ExprNode* expr) {
+    UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
+    int value;
+    if (get_constant(node->operand, &value)) {
+        stats.constants_folded++;
+        if (node->op == UnaryOp::NEG) {
+            return make_integer(arena, wrap(-static_cast<int64_t>(value)));
+        }
+        return make_integer(arena, value == 0);
+    }
+
+    // --x => x
+    if (node->op == UnaryOp::NEG && node->operand->type == NodeType::UNARY_OP &&
+        static_cast<UnaryOpNode*>(node->operand)->op == UnaryOp::NEG) {
+        stats.identities_simplified++;
+        return static_cast<UnaryOpNode*>(node->operand)->operand;
+    }
+    return expr;
+}
+
+// True if control never continues past this statement. Blocks have already
+// been cleaned, so a terminating statement is always the last one.
+static bool always_returns(StmtNode* stmt) {
+    if (stmt->type == NodeType::RETURN_STMT) return true;
+    if (stmt->type != NodeType::IF_STMT) return false;
+    IfNode* node = static_cast<IfNode*>(stmt);
+    return !node->then_block.empty() && !node->else_block.empty() &&
+           always_returns(node->then_block.back()) &&
+           always_returns(node->else_block.back());
+}
+
+void ASTOptimizer::optimize_block(StmtList& stmts) {
+    StmtList result(&arena);
+
+    for (size_t i = 0; i < stmts.size(); i++) {
+        // Everything after a statement that always returns is unreachable
+        if (!result.empty() && always_returns(result.back())) {
+            stats.statements_removed += stmts.size() - i;
+            break;
+        }
+
+        StmtNode* stmt = stmts[i];
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                node->value = optimize_expr(node->value);
+                result.push_back(stmt);
+                break;
+            }
+
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                node->index = optimize_expr(node->index);
+                node->value = optimize_expr(node->value);
+                result.push_back(stmt);
+                break;
+            }
+
+            case NodeType::RETURN_STMT: {
+                ReturnNode* node = static_cast<ReturnNode*>(stmt);
+                node->value = optimize_expr(node->value);
+                result.push_back(stmt);
+                break;
+            }
+
+            case NodeType::EXPR_STMT: {
+                ExprStmtNode* node = static_cast<ExprStmtNode*>(stmt);
+                node->expr = optimize_expr(node->expr);
+                if (is_effect_free(node->expr)) {
+                    stats.statements_removed++;
+                } else {
+                    result.push_back(stmt);
+                }
+                break;
+            }
+
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                node->condition = optimize_expr(node->condition);
+                optimize_block(node->then_block);
+                optimize_block(node->else_block);
+
+                int value;
+                if (get_constant(node->condition, &value)) {
+                    // Splice the branch that is always taken into this block
+                    stats.branches_pruned++;
+                    StmtList& taken = value != 0 ? node->then_block : node->else_block;
+                    for (StmtNode* s : taken) {
+                        result.push_back(s);
+                    }
+                } else {
+                    result.push_back(stmt);
+                }
+                break;
+            }
+
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                node->condition = optimize_expr(node->condition);
+                optimize_block(node->body);
+
+                int value;
+                if (get_constant(node->condition, &value) && value == 0) {
+                    stats.branches_pruned++;
+                } else {
+                    result.push_back(stmt);
+                }
+                break;
+            }
+
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                node->start = optimize_expr(node->start);
+                node->stop = optimize_expr(node->stop);
+                optimize_block(node->body);
+
+                // An empty range runs nothing and leaves the variable alone
+                int start, stop;
+                if (get_constant(node->start, &start) && get_constant(node->stop, &stop) &&
+                    (node->step > 0 ? start >= stop : start <= stop)) {
+                    stats.branches_pruned++;
+                } else {
+                    result.push_back(stmt);
+                }
+                break;
+            }
+
+            default:
+                result.push_back(stmt);
+                break;
+        }
+    }
+
+    stmts = result;
+}
+
+static bool assigns(const StmtList& stmts, Symbol name) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                if (static_cast<AssignNode*>(stmt)->var_name == name) return true;
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                if (assigns(node->then_block, name) || assigns(node->else_block, name)) return true;
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                if (assigns(static_cast<WhileNode*>(stmt)->body, name)) return true;
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                if (node->var_name == name || assigns(node->body, name)) return true;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// Replace every use of name by the literal value
+static ExprNode* substitute(Arena& arena, ExprNode* expr, Symbol name, int value) {
+    switch (expr->type) {
+        case NodeType::IDENTIFIER:
+            if (static_cast<IdentifierNode*>(expr)->name == name) return make_integer(arena, value);
+            return expr;
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            node->left = substitute(arena, node->left, name, value);
+            node->right = substitute(arena, node->right, name, value);
+            return expr;
+        }
+        case NodeType::UNARY_OP: {
+            UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
+            node->operand = substitute(arena, node->operand, name, value);
+            return expr;
+        }
+        case NodeType::CALL:
+            for (ExprNode*& arg : static_cast<CallNode*>(expr)->args) {
+                arg = substitute(arena, arg, name, value);
+            }
+            return expr;
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            node->value = substitute(arena, node->value, name, value);
+            node->length = substitute(arena, node->length, name, value);
+            return expr;
+        }
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            node->index = substitute(arena, node->index, name, value);
+            return expr;
+        }
+        default:
+            return expr;
+    }
+}
+
+static void substitute(Arena& arena, StmtList& stmts, Symbol name, int value) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                node->value = substitute(arena, node->value, name, value);
+                break;
+            }
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                node->index = substitute(arena, node->index, name, value);
+                node->value = substitute(arena, node->value, name, value);
+                break;
+            }
+            case NodeType::RETURN_STMT: {
+                ReturnNode* node = static_cast<ReturnNode*>(stmt);
+                node->value = substitute(arena, node->value, name, value);
+                break;
+            }
+            case NodeType::EXPR_STMT: {
+                ExprStmtNode* node = static_cast<ExprStmtNode*>(stmt);
+                node->expr = substitute(arena, node->expr, name, value);
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                node->condition = substitute(arena, node->condition, name, value);
+                substitute(arena, node->then_block, name, value);
+                substitute(arena, node->else_block, name, value);
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                node->condition = substitute(arena, node->condition, name, value);
+                substitute(arena, node->body, name, value);
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                node->start = substitute(arena, node->start, name, value);
+                node->stop = substitute(arena, node->stop, name, value);
+                substitute(arena, node->body, name, value);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// One round of interprocedural constant propagation. The whole program is
+// known, so a parameter of any function but main that is never reassigned
+// and receives the same literal at every call site is that literal; a
+// recursive call passing the parameter straight through agrees with any
+// value. Returns true if a function was rewritten.
+bool ASTOptimizer::propagate_constants(ProgramNode* program,
+                                       std::vector<std::vector<bool>>& propagated) {
+    size_t count = program->functions.size();
+    std::vector<int> index(program->symbols->size(), -1);
+    for (size_t i = 0; i < count; i++) {
+        Symbol name = program->functions[i]->name;
+        // Redefinitions are left alone
+        index[name] = index[name] == -1 ? static_cast<int>(i) : -2;
+    }
+
+    // Per parameter: no constant seen yet, a constant, or conflicting values
+    enum State { UNSEEN, CONSTANT, VARYING };
+    std::vector<std::vector<State>> state(count);
+    std::vector<std::vector<int>> value(count);
+    for (size_t i = 0; i < count; i++) {
+        state[i].assign(program->functions[i]->params.size(), UNSEEN);
+        value[i].assign(program->functions[i]->params.size(), 0);
+    }
+
+    for (size_t caller = 0; caller < count; caller++) {
+        std::vector<CallNode*> calls;
+        collect_calls(program->functions[caller]->body, calls);
+        for (CallNode* call : calls) {
+            int callee = index[call->function_name];
+            if (callee < 0) continue;
+            FunctionDefNode* func = program->functions[callee];
+            for (size_t p = 0; p < state[callee].size(); p++) {
+                ExprNode* arg = p < call->args.size() ? call->args[p] : nullptr;
+                int constant;
+                if (call->args.size() != func->params.size()) {
+                    state[callee][p] = VARYING;
+                } else if (get_constant(arg, &constant)) {
+                    if (state[callee][p] == UNSEEN) {
+                        state[callee][p] = CONSTANT;
+                        value[callee][p] = constant;
+                    } else if (state[callee][p] == CONSTANT && value[callee][p] != constant) {
+                        state[callee][p] = VARYING;
+                    }
+                } else if (!(static_cast<int>(caller) == callee && arg->type == NodeType::IDENTIFIER &&
+                             static_cast<IdentifierNode*>(arg)->name == func->params[p])) {
+                    state[callee][p] = VARYING;
+                }
+            }
+        }
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        FunctionDefNode* func = program->functions[i];
+        if (func->name == SYM_MAIN || index[func->name] < 0) continue;
+        bool rewritten = false;
+        for (size_t p = 0; p < func->params.size(); p++) {
+            if (state[i][p] != CONSTANT || propagated[i][p] || assigns(func->body, func->params[p])) {
+                continue;
+            }
+            substitute(arena, func->body, func->params[p], value[i][p]);
+            propagated[i][p] = true;
+            stats.parameters_propagated++;
+            rewritten = true;
+        }
+        if (rewritten) {
+            optimize_block(func->body);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void ASTOptimizer::optimize(ProgramNode* program) {
+    for (FunctionDefNode* func : program->functions) {
+        optimize_block(func->body);
+    }
+
+    // Each round can expose constant arguments in the rewritten functions
+    std::vector<std::vector<bool>> propagated;
+    for (FunctionDefNode* func : program->functions) {
+        propagated.emplace_back(func->params.size(), false);
+    }
+    while (propagate_constants(program, propagated)) {
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef AST_OPT_H
+#define AST_OPT_H
+
+#include <iostream>
+#include <vector>
+#include "ast.h"
+
+// Counters reported by --opt-stats, one group per pass
+struct ASTOptStats {
+    int constants_folded = 0;       // constant-fold: operator nodes replaced by a literal
+    int identities_simplified = 0;  // simplify: x+0, x*1, x*0, --x, ...
+    int branches_pruned = 0;        // dce: if/while with a constant condition
+    int statements_removed = 0;     // dce: unreachable or side-effect free statements
+    int parameters_propagated = 0;  // ipcp: parameters every caller passes the same constant
+
+    void print(std::ostream& os) const;
+};
+
+// AST rewriting pass run between parsing and code generation. Folds constant
+// expressions using the same wrapping i32 and floored `/` and `%` semantics the
+// generated code has, simplifies algebraic identities and drops dead code.
+// Across functions, parameters that every call site passes the same constant
+// are replaced by that constant in the callee, which is then optimized again.
+class ASTOptimizer {
+private:
+    Arena& arena;   // The program's arena; rewritten nodes are allocated here
+    ASTOptStats stats;
+
+    ExprNode* optimize_expr(ExprNode* expr);
+    ExprNode* fold_binary(BinaryOpNode* node);
+    ExprNode* simplify_binary(ExprNode* expr);
+    ExprNode* optimize_unary(ExprNode* expr);
+    void optimize_block(StmtList& stmts);
+    bool propagate_constants(ProgramNode* program, std::vector<std::vector<bool>>& propagated);
+
+public:
+    ASTOptimizer(Arena& a) : arena(a) {}
+    void optimize(ProgramNode* program);
+    const ASTOptStats& get_stats() const { return stats; }
+};
+
+#endif // AST_OPT_H
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Generate large synthetic pyc programs for compile-time benchmarks.
+
+  gen_source.py functions N  N small functions calling each other
+  gen_source.py nesting N    ifs and whiles nested N levels deep
+  gen_source.py expression N one expression with N terms
+"""
+
+import sys
+
+
+def functions(count):
+    # Arguments are never constant, so the AST optimizer cannot fold the
+    # bodies away. Each function calls the one at about half its index, so
+    # call chains stay short and inlining does not blow up
+    lines = ["def f0(x):", "    return x + 1", ""]
+    for i in range(1, count):
+        lines += ["def f%d(x):" % i,
+                  "    if x %% %d == 0:" % (i % 7 + 2),
+                  "        return f%d(x + %d) %% 1000" % (i // 2, i),
+                  "    return f%d(x * 3) %% 1000 + %d" % (i // 2, i % 10),
+                  ""]
+    lines += ["def main():", "    total = 0"]
+    for i in range(count - 1, max(count - 20, 0) - 1, -1):
+        lines.append("    total = total + f%d(%d)" % (i, i))
+    lines += ["    print(total)", "    return 0", ""]
+    return lines
+
+
+def nesting(depth):
+    lines = ["def nested(a, b):", "    total = 0"]
+    indent = "    "
+    for level in range(depth):
+        if level % 2 == 0:
+            lines.append("%sif a %% %d != b:" % (indent, level + 2))
+        else:
+            lines.append("%swhile total < %d:" % (indent, level * 10))
+        indent += "    "
+        lines.append("%stotal = total + a * %d - b" % (indent, level + 1))
+    lines += ["    return total", "",
+              "def main():", "    i = 0", "    while i < 3:",
+              "        print(nested(i + 7, 3))", "        i = i + 1", "    return 0", ""]
+    return lines
+
+
+def expression(terms):
+    ops = ["+", "-", "*", "%"]
+    parts = ["a"]
+    for i in range(1, terms):
+        op = ops[i % len(ops)]
+        operand = "b" if i % 3 == 0 else str(i % 97 + 1)
+        parts.append("%s %s" % (op, operand))
+    lines = ["def long_expression(a, b):"]
+    # The grammar has no line continuations, so it is one long line
+    lines.append("    return " + " ".join(parts))
+    lines += ["",
+              "def main():", "    i = 0", "    while i < 3:",
+              "        print(long_expression(i + 5, 3))", "        i = i + 1", "    return 0", ""]
+    return lines
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[1] not in ("functions", "nesting", "expression"):
+        sys.stderr.write(__doc__)
+        return 1
+    kind, size = sys.argv[1], int(sys.argv[2])
+    lines = globals()[kind](size)
+    lines += ['if __name__ == "__main__":', "    main()", ""]
+    sys.stdout.write("\n".join(lines))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
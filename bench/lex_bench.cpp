@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "parser.tab.hpp"
+#include "source.h"
+
+// Map and tokenize a file in place repeatedly, as pyc does, and print
+// "bytes tokens seconds" for the fastest pass
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file> [passes]\n", argv[0]);
+        return 1;
+    }
+    int passes = argc > 2 ? atoi(argv[2]) : 5;
+
+    double best = 0;
+    long tokens = 0;
+    size_t bytes = 0;
+    for (int pass = 0; pass < passes; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        SourceBuffer source;
+        if (!source.load_file(argv[1])) {
+            fprintf(stderr, "Could not open %s\n", argv[1]);
+            return 1;
+        }
+        Arena arena;
+        Interner symbols;
+        ParseContext ctx(&arena, &symbols, &std::cerr);
+        yyscan_t scanner;
+        if (begin_scan(source.data(), source.size(), ctx, &scanner) != 0) {
+            return 1;
+        }
+        YYSTYPE yylval;
+        tokens = 0;
+        while (yylex(&yylval, scanner) != 0) {
+            tokens++;
+        }
+        end_scan(scanner);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bytes = source.size();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+    printf("%zu %ld %.6f\n", bytes, tokens, best);
+    return 0;
+}
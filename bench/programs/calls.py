@@ -0,0 +1,23 @@
+def add(a, b):
+    return a + b
+
+def scale(x, k):
+    return x * k % 1000003
+
+def mix(a, b, c, d):
+    return add(scale(a, 3), scale(b, 5)) + add(c, d) % 7
+
+def step(x):
+    return mix(x, x + 1, x + 2, x + 3) % 1000003
+
+def main():
+    total = 0
+    i = 0
+    while i < 300000:
+        total = add(total, step(i)) % 1000003
+        i = i + 1
+    print(total)
+    return 0
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,32 @@
+def sieve(limit):
+    composite = [0] * limit
+    count = 0
+    for n in range(2, len(composite)):
+        if composite[n] == 0:
+            count = count + 1
+            multiple = n + n
+            while multiple < limit:
+                composite[multiple] = 1
+                multiple = multiple + n
+    return count
+
+def prefix_sums(size, rounds):
+    values = [0] * size
+    for i in range(len(values)):
+        values[i] = i % 7
+    checksum = 0
+    r = 0
+    while r < rounds:
+        for i in range(1, len(values)):
+            values[i] = (values[i] + values[i - 1]) % 1000
+        checksum = (checksum + values[size - 1]) % 1000003
+        r = r + 1
+    return checksum
+
+def main():
+    print(sieve(2000000))
+    print(prefix_sums(100000, 50))
+    return 0
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+def count_primes(limit):
+    count = 0
+    n = 2
+    while n < limit:
+        d = 2
+        prime = 1
+        while d * d <= n and prime:
+            if n % d == 0:
+                prime = 0
+            d = d + 1
+        count = count + prime
+        n = n + 1
+    return count
+
+def gcd_sum(limit):
+    total = 0
+    i = 1
+    while i < limit:
+        j = 1
+        while j < limit:
+            a = i
+            b = j
+            while b != 0:
+                t = a % b
+                a = b
+                b = t
+            total = total + a
+            j = j + 1
+        i = i + 1
+    return total
+
+def main():
+    print(count_primes(100000))
+    print(gcd_sum(600))
+    return 0
+
+if __name__ == "__main__":
+    main()
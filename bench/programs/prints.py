@@ -0,0 +1,11 @@
+def main():
+    i = 0
+    x = 1
+    while i < 300000:
+        x = (x * 75 + 74) % 65537
+        print(x * 30011 - 1000000000)
+        i = i + 1
+    return 0
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,17 @@
+def fib(n):
+    if n < 2:
+        return n
+    return fib(n - 1) + fib(n - 2)
+
+def tak(x, y, z):
+    if y < x:
+        return tak(tak(x - 1, y, z), tak(y - 1, z, x), tak(z - 1, x, y))
+    return z
+
+def main():
+    print(fib(30))
+    print(tak(24, 16, 8))
+    return 0
+
+if __name__ == "__main__":
+    main()
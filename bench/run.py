@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Benchmark pyc's compile speed and the speed of the code it generates.
+
+Compiles the programs in bench/programs and generated large sources with
+--time-report=json, times the lexer alone with lex_bench, and runs the
+compiled programs against CPython (checking they print the same). Every
+result is a "<benchmark> <metric> <value>" line, sorted, so runs from two
+commits can be compared with diff.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# Generated sources: (name, gen_source.py kind, size, size with --quick)
+SYNTHETIC = [
+    ("many_functions", "functions", 1000, 100),
+    ("deep_nesting", "nesting", 200, 40),
+    ("long_expression", "expression", 5000, 500),
+]
+
+
+def timed(args, stdout=subprocess.PIPE):
+    start = time.perf_counter()
+    proc = subprocess.run(args, stdout=stdout, stderr=subprocess.PIPE)
+    return time.perf_counter() - start, proc
+
+
+def fail(message):
+    sys.stderr.write("run.py: %s\n" % message)
+    sys.exit(1)
+
+
+def compile_metrics(pyc, source, binary, flags, repeat):
+    """Fastest of repeat compiles: per-phase and end-to-end time, sizes"""
+    results = {}
+    for _ in range(repeat):
+        seconds, proc = timed([pyc, source, "-o", binary, "--time-report=json"] + flags)
+        if proc.returncode != 0:
+            fail("%s failed to compile:\n%s" % (source, proc.stderr.decode()))
+        report = json.loads(proc.stderr.decode().strip().splitlines()[-1])
+        sample = {"compile_ms": seconds * 1000}
+        for phase in report["phases"]:
+            sample["%s_ms" % phase["name"]] = phase["wall_ms"]
+        for key, value in sample.items():
+            results[key] = min(results.get(key, value), value)
+        for key in ("ast_nodes", "functions", "ir_instructions", "ir_bytes"):
+            results[key] = report[key]
+    return results
+
+
+def lexer_metrics(lex_bench, source):
+    proc = subprocess.run([lex_bench, source], stdout=subprocess.PIPE)
+    if proc.returncode != 0:
+        fail("lex_bench failed on %s" % source)
+    size, tokens, seconds = proc.stdout.decode().split()
+    seconds = max(float(seconds), 1e-9)
+    return {"source_bytes": int(size), "tokens": int(tokens),
+            "lex_mb_per_s": int(size) / seconds / 1e6}
+
+
+def run_metrics(command, repeat):
+    best = None
+    output = None
+    for _ in range(repeat):
+        seconds, proc = timed(command)
+        if proc.returncode != 0:
+            fail("%s exited with status %d" % (" ".join(command), proc.returncode))
+        best = seconds if best is None else min(best, seconds)
+        output = proc.stdout
+    return best, output
+
+
+def format_value(value):
+    if isinstance(value, float):
+        return "%.3f" % value
+    return str(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--pyc", default="./pyc", help="compiler to benchmark")
+    parser.add_argument("--lex-bench", default="bench/lex_bench", help="lexer timing driver")
+    parser.add_argument("--python", default="python3", help="CPython to compare against")
+    parser.add_argument("--repeat", type=int, default=3, help="take the fastest of this many runs")
+    parser.add_argument("--flags", default="-O2", help="pyc options for every compile")
+    parser.add_argument("--quick", action="store_true", help="small generated sources")
+    parser.add_argument("--output", help="also write the results to this file")
+    args = parser.parse_args()
+
+    pyc = os.path.abspath(args.pyc)
+    lex_bench = os.path.abspath(args.lex_bench)
+    flags = args.flags.split()
+    work = tempfile.mkdtemp(prefix="pyc-bench-")
+    results = {}
+    try:
+        sources = []
+        for name, kind, size, quick_size in SYNTHETIC:
+            path = os.path.join(work, name + ".py")
+            with open(path, "w") as out:
+                subprocess.run([sys.executable, os.path.join(HERE, "gen_source.py"), kind,
+                                str(quick_size if args.quick else size)], stdout=out, check=True)
+            sources.append((name, path, False))
+        programs = os.path.join(HERE, "programs")
+        for entry in sorted(os.listdir(programs)):
+            if entry.endswith(".py"):
+                sources.append((entry[:-3], os.path.join(programs, entry), True))
+
+        for name, path, run in sources:
+            sys.stderr.write("%s...\n" % name)
+            binary = os.path.join(work, name)
+            metrics = compile_metrics(pyc, path, binary, flags, args.repeat)
+            metrics.update(lexer_metrics(lex_bench, path))
+            if run:
+                native, native_output = run_metrics([binary], args.repeat)
+                cpython, cpython_output = run_metrics([args.python, path], args.repeat)
+                if native_output != cpython_output:
+                    fail("%s prints something different from CPython" % name)
+                metrics["run_ms"] = native * 1000
+                metrics["cpython_ms"] = cpython * 1000
+                metrics["speedup"] = cpython / max(native, 1e-9)
+            results[name] = metrics
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+
+    lines = []
+    for name in sorted(results):
+        for metric in sorted(results[name]):
+            lines.append("%s %s %s" % (name, metric, format_value(results[name][metric])))
+    text = "\n".join(lines) + "\n"
+    sys.stdout.write(text)
+    if args.output:
+        with open(args.output, "w") as out:
+            out.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
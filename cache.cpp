@@ -0,0 +1,283 @@
+#include "cache.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "codegen.h"
+
+// Bump when the key format changes
+static const char* const CACHE_FORMAT = "pyc-cache-1";
+
+static uint64_t hash_bytes(const std::string& data) {
+    // FNV-1a, 64-bit
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string to_hex(uint64_t value) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+static bool read_file(const std::string& path, std::string& data) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    data = contents.str();
+    return true;
+}
+
+// Write to a private temporary name and rename into place, so readers only
+// ever see complete files
+static int write_atomically(const std::string& path, const std::string& data,
+                            std::ostream& errors) {
+    static std::atomic<unsigned> counter(0);
+    std::string temp = path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(counter++);
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out.write(data.data(), data.size());
+        if (!out) {
+            errors << "Error: Could not write cache file " << temp << "\n";
+            remove(temp.c_str());
+            return 1;
+        }
+    }
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        errors << "Error: Could not write cache file " << path << "\n";
+        remove(temp.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+CompileCache::CompileCache(const std::string& dir) : dir(dir), hits(0), misses(0) {}
+
+std::string CompileCache::entry_path(const std::string& key, const char* suffix) const {
+    return dir + "/" + to_hex(hash_bytes(key)) + suffix;
+}
+
+int CompileCache::open(std::ostream& errors) {
+    // mkdir -p
+    for (size_t end = 1; end <= dir.size(); end++) {
+        if (end < dir.size() && dir[end] != '/') continue;
+        std::string prefix = dir.substr(0, end);
+        if (mkdir(prefix.c_str(), 0777) != 0 && errno != EEXIST) {
+            errors << "Error: Could not create cache directory " << prefix << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool CompileCache::lookup(const std::string& key) {
+    // The key file is written last, so a matching key implies the object
+    std::string stored;
+    bool hit = read_file(entry_path(key, ".key"), stored) && stored == key &&
+               access(object_path(key).c_str(), R_OK) == 0;
+    std::lock_guard<std::mutex> guard(stats_lock);
+    if (hit) hits++; else misses++;
+    return hit;
+}
+
+int CompileCache::store(const std::string& key, const std::string& object, std::ostream& errors) {
+    if (write_atomically(object_path(key), object, errors) != 0) return 1;
+    return write_atomically(entry_path(key, ".key"), key, errors);
+}
+
+static std::string read_fingerprint() {
+    std::string executable;
+    if (!read_file("/proc/self/exe", executable)) {
+        return CACHE_FORMAT;
+    }
+    return std::string(CACHE_FORMAT) + " " + to_hex(hash_bytes(executable));
+}
+
+std::string compiler_fingerprint() {
+    // Hashed once per process, however many compiles it runs
+    static const std::string fingerprint = read_fingerprint();
+    return fingerprint;
+}
+
+// Normalized form of the AST: prefix notation with every name spelled out,
+// independent of layout, comments and Symbol numbering
+static void serialize_expr(ExprNode* expr, const Interner& symbols, std::string& out,
+                           std::vector<CallNode*>& calls) {
+    switch (expr->type) {
+        case NodeType::INTEGER:
+            out += "#" + std::to_string(static_cast<IntegerNode*>(expr)->value) + " ";
+            break;
+        case NodeType::IDENTIFIER:
+            out += "$";
+            out += symbols.name(static_cast<IdentifierNode*>(expr)->name);
+            out += " ";
+            break;
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            out += "(b" + std::to_string(static_cast<int>(node->op)) + " ";
+            serialize_expr(node->left, symbols, out, calls);
+            serialize_expr(node->right, symbols, out, calls);
+            out += ")";
+            break;
+        }
+        case NodeType::UNARY_OP: {
+            UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
+            out += "(u" + std::to_string(static_cast<int>(node->op)) + " ";
+            serialize_expr(node->operand, symbols, out, calls);
+            out += ")";
+            break;
+        }
+        case NodeType::CALL: {
+            CallNode* node = static_cast<CallNode*>(expr);
+            calls.push_back(node);
+            out += "(c ";
+            out += symbols.name(node->function_name);
+            out += " ";
+            for (ExprNode* arg : node->args) serialize_expr(arg, symbols, out, calls);
+            out += ")";
+            break;
+        }
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            out += "(list ";
+            serialize_expr(node->value, symbols, out, calls);
+            serialize_expr(node->length, symbols, out, calls);
+            out += ")";
+            break;
+        }
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            out += "([] ";
+            out += symbols.name(node->list_name);
+            out += " ";
+            serialize_expr(node->index, symbols, out, calls);
+            out += ")";
+            break;
+        }
+        case NodeType::LEN:
+            out += "(len ";
+            out += symbols.name(static_cast<LenNode*>(expr)->list_name);
+            out += ")";
+            break;
+        default:
+            out += "(? " + std::to_string(static_cast<int>(expr->type)) + ")";
+            break;
+    }
+}
+
+static void serialize_block(const StmtList& stmts, const Interner& symbols, std::string& out,
+                            std::vector<CallNode*>& calls) {
+    out += "{";
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                out += "(= ";
+                out += symbols.name(node->var_name);
+                out += " ";
+                serialize_expr(node->value, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                out += "([]= ";
+                out += symbols.name(node->list_name);
+                out += " ";
+                serialize_expr(node->index, symbols, out, calls);
+                serialize_expr(node->value, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            case NodeType::RETURN_STMT: {
+                ReturnNode* node = static_cast<ReturnNode*>(stmt);
+                out += "(r ";
+                if (node->value) serialize_expr(node->value, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            case NodeType::EXPR_STMT:
+                out += "(e ";
+                serialize_expr(static_cast<ExprStmtNode*>(stmt)->expr, symbols, out, calls);
+                out += ")";
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                out += "(if ";
+                serialize_expr(node->condition, symbols, out, calls);
+                serialize_block(node->then_block, symbols, out, calls);
+                serialize_block(node->else_block, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                out += "(while ";
+                serialize_expr(node->condition, symbols, out, calls);
+                serialize_block(node->body, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                out += node->parallel ? "(pfor " : "(for ";
+                out += symbols.name(node->var_name);
+                out += " ";
+                serialize_expr(node->start, symbols, out, calls);
+                out += " ";
+                serialize_expr(node->stop, symbols, out, calls);
+                out += " " + std::to_string(node->step);
+                serialize_block(node->body, symbols, out, calls);
+                out += ")";
+                break;
+            }
+            default:
+                out += "(? " + std::to_string(static_cast<int>(stmt->type)) + ")";
+                break;
+        }
+    }
+    out += "}";
+}
+
+std::string function_cache_key(FunctionDefNode* func, const CodeGenerator& codegen,
+                               const std::string& options) {
+    const Interner& symbols = codegen.symbols();
+    std::string key = options + (func->memoize ? "\n(def@ " : "\n(def ");
+    key += symbols.name(func->name);
+    key += " (";
+    for (Symbol param : func->params) {
+        key += symbols.name(param);
+        key += " ";
+    }
+    key += ")";
+    std::vector<CallNode*> calls;
+    serialize_block(func->body, symbols, key, calls);
+    key += ")\n";
+
+    // Callers are compiled against the callee's declaration, so its arity is
+    // part of the key; its body is not
+    for (CallNode* call : calls) {
+        key += symbols.name(call->function_name);
+        key += "/" + std::to_string(codegen.arity(call->function_name)) + "\n";
+    }
+
+    // Profile counts become branch weights and hot/cold attributes
+    const std::vector<uint64_t>* counts = codegen.profile() ? codegen.profile()->function(func->name) : nullptr;
+    if (counts) {
+        key += "profile " + std::to_string(codegen.profile()->max_entry_count());
+        for (uint64_t count : *counts) {
+            key += " " + std::to_string(count);
+        }
+        key += "\n";
+    }
+    return key;
+}
@@ -0,0 +1,47 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include "ast.h"
+
+class CodeGenerator;
+
+// On-disk store of compiled per-function objects for incremental builds.
+// Entries are content addressed: an entry's file name is a hash of its key,
+// and the full key is stored next to the object and compared on lookup, so a
+// hash collision costs a miss rather than a wrong object.
+class CompileCache {
+private:
+    std::string dir;
+    std::mutex stats_lock;
+    unsigned hits;
+    unsigned misses;
+
+    std::string entry_path(const std::string& key, const char* suffix) const;
+
+public:
+    explicit CompileCache(const std::string& dir);
+    // Create the cache directory if it does not exist yet
+    int open(std::ostream& errors);
+    // Where the object for key is (or will be) stored
+    std::string object_path(const std::string& key) const { return entry_path(key, ".o"); }
+    // True if an object for key is present; counts a hit or a miss
+    bool lookup(const std::string& key);
+    // Add an entry; safe against concurrent pyc processes sharing the cache
+    int store(const std::string& key, const std::string& object, std::ostream& errors);
+    unsigned get_hits() const { return hits; }
+    unsigned get_misses() const { return misses; }
+};
+
+// Identifies this pyc build, so that entries written by a different compiler
+// are never reused
+std::string compiler_fingerprint();
+
+// Cache key for func's object: its normalized AST, the signatures of the
+// functions it calls and the backend options it is compiled with
+std::string function_cache_key(FunctionDefNode* func, const CodeGenerator& codegen,
+                               const std::string& options);
+
+#endif // CACHE_H
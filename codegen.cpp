@@ -1,319 +1,576 @@
 #include "codegen.h"
+#include <algorithm>
 #include <iostream>
+#include "parallel.h"
+#include "purity.h"
+#include "thread_pool.h"
 
-CodeGenerator::CodeGenerator() : temp_counter(0), label_counter(0) {}
+FunctionEmitter::FunctionEmitter(const CodegenOptions& options)
+    : symbols(options.symbols), current_block(0), block_terminated(false), function(nullptr),
+      loop_tail_calls(false), tailrecurse(0),
+      print_runtime(options.unbuffered_print ? mir::Runtime::PRINT_UNBUFFERED : mir::Runtime::PRINT),
+      list_arena(false), list_mark(mir::NONE), index_error(mir::NONE),
+      profile_file(options.profile_file), counts(nullptr), counter_count(0), next_site(0),
+      next_loop_id(0), in_parallel_body(false), parallel_counter(0) {}
 
-std::string CodeGenerator::get_temp() {
-    return "%t" + std::to_string(temp_counter++);
+CodeGenerator::CodeGenerator(const CodegenOptions& options) : options(options) {}
+
+// Lists of at most this many ints with a constant length live on the stack
+static const int STACK_LIST_LIMIT = 4096;
+
+// Right operands of and/or of at most this many nodes that cannot fail are
+// evaluated unconditionally, saving a branch and a phi
+static const unsigned SPECULATE_MAX_NODES = 8;
+
+// The predicate a comparison operator tests, if op is one
+static bool comparison_pred(BinaryOp op, mir::Pred* pred) {
+    switch (op) {
+        case BinaryOp::EQ: *pred = mir::Pred::EQ; return true;
+        case BinaryOp::NEQ: *pred = mir::Pred::NE; return true;
+        case BinaryOp::GT: *pred = mir::Pred::SGT; return true;
+        case BinaryOp::LT: *pred = mir::Pred::SLT; return true;
+        case BinaryOp::GTE: *pred = mir::Pred::SGE; return true;
+        case BinaryOp::LTE: *pred = mir::Pred::SLE; return true;
+        default: return false;
+    }
 }
 
-std::string CodeGenerator::get_label() {
-    return "label" + std::to_string(label_counter++);
+// Expressions whose value is a truth value, which codegen_cond computes as
+// an i1 without widening it
+static bool is_condition(ExprNode* expr) {
+    if (expr->type == NodeType::UNARY_OP) return static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NOT;
+    if (expr->type != NodeType::BINARY_OP) return false;
+    BinaryOp op = static_cast<BinaryOpNode*>(expr)->op;
+    mir::Pred pred;
+    return op == BinaryOp::AND || op == BinaryOp::OR || comparison_pred(op, &pred);
 }
 
-void CodeGenerator::declare_function(const std::string& name, const std::vector<std::string>& params) {
-    functions[name] = params;
+// Value of an integer literal, possibly negated
+static bool literal_int(ExprNode* expr, int* value) {
+    if (expr->type == NodeType::INTEGER) {
+        *value = static_cast<IntegerNode*>(expr)->value;
+        return true;
+    }
+    if (expr->type == NodeType::UNARY_OP && static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NEG &&
+        literal_int(static_cast<UnaryOpNode*>(expr)->operand, value)) {
+        *value = static_cast<int>(0u - static_cast<unsigned>(*value));
+        return true;
+    }
+    return false;
 }
 
-std::string CodeGenerator::codegen_expr(ExprNode* expr) {
-    if (!expr) return "";
+// True if some list in stmts is too long or not constant enough for the stack
+static bool needs_list_arena(const StmtList& stmts) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                ExprNode* value = static_cast<AssignNode*>(stmt)->value;
+                int length;
+                if (value->type == NodeType::NEW_LIST &&
+                    (!literal_int(static_cast<NewListNode*>(value)->length, &length) ||
+                     length > STACK_LIST_LIMIT)) {
+                    return true;
+                }
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                if (needs_list_arena(node->then_block) || needs_list_arena(node->else_block)) return true;
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                if (needs_list_arena(static_cast<WhileNode*>(stmt)->body)) return true;
+                break;
+            case NodeType::FOR_RANGE_STMT:
+                if (needs_list_arena(static_cast<ForRangeNode*>(stmt)->body)) return true;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
 
-    switch (expr->type) {
-        case NodeType::INTEGER: {
-            IntegerNode* node = static_cast<IntegerNode*>(expr);
-            return std::to_string(node->value);
+mir::Type FunctionEmitter::slot_type(size_t slot) const {
+    return locals.list_length[slot] >= 0 ? mir::Type::PTR : mir::Type::I32;
+}
+
+// What a slot holds on paths where it was never assigned
+mir::Value FunctionEmitter::undefined_value(size_t slot) {
+    return locals.list_length[slot] >= 0 ? code.constant(0, mir::Type::PTR) : code.constant(0);
+}
+
+// Slot of the list variable name, or -1 after reporting why it is not one
+int FunctionEmitter::lookup_list(Symbol name) {
+    int slot = locals.lookup(name);
+    if (slot < 0 || locals.list_length[slot] < 0) {
+        errors << "Error: " << symbols->name(name) << " is not a list\n";
+        return -1;
+    }
+    if (variables[slot] == mir::NONE) {
+        errors << "Error: undefined variable " << symbols->name(name) << std::endl;
+        return -1;
+    }
+    return slot;
+}
+
+void FunctionEmitter::start_block(uint32_t block) {
+    code.start_block(block);
+    current_block = block;
+    block_terminated = false;
+}
+
+void FunctionEmitter::emit_branch(uint32_t block) {
+    if (block_terminated) return;
+    code.emit(mir::Op::BR, mir::Type::VOID, block);
+    block_terminated = true;
+}
+
+void FunctionEmitter::emit_cond_branch(mir::Value cond, uint32_t taken, uint32_t not_taken,
+                                       const mir::BranchInfo& info) {
+    uint32_t extra = info.has_weights || info.loop_id != mir::NONE ? code.branch_info(info) : mir::NONE;
+    code.emit(mir::Op::BR_COND, mir::Type::VOID, cond, taken, not_taken, extra);
+    block_terminated = true;
+}
+
+mir::Value FunctionEmitter::call_runtime(mir::Runtime callee, mir::Type type,
+                                         std::initializer_list<mir::Value> args) {
+    return code.call(mir::Op::CALL_RUNTIME, type, static_cast<uint32_t>(callee), args.begin(),
+                     static_cast<uint32_t>(args.size()));
+}
+
+// Combine the definition tables flowing into a join block: variables that
+// agree on every edge keep their value, the rest get a phi. A variable that is
+// unassigned on some edge was never defined there, so that edge contributes 0
+// (or a null list).
+void FunctionEmitter::merge_definitions(const std::vector<std::pair<uint32_t, DefTable>>& incoming) {
+    DefTable merged(locals.size(), mir::NONE);
+    std::vector<mir::Value> values(incoming.size());
+    std::vector<std::pair<mir::Value, uint32_t>> edges(incoming.size());
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        bool same = true;
+        bool defined = false;
+        for (size_t i = 0; i < incoming.size(); i++) {
+            mir::Value value = incoming[i].second[slot];
+            defined = defined || value != mir::NONE;
+            values[i] = value == mir::NONE ? undefined_value(slot) : value;
+            if (values[i] != values[0]) same = false;
+        }
+        if (!defined) continue;
+        if (same) {
+            merged[slot] = values[0];
+            continue;
         }
+        for (size_t i = 0; i < incoming.size(); i++) {
+            edges[i] = std::make_pair(values[i], incoming[i].first);
+        }
+        merged[slot] = code.phi(slot_type(slot));
+        code.set_incoming(merged[slot], edges);
+    }
+    variables.swap(merged);
+}
 
-        case NodeType::IDENTIFIER: {
-            IdentifierNode* node = static_cast<IdentifierNode*>(expr);
-            if (variables.find(node->name) == variables.end()) {
-                std::cerr << "Error: undefined variable " << node->name << std::endl;
-                return "0";
+void CodeGenerator::declare_function(Symbol name, const NameList& params) {
+    function_arity[name] = static_cast<int>(params.size());
+}
+
+// True if stmts contain `return func(...)` with a full argument list
+static bool has_self_tail_call(const StmtList& stmts, FunctionDefNode* func) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::RETURN_STMT: {
+                ExprNode* value = static_cast<ReturnNode*>(stmt)->value;
+                if (value->type == NodeType::CALL) {
+                    CallNode* call = static_cast<CallNode*>(value);
+                    if (call->function_name == func->name && call->args.size() == func->params.size()) {
+                        return true;
+                    }
+                }
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                if (has_self_tail_call(node->then_block, func) ||
+                    has_self_tail_call(node->else_block, func)) {
+                    return true;
+                }
+                break;
             }
-            std::string temp = get_temp();
-            output << "  " << temp << " = load i32, i32* %"
-                   << node->name << "\n";
-            return temp;
+            case NodeType::WHILE_STMT:
+                if (has_self_tail_call(static_cast<WhileNode*>(stmt)->body, func)) return true;
+                break;
+            case NodeType::FOR_RANGE_STMT:
+                if (has_self_tail_call(static_cast<ForRangeNode*>(stmt)->body, func)) return true;
+                break;
+            default:
+                break;
         }
+    }
+    return false;
+}
 
-        case NodeType::BINARY_OP: {
-            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+mir::Value FunctionEmitter::emit_call(Symbol callee, const std::vector<mir::Value>& args, uint8_t flags) {
+    return code.call(mir::Op::CALL, mir::Type::I32, callee, args.data(), static_cast<uint32_t>(args.size()),
+                     flags);
+}
 
-            // Handle lazy evaluation for AND and OR
-            if (node->op == BinaryOp::AND) {
-                std::string left = codegen_expr(node->left.get());
-                std::string left_bool = get_temp();
-                output << "  " << left_bool << " = icmp ne i32 " << left << ", 0\n";
-
-                std::string right_label = get_label();
-                std::string end_label = get_label();
-                std::string result_temp = get_temp();
-
-                output << "  br i1 " << left_bool << ", label %" << right_label
-                       << ", label %" << end_label << "\n";
-
-                output << right_label << ":\n";
-                std::string right = codegen_expr(node->right.get());
-                std::string right_bool = get_temp();
-                output << "  " << right_bool << " = icmp ne i32 " << right << ", 0\n";
-                std::string right_int = get_temp();
-                output << "  " << right_int << " = zext i1 " << right_bool << " to i32\n";
-                output << "  br label %" << end_label << "\n";
-
-                output << end_label << ":\n";
-                output << "  " << result_temp << " = phi i32 [ 0, %"
-                       << (label_counter - 3 >= 0 ? "label" + std::to_string(label_counter - 3) : current_function)
-                       << " ], [ " << right_int << ", %" << right_label << " ]\n";
-
-                return result_temp;
-            }
+// `return f(...)`: a self call becomes a branch back to the function's
+// header; any other call reuses the caller's frame. musttail guarantees that
+// but needs matching prototypes, i.e. the same argument count (everything is
+// i32); otherwise the call is only marked tail.
+void FunctionEmitter::codegen_tail_call(CallNode* call) {
+    std::vector<mir::Value> args;
+    for (ExprNode* arg : call->args) {
+        args.push_back(codegen_expr(arg));
+    }
 
-            if (node->op == BinaryOp::OR) {
-                std::string left = codegen_expr(node->left.get());
-                std::string left_bool = get_temp();
-                output << "  " << left_bool << " = icmp ne i32 " << left << ", 0\n";
+    const char* caller = symbols->name(function->name);
+    const char* callee = symbols->name(call->function_name);
+    release_lists();
+    if (loop_tail_calls && call->function_name == function->name &&
+        args.size() == function->params.size()) {
+        tail_sites.push_back(std::make_pair(current_block, args));
+        emit_branch(tailrecurse);
+        notes << "note: " << caller << ": self tail call turned into a loop\n";
+        return;
+    }
 
-                std::string right_label = get_label();
-                std::string end_label = get_label();
-                std::string result_temp = get_temp();
+    bool musttail = args.size() == function->params.size();
+    mir::Value result = emit_call(call->function_name, args, musttail ? mir::MUSTTAIL : mir::TAIL);
+    code.emit(mir::Op::RET, mir::Type::VOID, result);
+    block_terminated = true;
+    notes << "note: " << caller << ": tail call to " << callee << " marked "
+          << (musttail ? "musttail" : "tail") << "\n";
+}
+
+mir::Value FunctionEmitter::codegen_expr(ExprNode* expr) {
+    mir::Value zero = code.constant(0);
+    if (!expr) return zero;
+
+    switch (expr->type) {
+        case NodeType::INTEGER: {
+            IntegerNode* node = static_cast<IntegerNode*>(expr);
+            return code.constant(node->value);
+        }
 
-                output << "  br i1 " << left_bool << ", label %" << end_label
-                       << ", label %" << right_label << "\n";
+        case NodeType::IDENTIFIER: {
+            IdentifierNode* node = static_cast<IdentifierNode*>(expr);
+            int slot = locals.lookup(node->name);
+            if (slot < 0 || variables[slot] == mir::NONE) {
+                errors << "Error: undefined variable " << symbols->name(node->name) << std::endl;
+                return zero;
+            }
+            if (locals.list_length[slot] >= 0) {
+                errors << "Error: list " << symbols->name(node->name)
+                       << " can only be indexed or passed to len()\n";
+                return zero;
+            }
+            return variables[slot];
+        }
 
-                output << right_label << ":\n";
-                std::string right = codegen_expr(node->right.get());
-                std::string right_bool = get_temp();
-                output << "  " << right_bool << " = icmp ne i32 " << right << ", 0\n";
-                std::string right_int = get_temp();
-                output << "  " << right_int << " = zext i1 " << right_bool << " to i32\n";
-                output << "  br label %" << end_label << "\n";
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            mir::Value element = element_pointer(node->list_name, node->index);
+            if (element == mir::NONE) return zero;
+            return code.load(mir::Type::I32, element, mir::ALIGN4);
+        }
 
-                output << end_label << ":\n";
-                output << "  " << result_temp << " = phi i32 [ 1, %"
-                       << (label_counter - 3 >= 0 ? "label" + std::to_string(label_counter - 3) : current_function)
-                       << " ], [ " << right_int << ", %" << right_label << " ]\n";
+        case NodeType::LEN: {
+            int slot = lookup_list(static_cast<LenNode*>(expr)->list_name);
+            if (slot < 0) return zero;
+            return variables[locals.list_length[slot]];
+        }
 
-                return result_temp;
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            // Comparisons and and/or widen their truth value to 0 or 1
+            if (is_condition(expr)) {
+                return code.emit(mir::Op::ZEXT, mir::Type::I32, codegen_cond(expr));
             }
 
             // Regular binary operations
-            std::string left = codegen_expr(node->left.get());
-            std::string right = codegen_expr(node->right.get());
-            std::string result = get_temp();
+            mir::Value left = codegen_expr(node->left);
+            mir::Value right = codegen_expr(node->right);
 
             switch (node->op) {
                 case BinaryOp::ADD:
-                    output << "  " << result << " = add i32 " << left << ", " << right << "\n";
-                    break;
+                    return code.binary(mir::Op::ADD, mir::Type::I32, left, right);
                 case BinaryOp::SUB:
-                    output << "  " << result << " = sub i32 " << left << ", " << right << "\n";
-                    break;
+                    return code.binary(mir::Op::SUB, mir::Type::I32, left, right);
                 case BinaryOp::MUL:
-                    output << "  " << result << " = mul i32 " << left << ", " << right << "\n";
-                    break;
+                    return code.binary(mir::Op::MUL, mir::Type::I32, left, right);
                 case BinaryOp::DIV:
-                    output << "  " << result << " = sdiv i32 " << left << ", " << right << "\n";
-                    break;
-                case BinaryOp::MOD:
-                    output << "  " << result << " = srem i32 " << left << ", " << right << "\n";
-                    break;
-                case BinaryOp::EQ:
-                    output << "  " << result << " = icmp eq i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
-                    }
-                case BinaryOp::NEQ:
-                    output << "  " << result << " = icmp ne i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
-                    }
-                case BinaryOp::GT:
-                    output << "  " << result << " = icmp sgt i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
-                    }
-                case BinaryOp::LT:
-                    output << "  " << result << " = icmp slt i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
-                    }
-                case BinaryOp::GTE:
-                    output << "  " << result << " = icmp sge i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
-                    }
-                case BinaryOp::LTE:
-                    output << "  " << result << " = icmp sle i32 " << left << ", " << right << "\n";
-                    {
-                        std::string int_result = get_temp();
-                        output << "  " << int_result << " = zext i1 " << result << " to i32\n";
-                        return int_result;
+                case BinaryOp::MOD: {
+                    // Python rounds toward negative infinity: when the remainder is
+                    // nonzero and its sign differs from the divisor's, step the
+                    // quotient down by one and move the remainder into range
+                    mir::Value quot = mir::NONE;
+                    if (node->op == BinaryOp::DIV) quot = code.binary(mir::Op::SDIV, mir::Type::I32, left, right);
+                    mir::Value rem = code.binary(mir::Op::SREM, mir::Type::I32, left, right);
+                    mir::Value nonzero = code.icmp(mir::Pred::NE, rem, zero);
+                    mir::Value signs = code.binary(mir::Op::XOR, mir::Type::I32, rem, right);
+                    mir::Value differ = code.icmp(mir::Pred::SLT, signs, zero);
+                    mir::Value adjust = code.binary(mir::Op::AND, mir::Type::I1, nonzero, differ);
+                    if (node->op == BinaryOp::DIV) {
+                        mir::Value step = code.emit(mir::Op::ZEXT, mir::Type::I32, adjust);
+                        return code.binary(mir::Op::SUB, mir::Type::I32, quot, step);
                     }
+                    mir::Value step = code.emit(mir::Op::SELECT, mir::Type::I32, adjust, right, zero);
+                    return code.binary(mir::Op::ADD, mir::Type::I32, rem, step);
+                }
                 default:
-                    break;
+                    return zero;
             }
-            return result;
         }
 
         case NodeType::UNARY_OP: {
             UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
-            std::string operand = codegen_expr(node->operand.get());
-            std::string result = get_temp();
-
-            if (node->op == UnaryOp::NEG) {
-                output << "  " << result << " = sub i32 0, " << operand << "\n";
-            } else if (node->op == UnaryOp::NOT) {
-                std::string bool_val = get_temp();
-                output << "  " << bool_val << " = icmp eq i32 " << operand << ", 0\n";
-                output << "  " << result << " = zext i1 " << bool_val << " to i32\n";
+            if (node->op == UnaryOp::NOT) {
+                return code.emit(mir::Op::ZEXT, mir::Type::I32, codegen_cond(expr));
             }
-            return result;
+            mir::Value operand = codegen_expr(node->operand);
+            return code.binary(mir::Op::SUB, mir::Type::I32, zero, operand);
         }
 
         case NodeType::CALL: {
             CallNode* node = static_cast<CallNode*>(expr);
 
             // Handle print specially
-            if (node->function_name == "print") {
+            if (node->function_name == SYM_PRINT) {
                 if (node->args.size() != 1) {
-                    std::cerr << "Error: print takes exactly one argument\n";
-                    return "0";
+                    errors << "Error: print takes exactly one argument\n";
+                    return zero;
                 }
-                std::string arg = codegen_expr(node->args[0].get());
-                std::string result = get_temp();
-                output << "  " << result << " = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([4 x i8], [4 x i8]* @.str, i32 0, i32 0), i32 " << arg << ")\n";
-                return "0"; // print returns nothing meaningful
+                mir::Value arg = codegen_expr(node->args[0]);
+                call_runtime(print_runtime, mir::Type::VOID, {arg});
+                return zero; // print returns nothing meaningful
             }
 
             // Regular function call
-            std::vector<std::string> arg_regs;
-            for (auto& arg : node->args) {
-                arg_regs.push_back(codegen_expr(arg.get()));
-            }
-
-            std::string result = get_temp();
-            output << "  " << result << " = call i32 @" << node->function_name << "(";
-            for (size_t i = 0; i < arg_regs.size(); i++) {
-                if (i > 0) output << ", ";
-                output << "i32 " << arg_regs[i];
+            std::vector<mir::Value> args;
+            for (ExprNode* arg : node->args) {
+                args.push_back(codegen_expr(arg));
             }
-            output << ")\n";
-            return result;
+            return emit_call(node->function_name, args, 0);
         }
 
         default:
-            return "0";
+            return zero;
     }
 }
 
-void CodeGenerator::codegen_stmt(StmtNode* stmt) {
+// expr as an i1, for branches and for and/or. Comparisons give their icmp
+// directly, rather than an i32 that would be tested against 0 again.
+mir::Value FunctionEmitter::codegen_cond(ExprNode* expr) {
+    if (expr && expr->type == NodeType::UNARY_OP && static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NOT) {
+        ExprNode* operand = static_cast<UnaryOpNode*>(expr)->operand;
+        if (!is_condition(operand)) {
+            return code.icmp(mir::Pred::EQ, codegen_expr(operand), code.constant(0));
+        }
+        return code.binary(mir::Op::XOR, mir::Type::I1, codegen_cond(operand), code.constant(1, mir::Type::I1));
+    }
+    if (!expr || expr->type != NodeType::BINARY_OP) {
+        return code.icmp(mir::Pred::NE, codegen_expr(expr), code.constant(0));
+    }
+
+    BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+    mir::Pred pred;
+    if (comparison_pred(node->op, &pred)) {
+        mir::Value left = codegen_expr(node->left);
+        mir::Value right = codegen_expr(node->right);
+        return code.icmp(pred, left, right);
+    }
+    if (node->op != BinaryOp::AND && node->op != BinaryOp::OR) {
+        return code.icmp(mir::Pred::NE, codegen_expr(expr), code.constant(0));
+    }
+
+    bool is_and = node->op == BinaryOp::AND;
+    mir::Value left_bool = codegen_cond(node->left);
+    // Evaluating a right operand that cannot fail or have an effect is
+    // invisible, so it needs no branch of its own
+    if (is_speculatable(node->right, SPECULATE_MAX_NODES)) {
+        mir::Value right_bool = codegen_cond(node->right);
+        return code.binary(is_and ? mir::Op::AND : mir::Op::OR, mir::Type::I1, left_bool, right_bool);
+    }
+
+    // Otherwise the right operand is only evaluated when the left one does
+    // not decide the result
+    uint32_t right_block = code.new_block();
+    uint32_t end_block = code.new_block();
+    uint32_t left_block = current_block;
+    if (is_and) {
+        emit_cond_branch(left_bool, right_block, end_block);
+    } else {
+        emit_cond_branch(left_bool, end_block, right_block);
+    }
+
+    start_block(right_block);
+    mir::Value right_bool = codegen_cond(node->right);
+    uint32_t right_end = current_block;
+    emit_branch(end_block);
+
+    start_block(end_block);
+    mir::Value result = code.phi(mir::Type::I1);
+    code.set_incoming(result, {{code.constant(is_and ? 0 : 1, mir::Type::I1), left_block}, {right_bool, right_end}});
+    return result;
+}
+
+void FunctionEmitter::codegen_stmt(StmtNode* stmt) {
     if (!stmt) return;
 
     switch (stmt->type) {
         case NodeType::ASSIGN: {
             AssignNode* node = static_cast<AssignNode*>(stmt);
-            if (variables.find(node->var_name) == variables.end()) {
-                // Allocate variable on first use
-                variables[node->var_name] = 1;
-                output << "  %" << node->var_name << " = alloca i32\n";
+            int slot = locals.lookup(node->var_name);
+            if (node->value->type == NodeType::NEW_LIST) {
+                if (locals.list_length[slot] >= 0) {
+                    codegen_new_list(static_cast<NewListNode*>(node->value), slot);
+                }
+                break;
+            }
+            if (locals.list_length[slot] >= 0) {
+                errors << "Error: list " << symbols->name(node->var_name)
+                       << " can only be assigned a new list\n";
+                break;
+            }
+            // Assignment just rebinds the name to the value's SSA register
+            variables[slot] = codegen_expr(node->value);
+            break;
+        }
+
+        case NodeType::INDEX_ASSIGN: {
+            IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+            // Python evaluates the value before the target
+            mir::Value value = codegen_expr(node->value);
+            mir::Value element = element_pointer(node->list_name, node->index);
+            if (element != mir::NONE) {
+                code.store(value, element, mir::ALIGN4);
             }
-            std::string value = codegen_expr(node->value.get());
-            output << "  store i32 " << value << ", i32* %" << node->var_name << "\n";
             break;
         }
 
         case NodeType::RETURN_STMT: {
             ReturnNode* node = static_cast<ReturnNode*>(stmt);
-            std::string value = codegen_expr(node->value.get());
-            output << "  ret i32 " << value << "\n";
+            if (in_parallel_body) {
+                errors << "Error: return inside a prange loop\n";
+                break;
+            }
+            if (node->value->type == NodeType::CALL &&
+                static_cast<CallNode*>(node->value)->function_name != SYM_PRINT) {
+                codegen_tail_call(static_cast<CallNode*>(node->value));
+                break;
+            }
+            mir::Value value = codegen_expr(node->value);
+            release_lists();
+            code.emit(mir::Op::RET, mir::Type::VOID, value);
+            block_terminated = true;
             break;
         }
 
         case NodeType::IF_STMT: {
             IfNode* node = static_cast<IfNode*>(stmt);
-            std::string cond = codegen_expr(node->condition.get());
-            std::string cond_bool = get_temp();
-            output << "  " << cond_bool << " = icmp ne i32 " << cond << ", 0\n";
+            mir::Value cond_bool = codegen_cond(node->condition);
+
+            uint32_t then_block = code.new_block();
+            uint32_t else_block = node->else_block.empty() ? mir::NONE : code.new_block();
+            uint32_t end_block = code.new_block();
 
-            std::string then_label = get_label();
-            std::string else_label = get_label();
-            std::string end_label = get_label();
+            DefTable entry_defs = variables;
+            std::vector<std::pair<uint32_t, DefTable>> incoming;
 
+            mir::BranchInfo weights = branch_site(next_site++, cond_bool);
             if (node->else_block.empty()) {
-                output << "  br i1 " << cond_bool << ", label %" << then_label
-                       << ", label %" << end_label << "\n";
+                incoming.push_back(std::make_pair(current_block, entry_defs));
+                emit_cond_branch(cond_bool, then_block, end_block, weights);
             } else {
-                output << "  br i1 " << cond_bool << ", label %" << then_label
-                       << ", label %" << else_label << "\n";
+                emit_cond_branch(cond_bool, then_block, else_block, weights);
             }
 
-            output << then_label << ":\n";
-            bool then_has_return = false;
-            for (auto& s : node->then_block) {
-                if (s->type == NodeType::RETURN_STMT) then_has_return = true;
-                codegen_stmt(s.get());
-            }
-            if (!then_has_return) {
-                output << "  br label %" << end_label << "\n";
+            start_block(then_block);
+            codegen_block(node->then_block);
+            if (!block_terminated) {
+                incoming.push_back(std::make_pair(current_block, variables));
+                emit_branch(end_block);
             }
 
-            bool else_has_return = false;
             if (!node->else_block.empty()) {
-                output << else_label << ":\n";
-                for (auto& s : node->else_block) {
-                    if (s->type == NodeType::RETURN_STMT) else_has_return = true;
-                    codegen_stmt(s.get());
-                }
-                if (!else_has_return) {
-                    output << "  br label %" << end_label << "\n";
+                variables = entry_defs;
+                start_block(else_block);
+                codegen_block(node->else_block);
+                if (!block_terminated) {
+                    incoming.push_back(std::make_pair(current_block, variables));
+                    emit_branch(end_block);
                 }
             }
 
-            // Only emit end label if at least one branch reaches it
-            if (!then_has_return || !else_has_return) {
-                output << end_label << ":\n";
+            // Only start the end block if at least one branch reaches it
+            if (incoming.empty()) {
+                block_terminated = true;
+                break;
             }
+            start_block(end_block);
+            merge_definitions(incoming);
             break;
         }
 
         case NodeType::WHILE_STMT: {
             WhileNode* node = static_cast<WhileNode*>(stmt);
-            std::string cond_label = get_label();
-            std::string body_label = get_label();
-            std::string end_label = get_label();
-
-            output << "  br label %" << cond_label << "\n";
-            output << cond_label << ":\n";
-
-            std::string cond = codegen_expr(node->condition.get());
-            std::string cond_bool = get_temp();
-            output << "  " << cond_bool << " = icmp ne i32 " << cond << ", 0\n";
-            output << "  br i1 " << cond_bool << ", label %" << body_label
-                   << ", label %" << end_label << "\n";
-
-            output << body_label << ":\n";
-            for (auto& s : node->body) {
-                codegen_stmt(s.get());
+            uint32_t cond_block = code.new_block();
+            uint32_t body_block = code.new_block();
+            uint32_t end_block = code.new_block();
+
+            // Every variable the body assigns gets a phi in the loop header.
+            // The back-edge values are only known once the body is emitted,
+            // so the phis are made empty and given their incoming values then.
+            std::vector<bool> assigned(locals.size(), false);
+            locals.collect_assigned(node->body, assigned);
+
+            uint32_t preheader = current_block;
+            DefTable entry_defs = variables;
+            emit_branch(cond_block);
+
+            start_block(cond_block);
+            for (size_t slot = 0; slot < locals.size(); slot++) {
+                if (assigned[slot]) variables[slot] = code.phi(slot_type(slot));
             }
-            output << "  br label %" << cond_label << "\n";
+            DefTable phis = variables;
+
+            mir::Value cond_bool = codegen_cond(node->condition);
+            mir::BranchInfo weights = branch_site(next_site++, cond_bool);
+            emit_cond_branch(cond_bool, body_block, end_block, weights);
+            DefTable header_defs = variables;
+
+            start_block(body_block);
+            codegen_block(node->body);
+            uint32_t latch = current_block;
+            DefTable latch_defs = variables;
+            bool has_backedge = !block_terminated;
+            emit_branch(cond_block);
 
-            output << end_label << ":\n";
+            for (size_t slot = 0; slot < locals.size(); slot++) {
+                if (!assigned[slot]) continue;
+                mir::Value init = entry_defs[slot];
+                std::vector<std::pair<mir::Value, uint32_t>> edges;
+                edges.push_back(std::make_pair(init == mir::NONE ? undefined_value(slot) : init, preheader));
+                if (has_backedge) edges.push_back(std::make_pair(latch_defs[slot], latch));
+                code.set_incoming(phis[slot], edges);
+            }
+
+            // The loop exits from the header, so the header's definitions are live after it
+            variables = header_defs;
+            start_block(end_block);
+            break;
+        }
+
+        case NodeType::FOR_RANGE_STMT: {
+            ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+            codegen_for_range(node);
             break;
         }
 
         case NodeType::EXPR_STMT: {
             ExprStmtNode* node = static_cast<ExprStmtNode*>(stmt);
-            codegen_expr(node->expr.get());
+            codegen_expr(node->expr);
             break;
         }
 
@@ -322,49 +579,929 @@ void CodeGenerator::codegen_stmt(StmtNode* stmt) {
     }
 }
 
-void CodeGenerator::codegen_function(FunctionDefNode* func) {
-    variables.clear();
-    current_function = func->name;
+// A counted loop in rotated form: the preheader computes the trip count and
+// skips empty ranges, and the body starts with a single induction phi
+// counting iterations from 0 up to the trip count, from which the loop
+// variable is derived. The range is evaluated once, like Python's.
+void FunctionEmitter::codegen_for_range(ForRangeNode* node) {
+    if (node->parallel && !in_parallel_body) {
+        codegen_parallel_for(node);
+        return;
+    }
+    int var_slot = locals.lookup(node->var_name);
+    if (locals.list_length[var_slot] >= 0) {
+        errors << "Error: loop variable " << symbols->name(node->var_name) << " holds a list\n";
+        return;
+    }
+    mir::Value start = codegen_expr(node->start);
+    mir::Value stop = codegen_expr(node->stop);
+    mir::Value nonempty;
+    mir::Value trip = emit_trip_count(node->step, start, stop, nonempty);
+    emit_counted_loop(node, start, code.constant(0), trip, nonempty, next_site++);
+}
+
+// Iterations of range(start, stop, step), as an unsigned count: |stop - start|
+// rounded up to whole steps. Only meaningful where nonempty is true.
+mir::Value FunctionEmitter::emit_trip_count(int step, mir::Value start, mir::Value stop, mir::Value& nonempty) {
+    bool up = step > 0;
+    uint32_t magnitude = up ? static_cast<uint32_t>(step) : 0u - static_cast<uint32_t>(step);
+    nonempty = code.icmp(up ? mir::Pred::SLT : mir::Pred::SGT, start, stop);
+    mir::Value span = code.binary(mir::Op::SUB, mir::Type::I32, up ? stop : start, up ? start : stop);
+    if (magnitude == 1) return span;
+    mir::Value one = code.constant(1);
+    mir::Value last = code.binary(mir::Op::SUB, mir::Type::I32, span, one);
+    mir::Value steps = code.binary(mir::Op::UDIV, mir::Type::I32, last, code.constant(magnitude));
+    return code.binary(mir::Op::ADD, mir::Type::I32, steps, one);
+}
+
+// The loop itself, running iterations first up to (not including) trip. It is
+// entered when guard is true, or always if there is no guard (mir::NONE).
+void FunctionEmitter::emit_counted_loop(ForRangeNode* node, mir::Value start, mir::Value first,
+                                        mir::Value trip, mir::Value guard, size_t site) {
+    uint32_t body_block = code.new_block();
+    uint32_t end_block = code.new_block();
+    int var_slot = locals.lookup(node->var_name);
+    bool up = node->step > 0;
+    uint32_t magnitude = up ? static_cast<uint32_t>(node->step) : 0u - static_cast<uint32_t>(node->step);
+    uint32_t preheader = current_block;
+    DefTable entry_defs = variables;
+    if (guard == mir::NONE) {
+        emit_branch(body_block);
+    } else {
+        emit_cond_branch(guard, body_block, end_block);
+    }
+
+    // As for while loops, the header phis get their incoming values once the
+    // body is done
+    std::vector<bool> assigned(locals.size(), false);
+    locals.collect_assigned(node->body, assigned);
+    int in_range = assigned[var_slot] ? -1 : in_range_list(node, assigned);
+    assigned[var_slot] = false;
+
+    start_block(body_block);
+    mir::Value index = code.phi(mir::Type::I32);
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        if (assigned[slot]) variables[slot] = code.phi(slot_type(slot));
+    }
+    DefTable phis = variables;
+    mir::Value value;
+    if (magnitude == 1) {
+        value = code.binary(up ? mir::Op::ADD : mir::Op::SUB, mir::Type::I32, start, index);
+    } else {
+        mir::Value offset = code.binary(mir::Op::MUL, mir::Type::I32, index, code.constant(node->step));
+        value = code.binary(mir::Op::ADD, mir::Type::I32, start, offset);
+    }
+    variables[var_slot] = value;
+
+    if (in_range >= 0) in_range_indices.push_back(std::make_pair(var_slot, in_range));
+    codegen_block(node->body);
+    if (in_range >= 0) in_range_indices.pop_back();
+    uint32_t latch = current_block;
+    DefTable latch_defs = variables;
+    bool has_backedge = !block_terminated;
+    std::vector<std::pair<mir::Value, uint32_t>> edges;
+    edges.push_back(std::make_pair(first, preheader));
+    if (has_backedge) {
+        mir::Value next_index = code.binary(mir::Op::ADD, mir::Type::I32, index, code.constant(1), mir::NUW);
+        mir::Value more = code.icmp(mir::Pred::ULT, next_index, trip);
+        mir::BranchInfo info = branch_site(site, more);
+        info.loop_id = next_loop_id++;
+        emit_cond_branch(more, body_block, end_block, info);
+        loop_metadata += "!" + std::to_string(info.loop_id) + " = distinct !{!" + std::to_string(info.loop_id) +
+                         ", !{!\"llvm.loop.mustprogress\"}}\n";
+        edges.push_back(std::make_pair(next_index, latch));
+    } else {
+        next_loop_id++;
+    }
+    code.set_incoming(index, edges);
+
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        if (!assigned[slot]) continue;
+        mir::Value init = entry_defs[slot];
+        edges.clear();
+        edges.push_back(std::make_pair(init == mir::NONE ? undefined_value(slot) : init, preheader));
+        if (has_backedge) edges.push_back(std::make_pair(latch_defs[slot], latch));
+        code.set_incoming(phis[slot], edges);
+    }
+
+    // The loop is left from the preheader or the latch
+    std::vector<std::pair<uint32_t, DefTable>> incoming;
+    if (guard != mir::NONE) incoming.push_back(std::make_pair(preheader, entry_defs));
+    if (has_backedge) incoming.push_back(std::make_pair(latch, latch_defs));
+    start_block(end_block);
+    if (incoming.empty()) {
+        block_terminated = true;
+        return;
+    }
+    merge_definitions(incoming);
+}
+
+// A prange loop (see parallel.h). The inputs are passed in by value. Each
+// chunk accumulates its own partial result of a reduction from 0 (or 1),
+// which the runtime's threads combine atomically, and the total is applied to
+// the variable's value from before the loop; wrapping arithmetic makes that
+// exact in any order. Private variables keep their value from before the
+// loop, the loop variable included.
+void FunctionEmitter::codegen_parallel_for(ForRangeNode* node) {
+    int var_slot = locals.lookup(node->var_name);
+    if (locals.list_length[var_slot] >= 0) {
+        errors << "Error: loop variable " << symbols->name(node->var_name) << " holds a list\n";
+        return;
+    }
+    mir::Value start = codegen_expr(node->start);
+    mir::Value stop = codegen_expr(node->stop);
+    mir::Value nonempty;
+    mir::Value trip = emit_trip_count(node->step, start, stop, nonempty);
+    size_t site = next_site++;
+
+    ParallelLoop loop = analyze_parallel_loop(node, symbols->size());
+    auto report_carried = [&](Symbol name) {
+        errors << "Error: a prange loop in " << symbols->name(function->name) << " reads "
+               << symbols->name(name) << " before assigning it; its iterations only share "
+               << "reductions and the variables they do not assign\n";
+    };
+    if (!loop.carried.empty()) {
+        report_carried(loop.carried[0]);
+        return;
+    }
+
+    // The struct holds the loop's start, its inputs, then the accumulators.
+    // Inputs not defined here are reported as undefined by the body.
+    std::vector<int> inputs;
+    std::vector<std::pair<int, BinaryOp>> reductions;
+    std::vector<mir::Type> layout(1, mir::Type::I32);
+    for (Symbol input : loop.inputs) {
+        int slot = locals.lookup(input);
+        if (slot < 0 || variables[slot] == mir::NONE) continue;
+        inputs.push_back(slot);
+        if (locals.list_length[slot] >= 0) inputs.push_back(locals.list_length[slot]);
+    }
+    for (int slot : inputs) {
+        layout.push_back(slot_type(slot));
+    }
+    for (const auto& reduction : loop.reductions) {
+        int slot = locals.lookup(reduction.first);
+        if (variables[slot] == mir::NONE) {
+            report_carried(reduction.first);
+            return;
+        }
+        reductions.push_back(std::make_pair(slot, reduction.second));
+        layout.push_back(mir::Type::I32);
+    }
+
+    std::string name = std::string(symbols->name(function->name)) + ".prange" + std::to_string(parallel_counter++);
+    uint32_t env_layout = static_cast<uint32_t>(code.layouts.size());
+    code.layouts.push_back(layout);
+    mir::Value env = code.slot(true, env_layout);
+    auto field = [&](uint32_t index) {
+        mir::Type pointer = layout[index] == mir::Type::PTR ? mir::Type::PTR_PTR : mir::Type::PTR;
+        return code.emit(mir::Op::FIELD, pointer, env, env_layout, index);
+    };
+    code.store(start, field(0));
+    for (size_t i = 0; i < inputs.size(); i++) {
+        code.store(variables[inputs[i]], field(1 + i));
+    }
+    for (size_t i = 0; i < reductions.size(); i++) {
+        code.store(code.constant(reductions[i].second == BinaryOp::MUL ? 1 : 0), field(1 + inputs.size() + i));
+    }
+
+    FunctionEmitter body_emitter;
+    body_emitter.emit_parallel_body(*this, node, name, layout, inputs, reductions, site);
+    next_site = body_emitter.next_site;
+    next_loop_id = body_emitter.next_loop_id;
+    loop_metadata += body_emitter.loop_metadata;
+    mir::print(body_emitter.code, *symbols, parallel_functions);
+    errors << body_emitter.errors.str();
+
+    mir::Value env_bytes = code.emit(mir::Op::BITCAST, mir::Type::BYTES, env);
+    mir::Value count = code.emit(mir::Op::SELECT, mir::Type::I32, nonempty, trip, code.constant(0));
+    call_runtime(mir::Runtime::PARALLEL_FOR, mir::Type::VOID, {code.global(name), env_bytes, count});
+    for (size_t i = 0; i < reductions.size(); i++) {
+        int slot = reductions[i].first;
+        mir::Value total = code.load(mir::Type::I32, field(1 + inputs.size() + i));
+        mir::Op combine = reductions[i].second == BinaryOp::MUL ? mir::Op::MUL : mir::Op::ADD;
+        variables[slot] = code.binary(combine, mir::Type::I32, variables[slot], total);
+    }
+}
+
+// The function running iterations [begin, end) of a prange loop for parent,
+// left in code. The body sees the parent's slots, with the inputs loaded from
+// the struct and the reductions starting from their identity.
+void FunctionEmitter::emit_parallel_body(const FunctionEmitter& parent, ForRangeNode* node,
+                                         const std::string& name, const std::vector<mir::Type>& layout,
+                                         const std::vector<int>& inputs,
+                                         const std::vector<std::pair<int, BinaryOp>>& reductions,
+                                         size_t site) {
+    function = parent.function;
+    symbols = parent.symbols;
+    locals = parent.locals;
+    print_runtime = parent.print_runtime;
+    profile_file = parent.profile_file;
+    counts = parent.counts;
+    counter_count = parent.counter_count;
+    next_site = parent.next_site;
+    next_loop_id = parent.next_loop_id;
+    list_arena = needs_list_arena(node->body);
+    in_parallel_body = true;
+    variables.assign(locals.size(), mir::NONE);
+
+    code.clear();
+    code.prefix = "define internal void @" + name;
+    code.params.push_back(mir::Param{"%env", mir::Type::BYTES});
+    code.params.push_back(mir::Param{"%begin", mir::Type::I32});
+    code.params.push_back(mir::Param{"%end", mir::Type::I32});
+    code.counters = parent.code.counters;
+    code.counter_count = parent.code.counter_count;
+    code.layouts.push_back(layout);
+    start_block(code.new_block());
+    if (list_arena) list_mark = call_runtime(mir::Runtime::ARENA_SAVE, mir::Type::BYTES, {});
+    mir::Value frame = code.emit(mir::Op::BITCAST, mir::Type::ENV, code.param(0), 0);
+    auto field = [&](uint32_t index) {
+        mir::Type pointer = layout[index] == mir::Type::PTR ? mir::Type::PTR_PTR : mir::Type::PTR;
+        return code.emit(mir::Op::FIELD, pointer, frame, 0, index);
+    };
+    mir::Value start = code.load(mir::Type::I32, field(0));
+    for (size_t i = 0; i < inputs.size(); i++) {
+        variables[inputs[i]] = code.load(slot_type(inputs[i]), field(1 + i));
+    }
+    for (const auto& reduction : reductions) {
+        variables[reduction.first] = code.constant(reduction.second == BinaryOp::MUL ? 1 : 0);
+    }
+
+    // The runtime only passes nonempty ranges
+    emit_counted_loop(node, start, code.param(1), code.param(2), mir::NONE, site);
+
+    if (!block_terminated) {
+        for (size_t i = 0; i < reductions.size(); i++) {
+            mir::Value total = field(1 + inputs.size() + i);
+            mir::Value partial = variables[reductions[i].first];
+            if (reductions[i].second == BinaryOp::ADD) {
+                code.emit(mir::Op::ATOMIC_ADD, mir::Type::VOID, total, partial);
+                continue;
+            }
+            uint32_t before = current_block;
+            uint32_t retry = code.new_block();
+            uint32_t done = code.new_block();
+            mir::Value initial = code.load(mir::Type::I32, total);
+            emit_branch(retry);
+            start_block(retry);
+            mir::Value seen = code.phi(mir::Type::I32);
+            mir::Value product = code.binary(mir::Op::MUL, mir::Type::I32, seen, partial);
+            mir::Value exchange = code.emit(mir::Op::CMPXCHG, mir::Type::PAIR, total, seen, product);
+            mir::Value current = code.emit(mir::Op::EXTRACT, mir::Type::I32, exchange, 0);
+            mir::Value stored = code.emit(mir::Op::EXTRACT, mir::Type::I1, exchange, 1);
+            emit_cond_branch(stored, done, retry);
+            code.set_incoming(seen, {{initial, before}, {current, retry}});
+            start_block(done);
+        }
+        release_lists();
+        code.emit(mir::Op::RET, mir::Type::VOID);
+    }
+    finish_function();
+}
+
+// The list a for loop's variable always indexes in range, or -1. That holds
+// for range(c, len(a), step) with c >= 0 and step > 0, and for
+// range(len(a) - c, s, step) with c >= 1, s >= -1 and step < 0, when the body
+// assigns neither the variable (checked by the caller) nor the list.
+int FunctionEmitter::in_range_list(ForRangeNode* node, const std::vector<bool>& assigned) {
+    bool up = node->step > 0;
+    ExprNode* bound = up ? node->stop : node->start;
+    int limit;
+    if (!literal_int(up ? node->start : node->stop, &limit) || limit < (up ? 0 : -1)) return -1;
+    if (!up) {
+        int offset;
+        if (bound->type != NodeType::BINARY_OP) return -1;
+        BinaryOpNode* difference = static_cast<BinaryOpNode*>(bound);
+        if (difference->op != BinaryOp::SUB || !literal_int(difference->right, &offset) || offset < 1) {
+            return -1;
+        }
+        bound = difference->left;
+    }
+    if (bound->type != NodeType::LEN) return -1;
+    int list = locals.lookup(static_cast<LenNode*>(bound)->list_name);
+    if (list < 0 || locals.list_length[list] < 0 || assigned[list]) return -1;
+    return list;
+}
+
+// [value] * length, evaluated in that order; a negative length makes an
+// empty list. The fill loop becomes a memset where LLVM can make it one.
+void FunctionEmitter::codegen_new_list(NewListNode* node, int slot) {
+    mir::Value value = codegen_expr(node->value);
+    mir::Value zero = code.constant(0);
+    mir::Value length;
+    mir::Value data = mir::NONE;
+    int constant;
+    if (literal_int(node->length, &constant)) {
+        constant = std::max(constant, 0);
+        length = code.constant(constant);
+        if (constant <= STACK_LIST_LIMIT) {
+            mir::Value buffer = code.slot(false, static_cast<uint32_t>(std::max(constant, 1)));
+            data = code.emit(mir::Op::ARRAY, mir::Type::PTR, buffer);
+        }
+    } else {
+        mir::Value count = codegen_expr(node->length);
+        mir::Value negative = code.icmp(mir::Pred::SLT, count, zero);
+        length = code.emit(mir::Op::SELECT, mir::Type::I32, negative, zero, count);
+    }
+    if (data == mir::NONE) {
+        data = call_runtime(mir::Runtime::LIST_ALLOC, mir::Type::PTR, {length});
+    }
+
+    uint32_t fill_block = code.new_block();
+    uint32_t done_block = code.new_block();
+    uint32_t preheader = current_block;
+    mir::Value nonempty = code.icmp(mir::Pred::SGT, length, zero);
+    emit_cond_branch(nonempty, fill_block, done_block);
+    start_block(fill_block);
+    mir::Value position = code.phi(mir::Type::I32);
+    mir::Value offset = code.emit(mir::Op::ZEXT, mir::Type::I64, position);
+    mir::Value element = code.emit(mir::Op::ELEMENT, mir::Type::PTR, data, offset);
+    code.store(value, element, mir::ALIGN4);
+    mir::Value next = code.binary(mir::Op::ADD, mir::Type::I32, position, code.constant(1), mir::NUW | mir::NSW);
+    mir::Value more = code.icmp(mir::Pred::SLT, next, length);
+    emit_cond_branch(more, fill_block, done_block);
+    code.set_incoming(position, {{zero, preheader}, {next, fill_block}});
+    start_block(done_block);
+
+    variables[slot] = data;
+    variables[locals.list_length[slot]] = length;
+}
+
+// Address of list[index], or mir::NONE. A negative index counts from the end,
+// and an index still out of range branches to the function's shared error
+// block; loop variables known to be in range skip both.
+mir::Value FunctionEmitter::element_pointer(Symbol list, ExprNode* index) {
+    int slot = lookup_list(list);
+    if (slot < 0) return mir::NONE;
+    mir::Value position = codegen_expr(index);
+
+    bool in_range = false;
+    if (index->type == NodeType::IDENTIFIER) {
+        int var = locals.lookup(static_cast<IdentifierNode*>(index)->name);
+        for (const auto& known : in_range_indices) {
+            if (known.first == var && known.second == slot) in_range = true;
+        }
+    }
+    if (!in_range) {
+        mir::Value length = variables[locals.list_length[slot]];
+        mir::Value negative = code.icmp(mir::Pred::SLT, position, code.constant(0));
+        mir::Value wrapped = code.binary(mir::Op::ADD, mir::Type::I32, position, length);
+        mir::Value normalized = code.emit(mir::Op::SELECT, mir::Type::I32, negative, wrapped, position);
+        mir::Value valid = code.icmp(mir::Pred::ULT, normalized, length);
+        if (index_error == mir::NONE) index_error = code.new_block();
+        uint32_t checked = code.new_block();
+        emit_cond_branch(valid, checked, index_error);
+        start_block(checked);
+        position = normalized;
+    }
+
+    // The index is known to be nonnegative here
+    mir::Value offset = code.emit(mir::Op::ZEXT, mir::Type::I64, position);
+    return code.emit(mir::Op::ELEMENT, mir::Type::PTR, variables[slot], offset);
+}
+
+// Give back the arena memory of the function's lists, before it returns
+void FunctionEmitter::release_lists() {
+    if (list_arena) {
+        call_runtime(mir::Runtime::ARENA_RESTORE, mir::Type::VOID, {list_mark});
+    }
+}
+
+// Add the shared index error block, if anything branches to it, and close
+// the function
+void FunctionEmitter::finish_function() {
+    if (index_error != mir::NONE) {
+        start_block(index_error);
+        call_runtime(mir::Runtime::INDEX_ERROR, mir::Type::VOID, {});
+        code.emit(mir::Op::UNREACHABLE, mir::Type::VOID);
+    }
+    code.finish();
+}
+
+void FunctionEmitter::codegen_block(const StmtList& stmts) {
+    for (StmtNode* s : stmts) {
+        // Statements after a return are unreachable, but keep their profile
+        // counters numbered
+        if (block_terminated) {
+            next_site += profile_site_count(s);
+            continue;
+        }
+        codegen_stmt(s);
+    }
+}
+
+void FunctionEmitter::increment_counter(size_t index, mir::Value amount) {
+    code.emit(mir::Op::COUNT, mir::Type::VOID, static_cast<uint32_t>(index), amount);
+}
+
+// Count the branch on cond_bool at profile site site when instrumenting;
+// returns the branch's weights when a profile is applied
+mir::BranchInfo FunctionEmitter::branch_site(size_t site, mir::Value cond_bool) {
+    mir::BranchInfo info = {0, 0, 0, mir::NONE};
+    if (!profile_file.empty()) {
+        increment_counter(1 + 2 * site, code.constant(1, mir::Type::I64));
+        mir::Value taken = code.emit(mir::Op::ZEXT, mir::Type::I64, cond_bool);
+        increment_counter(2 + 2 * site, taken);
+    }
+    if (!counts) return info;
+
+    uint64_t executed = (*counts)[1 + 2 * site];
+    uint64_t taken = std::min((*counts)[2 + 2 * site], executed);
+    if (executed == 0) return info;
+    // Weights are 32-bit; only their ratio matters
+    uint64_t scale = executed / UINT32_MAX + 1;
+    info.has_weights = 1;
+    info.taken = static_cast<uint32_t>(taken / scale);
+    info.not_taken = static_cast<uint32_t>((executed - taken) / scale);
+    return info;
+}
+
+// The counters and the record that registers them with the runtime, lowered
+// as a constructor, name.prof.init, listed in the module's llvm.global_ctors
+void FunctionEmitter::emit_profile_record(FunctionDefNode* func) {
+    std::string name = symbols->name(func->name);
+    code.clear();
+    code.prefix = "define internal void @" + name + ".prof.init";
+    mir::Value file = code.global(mir::Global{name + ".prof.file", mir::GlobalKind::STRING, 0, profile_file, {}});
+    mir::Value function_name = code.global(mir::Global{name + ".prof.name", mir::GlobalKind::STRING, 0, name, {}});
+    mir::Value counters = code.global(mir::Global{name + ".prof", mir::GlobalKind::COUNTERS,
+                                                  static_cast<uint32_t>(counter_count), std::string(), {}});
+    mir::Value record = code.global(mir::Global{name + ".prof.record", mir::GlobalKind::RECORD, 0, std::string(),
+                                                {file, function_name, counters}});
+    start_block(code.new_block());
+    call_runtime(mir::Runtime::PROFILE_REGISTER, mir::Type::VOID, {record});
+    code.emit(mir::Op::RET, mir::Type::VOID);
+    code.finish();
+}
+
+// Memo tables are fixed size and open addressed: a key hashes to a start
+// slot and is looked for in the next MEMO_PROBES slots. A miss stores the
+// result in the first empty one of them, or evicts the start slot if all are
+// taken, so the table always keeps the most recent results.
+static const int MEMO_SIZE = 1 << 16;   // Entries, a power of two
+static const int MEMO_PROBES = 8;
+// One-argument functions called with 0 <= n < MEMO_DIRECT skip the hashing
+// and index a plain array instead
+static const int MEMO_DIRECT = 1 << 16;
+
+// The wrapper that checks func's memo table before calling its body,
+// name.impl, lowered in place of the body. The table is a global array of
+// { used, value, args... } entries, laid out as ints like the runtime's
+// tables (runtime.h).
+void FunctionEmitter::emit_memo_wrapper(FunctionDefNode* func, const FunctionTraits& traits) {
+    std::string name = symbols->name(func->name);
+    uint32_t count = static_cast<uint32_t>(func->params.size());
+    code.clear();
+    code.prefix = std::string(traits.internal ? "define internal i32 @" : "define i32 @") + name;
+    std::vector<mir::Value> args;
+    for (Symbol param : func->params) {
+        code.params.push_back(mir::Param{std::string("%arg_") + symbols->name(param), mir::Type::I32});
+        args.push_back(code.param(static_cast<uint32_t>(args.size())));
+    }
+    uint32_t entry_size = 2 + count;
+    mir::Value table = code.global(mir::Global{name + ".memo", mir::GlobalKind::TABLE,
+                                               count == 0 ? 2 : MEMO_SIZE * entry_size, std::string(), {}});
+    // Word index of the entry at entry: 0 is its used flag, 1 its value, then its args
+    auto word = [&](mir::Value entry, uint32_t index) {
+        return code.emit(mir::Op::ELEMENT, mir::Type::PTR, entry, code.constant(index, mir::Type::I64));
+    };
+    auto call_body = [&]() {
+        return code.call(mir::Op::CALL, mir::Type::I32, func->name, args.data(), count, mir::IMPL);
+    };
+    // Return entry's value if it is used, else compute, fill it in and return
+    auto lookup = [&](mir::Value entry) {
+        uint32_t hit = code.new_block();
+        uint32_t compute = code.new_block();
+        mir::Value value = word(entry, 1);
+        mir::Value used = code.load(mir::Type::I32, entry);
+        emit_cond_branch(code.icmp(mir::Pred::NE, used, code.constant(0)), hit, compute);
+        start_block(hit);
+        code.emit(mir::Op::RET, mir::Type::VOID, code.load(mir::Type::I32, value));
+        start_block(compute);
+        mir::Value result = call_body();
+        code.store(result, value);
+        code.store(code.constant(1), entry);
+        code.emit(mir::Op::RET, mir::Type::VOID, result);
+    };
+    // The entry at index of the table starting at base
+    auto entry_at = [&](mir::Value base, mir::Value index, uint32_t size) {
+        mir::Value wide = code.emit(mir::Op::ZEXT, mir::Type::I64, index);
+        mir::Value offset = code.binary(mir::Op::MUL, mir::Type::I64, wide, code.constant(size, mir::Type::I64),
+                                        mir::NUW | mir::NSW);
+        return code.emit(mir::Op::ELEMENT, mir::Type::PTR, base, offset);
+    };
+
+    start_block(code.new_block());
+    if (count == 0) {
+        lookup(code.emit(mir::Op::ARRAY, mir::Type::PTR, table));
+        code.finish();
+        return;
+    }
+
+    if (count == 1) {
+        mir::Value direct = code.global(mir::Global{name + ".memo.direct", mir::GlobalKind::TABLE,
+                                                    2 * MEMO_DIRECT, std::string(), {}});
+        uint32_t small = code.new_block();
+        uint32_t hash = code.new_block();
+        emit_cond_branch(code.icmp(mir::Pred::ULT, args[0], code.constant(MEMO_DIRECT)), small, hash);
+        start_block(small);
+        lookup(entry_at(code.emit(mir::Op::ARRAY, mir::Type::PTR, direct), args[0], 2));
+        start_block(hash);
+    }
+    uint32_t hash_block = current_block;
+
+    // Multiplicative hash of the argument words, high bits folded down
+    mir::Value hash = code.constant(0);
+    for (mir::Value arg : args) {
+        hash = code.binary(mir::Op::MUL, mir::Type::I32, code.binary(mir::Op::XOR, mir::Type::I32, hash, arg),
+                           code.constant(-1640531535));
+    }
+    hash = code.binary(mir::Op::XOR, mir::Type::I32, hash,
+                       code.binary(mir::Op::LSHR, mir::Type::I32, hash, code.constant(16)));
+    mir::Value mask = code.constant(MEMO_SIZE - 1);
+    mir::Value start = code.binary(mir::Op::AND, mir::Type::I32, hash, mask);
+    mir::Value base = code.emit(mir::Op::ARRAY, mir::Type::PTR, table);
+    mir::Value start_entry = entry_at(base, start, entry_size);
+    uint32_t probe = code.new_block();
+    uint32_t compare = code.new_block();
+    uint32_t hit = code.new_block();
+    uint32_t next = code.new_block();
+    uint32_t compute = code.new_block();
+    emit_branch(probe);
+
+    start_block(probe);
+    mir::Value i = code.phi(mir::Type::I32);
+    mir::Value offset = code.binary(mir::Op::ADD, mir::Type::I32, start, i);
+    mir::Value slot = code.binary(mir::Op::AND, mir::Type::I32, offset, mask);
+    mir::Value entry = entry_at(base, slot, entry_size);
+    mir::Value used = code.load(mir::Type::I32, entry);
+    emit_cond_branch(code.icmp(mir::Pred::EQ, used, code.constant(0)), compute, compare);
 
-    // Declare function
-    output << "define i32 @" << func->name << "(";
+    start_block(compare);
+    mir::Value match = mir::NONE;
+    for (uint32_t k = 0; k < count; k++) {
+        mir::Value key = word(entry, 2 + k);
+        mir::Value equal = code.icmp(mir::Pred::EQ, code.load(mir::Type::I32, key), args[k]);
+        match = match == mir::NONE ? equal : code.binary(mir::Op::AND, mir::Type::I1, match, equal);
+    }
+    emit_cond_branch(match, hit, next);
+
+    start_block(hit);
+    mir::Value value = word(entry, 1);
+    code.emit(mir::Op::RET, mir::Type::VOID, code.load(mir::Type::I32, value));
+
+    start_block(next);
+    mir::Value i_next = code.binary(mir::Op::ADD, mir::Type::I32, i, code.constant(1));
+    emit_cond_branch(code.icmp(mir::Pred::ULT, i_next, code.constant(MEMO_PROBES)), probe, compute);
+    code.set_incoming(i, {{code.constant(0), hash_block}, {i_next, next}});
+
+    // The call may fill the table further, so the entry is written afterwards
+    start_block(compute);
+    mir::Value target = code.phi(mir::Type::PTR);
+    code.set_incoming(target, {{entry, probe}, {start_entry, next}});
+    mir::Value result = call_body();
+    for (uint32_t k = 0; k < count; k++) {
+        code.store(args[k], word(target, 2 + k));
+    }
+    code.store(result, word(target, 1));
+    code.store(code.constant(1), target);
+    code.emit(mir::Op::RET, mir::Type::VOID, result);
+    code.finish();
+}
+
+void FunctionEmitter::emit(FunctionDefNode* func, const FunctionTraits& traits, std::string& ir,
+                           std::string& diagnostics, std::string& tail_notes) {
+    errors.str("");
+    notes.str("");
+    function = func;
+    tail_sites.clear();
+    counter_count = profile_counter_count(func);
+    next_site = 0;
+    next_loop_id = traits.first_loop_id;
+    loop_metadata.clear();
+    list_arena = needs_list_arena(func->body);
+    index_error = mir::NONE;
+    in_range_indices.clear();
+    parallel_counter = 0;
+    parallel_functions.clear();
+    counts = traits.counts;
+    if (counts && counts->size() != counter_count) {
+        errors << "Warning: profile data for " << symbols->name(func->name)
+               << " does not match its code; ignoring it\n";
+        counts = nullptr;
+    }
+
+    locals.assign(func, *symbols, errors);
+    variables.assign(locals.size(), mir::NONE);
+
+    // Declare function. A memoized function's body becomes name.impl, called
+    // through a wrapper under its own name that checks the memo table first.
+    const char* name = symbols->name(func->name);
+    code.clear();
+    if (func->memoize) {
+        code.prefix = std::string("define internal i32 @") + name + ".impl";
+    } else {
+        code.prefix = std::string(traits.internal ? "define internal i32 @" : "define i32 @") + name;
+    }
+    for (Symbol param : func->params) {
+        code.params.push_back(mir::Param{std::string("%arg_") + symbols->name(param), mir::Type::I32});
+    }
+    if (traits.always_inline) code.attributes += " alwaysinline";
+    if (counts) {
+        if (traits.hot) code.attributes += " hot";
+        if (traits.cold) code.attributes += " cold";
+        code.attributes += " !prof !{!\"function_entry_count\", i64 " + std::to_string((*counts)[0]) + "}";
+    }
+    code.counters = std::string("@") + name + ".prof";
+    code.counter_count = static_cast<uint32_t>(counter_count);
+    start_block(code.new_block());
+    if (list_arena) list_mark = call_runtime(mir::Runtime::ARENA_SAVE, mir::Type::BYTES, {});
+    if (!profile_file.empty()) {
+        increment_counter(0, code.constant(1, mir::Type::I64));
+    }
+
+    // Parameters are SSA values from the start; no stack slots needed
     for (size_t i = 0; i < func->params.size(); i++) {
-        if (i > 0) output << ", ";
-        output << "i32 %arg_" << func->params[i];
+        variables[locals.lookup(func->params[i])] = code.param(static_cast<uint32_t>(i));
     }
-    output << ") {\n";
 
-    // Allocate and store parameters
-    for (const auto& param : func->params) {
-        variables[param] = 1;
-        output << "  %" << param << " = alloca i32\n";
-        output << "  store i32 %arg_" << param << ", i32* %" << param << "\n";
+    // With self tail calls the body starts at a loop header whose phis take
+    // the parameters from entry and the arguments from every call site,
+    // filled in once the body is done. Memoized functions recurse through
+    // their wrapper instead, so every intermediate result lands in the table.
+    loop_tail_calls = !func->memoize && has_self_tail_call(func->body, func);
+    std::vector<mir::Value> param_phis;
+    if (loop_tail_calls) {
+        tailrecurse = code.new_block();
+        emit_branch(tailrecurse);
+        start_block(tailrecurse);
+        for (Symbol param : func->params) {
+            param_phis.push_back(code.phi(mir::Type::I32));
+            variables[locals.lookup(param)] = param_phis.back();
+        }
     }
 
     // Generate function body
-    for (auto& stmt : func->body) {
-        codegen_stmt(stmt.get());
+    codegen_block(func->body);
+
+    // Falling off the end returns None, which we model as 0
+    if (!block_terminated) {
+        release_lists();
+        code.emit(mir::Op::RET, mir::Type::VOID, code.constant(0));
     }
 
-    output << "}\n\n";
+    std::vector<std::pair<mir::Value, uint32_t>> edges;
+    for (size_t i = 0; i < param_phis.size(); i++) {
+        edges.clear();
+        edges.push_back(std::make_pair(code.param(static_cast<uint32_t>(i)), 0u));
+        for (const auto& site : tail_sites) {
+            edges.push_back(std::make_pair(site.second[i], site.first));
+        }
+        code.set_incoming(param_phis[i], edges);
+    }
+    finish_function();
+
+    ir.clear();
+    mir::print(code, *symbols, ir);
+    ir += loop_metadata;
+    ir += parallel_functions;
+    if (func->memoize) {
+        emit_memo_wrapper(func, traits);
+        mir::print(code, *symbols, ir);
+    }
+    if (!profile_file.empty()) {
+        emit_profile_record(func);
+        mir::print(code, *symbols, ir);
+    }
+    diagnostics += errors.str();
+    tail_notes += notes.str();
 }
 
-std::string CodeGenerator::generate(ProgramNode* program) {
-    std::ostringstream header;
+const char* const O0_PIPELINE = "always-inline,globaldce";
 
-    // Add printf declaration
-    header << "@.str = private unnamed_addr constant [4 x i8] c\"%d\\0A\\00\", align 1\n";
-    header << "declare i32 @printf(i8*, ...)\n\n";
+// Module-level declarations every module needs
+static const char* const module_header =
+    "declare void @pyc_print_i32(i32)\n"
+    "declare void @pyc_print_i32_unbuffered(i32)\n"
+    "declare void @pyc_profile_register({ i8*, i8*, i64*, i32, i8* }*)\n"
+    "declare i8* @pyc_arena_save()\n"
+    "declare void @pyc_arena_restore(i8*)\n"
+    "declare noalias align 64 i32* @pyc_list_alloc(i32)\n"
+    "declare void @pyc_index_error() cold noreturn nounwind\n"
+    "declare void @pyc_parallel_for(void (i8*, i32, i32)*, i8*, i32)\n\n";
 
-    // First pass: collect function declarations for symbol table
-    for (auto& func : program->functions) {
+// Register the profile counters of the given functions at startup
+static std::string profile_constructors(const std::vector<Symbol>& functions, const Interner& symbols) {
+    std::string entry_type = "{ i32, void ()*, i8* }";
+    std::string ir = "@llvm.global_ctors = appending global [" + std::to_string(functions.size()) +
+                     " x " + entry_type + "] [";
+    for (size_t i = 0; i < functions.size(); i++) {
+        if (i > 0) ir += ", ";
+        ir += entry_type + " { i32 65535, void ()* @" + symbols.name(functions[i]) +
+              ".prof.init, i8* null }";
+    }
+    return ir + "]\n";
+}
+
+void CodeGenerator::declare_functions(ProgramNode* program) {
+    function_arity.assign(program->symbols->size(), -1);
+    for (FunctionDefNode* func : program->functions) {
         declare_function(func->name, func->params);
     }
+}
+
+int CodeGenerator::arity(Symbol name) const {
+    return name < function_arity.size() ? function_arity[name] : -1;
+}
+
+std::string CodeGenerator::generate_function(FunctionDefNode* func, std::string& diagnostics,
+                                             std::string& notes) const {
+    std::string ir = module_header;
+
+    // Every other function this one calls is external to the module
+    std::vector<CallNode*> calls;
+    collect_calls(func->body, calls);
+    std::vector<bool> declared(options.symbols->size(), false);
+    declared[SYM_PRINT] = true;
+    declared[func->name] = true;
+    for (CallNode* call : calls) {
+        if (declared[call->function_name]) continue;
+        declared[call->function_name] = true;
+        int params = arity(call->function_name);
+        if (params < 0) params = static_cast<int>(call->args.size());
+        ir += std::string("declare i32 @") + options.symbols->name(call->function_name) + "(";
+        for (int i = 0; i < params; i++) {
+            ir += i > 0 ? ", i32" : "i32";
+        }
+        ir += ")\n";
+    }
+    ir += "\n";
 
-    // Generate function bodies
-    for (auto& func : program->functions) {
-        codegen_function(func.get());
+    std::string body;
+    FunctionEmitter emitter(options);
+    // Other modules call in here, so the function keeps external linkage
+    emitter.emit(func, profile_traits(func), body, diagnostics, notes);
+    if (!options.profile_file.empty()) {
+        body += profile_constructors({func->name}, *options.symbols);
+    }
+    return ir + body;
+}
+
+// Hot and cold attributes from the profile's entry counts: functions never
+// called are cold, those called at least a tenth as often as the busiest hot
+FunctionTraits CodeGenerator::profile_traits(FunctionDefNode* func) const {
+    FunctionTraits traits;
+    if (!options.profile) return traits;
+    traits.counts = options.profile->function(func->name);
+    if (!traits.counts) return traits;
+    uint64_t entries = (*traits.counts)[0];
+    traits.cold = entries == 0;
+    traits.hot = entries > 0 && entries * 10 >= options.profile->max_entry_count();
+    return traits;
+}
+
+// Functions with at most this many AST nodes are inlined into their callers
+static const size_t INLINE_SIZE_LIMIT = 40;
+
+// Tarjan's strongly connected components over the call graph: a function is
+// recursive if it calls itself or shares a component with another function
+namespace {
+struct CallGraph {
+    std::vector<std::vector<int>> callees;
+    std::vector<int> order, low;
+    std::vector<bool> on_stack, recursive;
+    std::vector<int> stack;
+    int next = 0;
+
+    void visit(int f) {
+        order[f] = low[f] = next++;
+        stack.push_back(f);
+        on_stack[f] = true;
+        for (int g : callees[f]) {
+            if (g == f) recursive[f] = true;
+            if (order[g] < 0) {
+                visit(g);
+                low[f] = std::min(low[f], low[g]);
+            } else if (on_stack[g]) {
+                low[f] = std::min(low[f], order[g]);
+            }
+        }
+        if (low[f] != order[f]) return;
+        size_t root = stack.size();
+        while (stack[--root] != f) {}
+        bool cycle = stack.size() - root > 1;
+        for (size_t i = root; i < stack.size(); i++) {
+            on_stack[stack[i]] = false;
+            if (cycle) recursive[stack[i]] = true;
+        }
+        stack.resize(root);
+    }
+};
+} // namespace
+
+static unsigned count_for_loops(const StmtList& stmts) {
+    unsigned count = 0;
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                count += count_for_loops(node->then_block) + count_for_loops(node->else_block);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                count += count_for_loops(static_cast<WhileNode*>(stmt)->body);
+                break;
+            case NodeType::FOR_RANGE_STMT:
+                count += 1 + count_for_loops(static_cast<ForRangeNode*>(stmt)->body);
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+static std::vector<FunctionTraits> plan_functions(ProgramNode* program) {
+    size_t count = program->functions.size();
+    std::vector<int> index(program->symbols->size(), -1);
+    for (size_t i = 0; i < count; i++) {
+        index[program->functions[i]->name] = static_cast<int>(i);
     }
 
-    return header.str() + output.str();
+    CallGraph graph;
+    graph.callees.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        std::vector<CallNode*> calls;
+        collect_calls(program->functions[i]->body, calls);
+        for (CallNode* call : calls) {
+            if (index[call->function_name] >= 0) {
+                graph.callees[i].push_back(index[call->function_name]);
+            }
+        }
+    }
+    graph.order.assign(count, -1);
+    graph.low.assign(count, 0);
+    graph.on_stack.assign(count, false);
+    graph.recursive.assign(count, false);
+    for (size_t i = 0; i < count; i++) {
+        if (graph.order[i] < 0) graph.visit(static_cast<int>(i));
+    }
+
+    std::vector<FunctionTraits> traits(count);
+    unsigned loop_ids = 0;
+    for (size_t i = 0; i < count; i++) {
+        FunctionDefNode* func = program->functions[i];
+        traits[i].first_loop_id = loop_ids;
+        loop_ids += count_for_loops(func->body);
+        if (func->name == SYM_MAIN) continue;
+        traits[i].internal = true;
+        traits[i].always_inline = !func->memoize && !graph.recursive[i] &&
+                                  count_nodes(func->body) <= INLINE_SIZE_LIMIT;
+    }
+    return traits;
+}
+
+std::string CodeGenerator::generate(ProgramNode* program, std::string& diagnostics) {
+    // First pass: collect function declarations for symbol table
+    declare_functions(program);
+
+    // Function bodies are independent once the declarations are known:
+    // generate them in parallel and join the results in source order so the
+    // output does not depend on scheduling
+    size_t count = program->functions.size();
+    std::vector<std::string> bodies(count);
+    std::vector<std::string> function_diagnostics(count);
+    std::vector<std::string> notes(count);
+    std::vector<FunctionTraits> traits = plan_functions(program);
+    for (size_t i = 0; i < count; i++) {
+        FunctionTraits profiled = profile_traits(program->functions[i]);
+        traits[i].hot = profiled.hot;
+        traits[i].cold = profiled.cold;
+        traits[i].counts = profiled.counts;
+    }
+    ThreadPool pool(options.jobs);
+    std::vector<FunctionEmitter> emitters;
+    for (unsigned i = 0; i < pool.size(); i++) {
+        emitters.emplace_back(options);
+    }
+    pool.parallel_for(count, [&](size_t i, unsigned worker) {
+        emitters[worker].emit(program->functions[i], traits[i], bodies[i],
+                              function_diagnostics[i], notes[i]);
+    });
+
+    std::string ir = module_header;
+    for (size_t i = 0; i < count; i++) {
+        diagnostics += function_diagnostics[i];
+        if (options.report_tail_calls) diagnostics += notes[i];
+        ir += bodies[i];
+    }
+    if (!options.profile_file.empty() && count > 0) {
+        std::vector<Symbol> names;
+        for (FunctionDefNode* func : program->functions) {
+            names.push_back(func->name);
+        }
+        ir += profile_constructors(names, *options.symbols);
+    }
+    return ir;
 }
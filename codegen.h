@@ -1,31 +1,161 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include <initializer_list>
 #include <string>
-#include <map>
 #include <vector>
 #include <sstream>
 #include "ast.h"
+#include "locals.h"
+#include "mir.h"
+#include "profile.h"
 
-class CodeGenerator {
+// SSA value that currently defines each local variable slot in the block
+// being emitted; mir::NONE if the slot is unassigned on this path
+typedef std::vector<mir::Value> DefTable;
+
+// Linkage and inlining hint of one emitted function
+struct FunctionTraits {
+    bool internal = false;       // Only called from within the module
+    bool always_inline = false;  // Small and non-recursive: inline into every caller
+    bool hot = false;            // Profile: among the most called functions
+    bool cold = false;           // Profile: never called
+    const std::vector<uint64_t>* counts = nullptr;  // Profile: the function's counters
+    unsigned first_loop_id = 0;  // Metadata ID of the function's first for loop
+};
+
+struct CodegenOptions {
+    unsigned jobs = 1;               // Threads used to generate function bodies
+    bool report_tail_calls = false;  // Add tail call notes to the diagnostics
+    bool unbuffered_print = false;   // print() writes each line out immediately
+    std::string profile_file;        // Non-empty: count executions, written here at exit
+    const Profile* profile = nullptr;  // Counts to annotate branches and functions with
+    const Interner* symbols = nullptr; // Names of the program's Symbols
+};
+
+// Pass pipeline run at -O0: inlines the always_inline functions and drops
+// internal ones that are no longer called
+extern const char* const O0_PIPELINE;
+
+// Lowers one function at a time to the mid-level IR (mir.h) and prints it.
+// All state is private to the emitter, so function bodies can be generated
+// concurrently with one emitter per thread; an emitter is reused for every
+// function its thread handles.
+class FunctionEmitter {
 private:
-    std::ostringstream output;
-    std::map<std::string, int> variables; // Maps variable names to their register numbers
-    std::map<std::string, std::vector<std::string>> functions; // Maps function names to parameter lists
-    int temp_counter;
-    int label_counter;
-    std::string current_function;
-
-    std::string get_temp();
-    std::string get_label();
-    std::string codegen_expr(ExprNode* expr);
+    const Interner* symbols;       // Names of the program's Symbols
+    mir::Function code;            // The function being lowered
+    std::ostringstream errors;
+    DefTable variables;
+    uint32_t current_block;        // Block being emitted
+    bool block_terminated;         // Current block already ends in br/ret
+    std::ostringstream notes;      // One line per transformed tail call
+
+    // Self tail calls branch back to a header whose phis rebind the
+    // parameters; each site records its block and argument values
+    FunctionDefNode* function;
+    bool loop_tail_calls;
+    uint32_t tailrecurse;          // The header
+    std::vector<std::pair<uint32_t, std::vector<mir::Value>>> tail_sites;
+
+    LocalSlots locals;             // Slots of the current function's locals
+
+    mir::Runtime print_runtime;    // Runtime function print() calls
+
+    // Lists. A list variable's slot holds a pointer to its ints, and its
+    // length has a slot of its own (LocalSlots::list_length). Constant-size
+    // lists are stack slots made on entry; the others come from the
+    // runtime's arena, released before every return.
+    bool list_arena;               // The function allocates from the arena
+    mir::Value list_mark;          // Arena position saved on entry
+    uint32_t index_error;          // Block reporting a bad index, or mir::NONE
+    // Loop variables known to index a list in range: (variable, list) slots
+    std::vector<std::pair<int, int>> in_range_indices;
+
+    // Profiling. Counter 0 counts entries, then every if and loop has an
+    // execution and a taken counter, numbered in source order
+    std::string profile_file;      // Non-empty: instrument the function
+    const std::vector<uint64_t>* counts;  // Recorded counters to apply, if any
+    size_t counter_count;
+    size_t next_site;
+
+    unsigned next_loop_id;         // Module-unique llvm.loop metadata IDs
+    std::string loop_metadata;     // Their definitions, written after the function
+
+    // prange loops. Each body becomes an internal function over a range of
+    // iterations, given the loop's inputs and reduction accumulators in a
+    // struct, and the runtime runs it on chunks across its threads
+    bool in_parallel_body;         // Emitting such a function; prange runs serially
+    int parallel_counter;
+    std::string parallel_functions;  // Their definitions, written after the function
+
+    mir::Type slot_type(size_t slot) const;
+    mir::Value undefined_value(size_t slot);
+    int lookup_list(Symbol name);
+    void start_block(uint32_t block);
+    void emit_branch(uint32_t block);
+    void emit_cond_branch(mir::Value cond, uint32_t taken, uint32_t not_taken,
+                          const mir::BranchInfo& info = mir::BranchInfo{0, 0, 0, mir::NONE});
+    mir::Value call_runtime(mir::Runtime callee, mir::Type type, std::initializer_list<mir::Value> args);
+    void merge_definitions(const std::vector<std::pair<uint32_t, DefTable>>& incoming);
+    mir::Value emit_call(Symbol callee, const std::vector<mir::Value>& args, uint8_t flags);
+    void codegen_tail_call(CallNode* call);
+    mir::Value codegen_expr(ExprNode* expr);
+    mir::Value codegen_cond(ExprNode* expr);
     void codegen_stmt(StmtNode* stmt);
-    void codegen_function(FunctionDefNode* func);
+    void codegen_block(const StmtList& stmts);
+    void codegen_for_range(ForRangeNode* node);
+    mir::Value emit_trip_count(int step, mir::Value start, mir::Value stop, mir::Value& nonempty);
+    void emit_counted_loop(ForRangeNode* node, mir::Value start, mir::Value first, mir::Value trip,
+                           mir::Value guard, size_t site);
+    void codegen_parallel_for(ForRangeNode* node);
+    void emit_parallel_body(const FunctionEmitter& parent, ForRangeNode* node, const std::string& name,
+                            const std::vector<mir::Type>& layout, const std::vector<int>& inputs,
+                            const std::vector<std::pair<int, BinaryOp>>& reductions, size_t site);
+    int in_range_list(ForRangeNode* node, const std::vector<bool>& assigned);
+    void codegen_new_list(NewListNode* node, int slot);
+    mir::Value element_pointer(Symbol list, ExprNode* index);
+    void release_lists();
+    void finish_function();
+    void emit_memo_wrapper(FunctionDefNode* func, const FunctionTraits& traits);
+    void increment_counter(size_t index, mir::Value amount);
+    mir::BranchInfo branch_site(size_t site, mir::Value cond_bool);
+    void emit_profile_record(FunctionDefNode* func);
+
+public:
+    explicit FunctionEmitter(const CodegenOptions& options = CodegenOptions());
+    // Generate func into ir, appending any diagnostics to diagnostics and a
+    // note for every tail call it transformed to notes
+    void emit(FunctionDefNode* func, const FunctionTraits& traits, std::string& ir,
+              std::string& diagnostics, std::string& notes);
+};
+
+class CodeGenerator {
+private:
+    // Parameter count indexed by Symbol, -1 for non-functions; sized by the
+    // program's own symbol table when its functions are declared
+    std::vector<int> function_arity;
+    CodegenOptions options;
+
+    FunctionTraits profile_traits(FunctionDefNode* func) const;
 
 public:
-    CodeGenerator();
-    std::string generate(ProgramNode* program);
-    void declare_function(const std::string& name, const std::vector<std::string>& params);
+    explicit CodeGenerator(const CodegenOptions& options = CodegenOptions());
+    // Generate the whole program; diagnostics are appended to diagnostics.
+    // Everything but main is internal, and small non-recursive functions are
+    // marked for inlining.
+    std::string generate(ProgramNode* program, std::string& diagnostics);
+    // Declare every function of program; forgets any declared before
+    void declare_functions(ProgramNode* program);
+    void declare_function(Symbol name, const NameList& params);
+    int arity(Symbol name) const;
+    const Profile* profile() const { return options.profile; }
+    const Interner& symbols() const { return *options.symbols; }
+    // Generate a module holding only func, with declarations for everything
+    // it calls, so functions can be compiled (and cached) separately. The
+    // program's functions must have been declared first.
+    std::string generate_function(FunctionDefNode* func, std::string& diagnostics,
+                                  std::string& notes) const;
 };
 
 #endif // CODEGEN_H
@@ -1,14 +1,16 @@
 #include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
 #include <string>
 #include "parser.tab.hpp"
+#include "source.h"
 
-extern FILE* yyin;
-extern int yylex_orig();
-extern int yylineno;
-extern void reset_lexer();
-extern YYSTYPE yylval;
-extern char* yytext;
-extern int yyleng;
+// Reentrant scanner interface generated by flex from lexer.l
+int yyget_lineno(yyscan_t scanner);
+char* yyget_text(yyscan_t scanner);
+int yyget_leng(yyscan_t scanner);
+int yylex_orig(YYSTYPE* yylval, yyscan_t scanner);
 
 const char* token_name(int tok) {
     switch(tok) {
@@ -18,10 +20,14 @@ const char* token_name(int tok) {
         case ELIF: return "ELIF";
         case ELSE: return "ELSE";
         case WHILE: return "WHILE";
+        case FOR: return "FOR";
+        case IN: return "IN";
         case AND: return "AND";
         case OR: return "OR";
         case PRINT: return "PRINT";
         case NAME_VAR: return "NAME_VAR";
+        case IMPORT: return "IMPORT";
+        case FROM: return "FROM";
         case EQ: return "EQ";
         case NEQ: return "NEQ";
         case GT: return "GT";
@@ -36,8 +42,12 @@ const char* token_name(int tok) {
         case MODULO: return "MODULO";
         case LPAREN: return "LPAREN";
         case RPAREN: return "RPAREN";
+        case LBRACKET: return "LBRACKET";
+        case RBRACKET: return "RBRACKET";
         case COLON: return "COLON";
         case COMMA: return "COMMA";
+        case DOT: return "DOT";
+        case AT: return "AT";
         case NEWLINE: return "NEWLINE";
         case INDENT: return "INDENT";
         case DEDENT: return "DEDENT";
@@ -48,30 +58,52 @@ const char* token_name(int tok) {
     }
 }
 
+// With --time, only count the tokens, and report how fast the file was
+// mapped and scanned on stderr
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <file>\n", argv[0]);
+    bool timed = argc > 2 && strcmp(argv[2], "--time") == 0;
+    if (argc < 2 || (argc > 2 && !timed)) {
+        fprintf(stderr, "Usage: %s <file> [--time]\n", argv[0]);
         return 1;
     }
 
-    yyin = fopen(argv[1], "r");
-    if (!yyin) {
+    auto start = std::chrono::steady_clock::now();
+    SourceBuffer source;
+    if (!source.load_file(argv[1])) {
         fprintf(stderr, "Could not open %s\n", argv[1]);
         return 1;
     }
 
-    reset_lexer();
+    Arena arena;
+    Interner symbols;
+    ParseContext ctx(&arena, &symbols, &std::cerr);
+    yyscan_t scanner;
+    if (begin_scan(source.data(), source.size(), ctx, &scanner) != 0) {
+        return 1;
+    }
+    YYSTYPE yylval;
     int tok;
-    while ((tok = yylex_orig()) != 0) {
-        printf("Line %d: %s (matched: '%.*s')", yylineno, token_name(tok), yyleng, yytext);
+    long tokens = 0;
+    while ((tok = yylex_orig(&yylval, scanner)) != 0) {
+        tokens++;
+        if (timed) continue;
+        // Tokens are spans of the source, which is scanned in place
+        const char* text = yyget_text(scanner);
+        printf("Line %d: %s (matched: '%.*s' at %ld+%d)", yyget_lineno(scanner), token_name(tok),
+               yyget_leng(scanner), text, static_cast<long>(text - ctx.source), yyget_leng(scanner));
         if (tok == IDENTIFIER || tok == STRING) {
-            printf(" [value: %s]", yylval.str_val->c_str());
+            printf(" [value: %s]", symbols.name(yylval.sym));
         } else if (tok == INTEGER) {
             printf(" [value: %d]", yylval.int_val);
         }
         printf("\n");
     }
+    end_scan(scanner);
 
-    fclose(yyin);
+    if (timed) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%zu bytes, %ld tokens in %.3f ms: %.1f MB/s\n", source.size(), tokens,
+                seconds * 1e3, source.size() / seconds / 1e6);
+    }
     return 0;
 }
@@ -0,0 +1,1149 @@
+#include "fast_backend.h"
+#include <cstdint>
+#include <initializer_list>
+#include <sstream>
+#include <vector>
+#include "parallel.h"
+
+namespace {
+
+enum Reg { RAX = 0, RCX = 1, RDX = 2, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R8 = 8, R9 = 9 };
+
+// Condition codes, as in the low nibble of jcc and setcc
+enum Cond : uint8_t {
+    COND_B = 0x2, COND_E = 0x4, COND_NE = 0x5, COND_NS = 0x9,
+    COND_L = 0xc, COND_GE = 0xd, COND_LE = 0xe, COND_G = 0xf, COND_AE = 0x3
+};
+
+// System V integer argument registers; further arguments go on the stack
+const Reg ARG_REGS[] = {RDI, RSI, RDX, RCX, R8, R9};
+const size_t REG_ARGS = 6;
+
+// Runtime functions the code calls, the object's only undefined symbols
+enum Runtime {
+    RT_PRINT, RT_PRINT_UNBUFFERED, RT_ARENA_SAVE, RT_ARENA_RESTORE, RT_LIST_ALLOC,
+    RT_INDEX_ERROR, RT_MEMO_LOOKUP, RT_MEMO_STORE, RUNTIME_COUNT
+};
+const char* const RUNTIME_NAMES[RUNTIME_COUNT] = {
+    "pyc_print_i32", "pyc_print_i32_unbuffered", "pyc_arena_save", "pyc_arena_restore",
+    "pyc_list_alloc", "pyc_index_error", "pyc_memo_lookup", "pyc_memo_store"
+};
+
+// The .text section as it is written. Jumps to labels and calls between
+// functions are filled in by resolve(); calls to the runtime and references
+// to .bss are left to the linker as relocations.
+class Assembler {
+public:
+    struct Fixup {
+        size_t offset;   // Of a rel32 field
+        size_t target;   // Label, function index, Runtime or .bss offset
+    };
+
+    std::string code;
+    std::vector<Fixup> runtime_calls;
+    std::vector<Fixup> bss_refs;
+
+    void byte(uint8_t value) { code += static_cast<char>(value); }
+    void bytes(std::initializer_list<uint8_t> values) {
+        for (uint8_t value : values) byte(value);
+    }
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    void patch32(size_t at, uint32_t value) {
+        for (int i = 0; i < 4; i++) code[at + i] = static_cast<char>(value >> (8 * i));
+    }
+    void align(size_t boundary) {
+        while (code.size() % boundary != 0) byte(0xcc);
+    }
+
+    int new_label() {
+        labels.push_back(0);
+        return static_cast<int>(labels.size() - 1);
+    }
+    void bind(int label) { labels[label] = code.size(); }
+
+    void jmp(int label) {
+        byte(0xe9);
+        rel32(label_fixups, label);
+    }
+    void jcc(Cond cond, int label) {
+        bytes({0x0f, static_cast<uint8_t>(0x80 | cond)});
+        rel32(label_fixups, label);
+    }
+    void call_function(size_t index) {
+        byte(0xe8);
+        rel32(function_fixups, index);
+    }
+    void jmp_function(size_t index) {
+        byte(0xe9);
+        rel32(function_fixups, index);
+    }
+    void call_runtime(Runtime function) {
+        byte(0xe8);
+        rel32(runtime_calls, function);
+    }
+
+    // REX prefix, if needed, for a 64-bit operation (wide) on the registers
+    // in the ModRM reg and rm fields
+    void rex(bool wide, int reg, int rm) {
+        uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+        if (prefix != 0x40) byte(prefix);
+    }
+    static uint8_t modrm(int mod, int reg, int rm) {
+        return static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7));
+    }
+    // opcode with reg and [rbp + disp]
+    void frame_op(bool wide, uint8_t opcode, int reg, int32_t disp) {
+        rex(wide, reg, RBP);
+        bytes({opcode, modrm(2, reg, RBP)});
+        u32(static_cast<uint32_t>(disp));
+    }
+    // opcode with registers reg and rm
+    void reg_op(bool wide, uint8_t opcode, int reg, int rm) {
+        rex(wide, reg, rm);
+        bytes({opcode, modrm(3, reg, rm)});
+    }
+
+    void load(Reg reg, int32_t disp) { frame_op(false, 0x8b, reg, disp); }
+    void store(int32_t disp, Reg reg) { frame_op(false, 0x89, reg, disp); }
+    void load64(Reg reg, int32_t disp) { frame_op(true, 0x8b, reg, disp); }
+    void store64(int32_t disp, Reg reg) { frame_op(true, 0x89, reg, disp); }
+    void lea(Reg reg, int32_t disp) { frame_op(true, 0x8d, reg, disp); }
+    // lea reg, [rip + .bss + offset]
+    void lea_bss(Reg reg, size_t offset) {
+        rex(true, reg, 0);
+        bytes({0x8d, modrm(0, reg, 5)});
+        rel32(bss_refs, offset);
+    }
+    void mov(Reg dst, Reg src) { reg_op(false, 0x89, src, dst); }
+    void mov64(Reg dst, Reg src) { reg_op(true, 0x89, src, dst); }
+    void mov_imm(Reg reg, int32_t value) {
+        if (reg & 8) byte(0x41);
+        byte(static_cast<uint8_t>(0xb8 | (reg & 7)));
+        u32(static_cast<uint32_t>(value));
+    }
+    void push(Reg reg) {
+        if (reg & 8) byte(0x41);
+        byte(static_cast<uint8_t>(0x50 | (reg & 7)));
+    }
+    void pop(Reg reg) {
+        if (reg & 8) byte(0x41);
+        byte(static_cast<uint8_t>(0x58 | (reg & 7)));
+    }
+    void add(Reg dst, Reg src) { reg_op(false, 0x01, src, dst); }
+    void sub(Reg dst, Reg src) { reg_op(false, 0x29, src, dst); }
+    void xor_(Reg dst, Reg src) { reg_op(false, 0x31, src, dst); }
+    void cmp(Reg left, Reg right) { reg_op(false, 0x39, right, left); }
+    void test(Reg reg) { reg_op(false, 0x85, reg, reg); }
+    void imul(Reg dst, Reg src) {
+        rex(false, dst, src);
+        bytes({0x0f, 0xaf, modrm(3, dst, src)});
+    }
+    // eax = cond ? 1 : 0, from the flags
+    void set_eax(Cond cond) {
+        bytes({0x0f, static_cast<uint8_t>(0x90 | cond), 0xc0});  // setcc al
+        bytes({0x0f, 0xb6, 0xc0});                                // movzx eax, al
+    }
+    void add_rsp(int32_t amount) {
+        bytes({0x48, 0x81, 0xc4});
+        u32(static_cast<uint32_t>(amount));
+    }
+    void sub_rsp(int32_t amount) {
+        bytes({0x48, 0x81, 0xec});
+        u32(static_cast<uint32_t>(amount));
+    }
+
+    void resolve(const std::vector<size_t>& function_offsets) {
+        for (const Fixup& fixup : label_fixups) {
+            patch32(fixup.offset, static_cast<uint32_t>(labels[fixup.target] - (fixup.offset + 4)));
+        }
+        for (const Fixup& fixup : function_fixups) {
+            patch32(fixup.offset, static_cast<uint32_t>(function_offsets[fixup.target] - (fixup.offset + 4)));
+        }
+    }
+
+private:
+    std::vector<size_t> labels;
+    std::vector<Fixup> label_fixups;
+    std::vector<Fixup> function_fixups;
+
+    void rel32(std::vector<Fixup>& fixups, size_t target) {
+        fixups.push_back(Fixup{code.size(), target});
+        u32(0);
+    }
+};
+
+// What the functions of the module know about each other
+struct ModuleInfo {
+    const Interner* symbols;           // Names of the program's Symbols
+    std::vector<FunctionDefNode*> functions;
+    std::vector<int> function_index;   // By Symbol; -1 for names that are not functions
+    std::vector<size_t> memo_table;    // By function: .bss offset of its table pointer
+};
+
+// Compiles one function at a time. The frame holds every variable in an
+// 8-byte slot at rbp - 8 * (slot + 1), numbered by LocalSlots like CodeGenerator's,
+// then hidden slots for loop counters, saved values and the like. Which
+// variables are defined is tracked the way CodeGenerator's SSA values are,
+// so the same reads are reported as undefined; variables start out zero.
+class FunctionCompiler {
+private:
+    Assembler& as;
+    const ModuleInfo& module;
+    const CodegenOptions& options;
+    std::ostringstream& errors;
+    std::ostringstream& notes;
+    LocalSlots& locals;                // Variable slots, reused for every function
+    bool fatal;
+
+    FunctionDefNode* function;
+    size_t index;
+    std::vector<bool> defined;
+    int slot_count;
+    int depth;                         // 8-byte values pushed since the prologue
+    bool terminated;                   // The code being written is unreachable
+    bool in_parallel_body;
+    bool uses_lists;
+    int mark_slot;                     // Arena top on entry
+    int result_slot;                   // Return value while the epilogue calls out
+    int memo_args_slot;                // The arguments as an int32 array
+    int body_label;
+    int epilogue_label;
+    int index_error_label;
+    bool index_error;
+
+    static int32_t disp(int slot) { return -8 * (slot + 1); }
+    int new_slot() { return slot_count++; }
+
+    int lookup_list(Symbol name);
+    int lookup_function(CallNode* call);
+
+    void call_runtime(Runtime function);
+    void release_lists();
+    size_t push_arguments(const ExprList& args);
+    void compile_expr(ExprNode* expr);
+    void compile_operands(BinaryOpNode* node);
+    void compile_call(CallNode* call);
+    void compile_tail_call(CallNode* call);
+    bool element(Symbol list, ExprNode* index);
+    void compile_new_list(NewListNode* node, int slot);
+    void compile_stmt(StmtNode* stmt);
+    void compile_block(const StmtList& stmts);
+    void compile_for_range(ForRangeNode* node);
+    void compile_counted_loop(ForRangeNode* node, int var_slot, int start_slot, int end_label);
+
+public:
+    FunctionCompiler(Assembler& as, const ModuleInfo& module, const CodegenOptions& options,
+                     std::ostringstream& errors, std::ostringstream& notes, LocalSlots& locals)
+        : as(as), module(module), options(options), errors(errors), notes(notes), locals(locals),
+          fatal(false) {}
+    // Write function index of the module at the end of the code; returns
+    // false if it calls a function wrongly
+    bool compile(size_t index);
+};
+
+int FunctionCompiler::lookup_list(Symbol name) {
+    int slot = locals.lookup(name);
+    if (slot < 0 || locals.list_length[slot] < 0) {
+        errors << "Error: " << module.symbols->name(name) << " is not a list\n";
+        return -1;
+    }
+    if (!defined[slot]) {
+        errors << "Error: undefined variable " << module.symbols->name(name) << std::endl;
+        return -1;
+    }
+    return slot;
+}
+
+// Index of the function call calls, or -1 after reporting why it can't be
+// called; the LLVM backends reject such calls as invalid IR
+int FunctionCompiler::lookup_function(CallNode* call) {
+    Symbol name = call->function_name;
+    int callee = name < module.function_index.size() ? module.function_index[name] : -1;
+    if (callee < 0) {
+        errors << "Error: call to undefined function " << module.symbols->name(name) << "\n";
+        fatal = true;
+        return -1;
+    }
+    size_t arity = module.functions[callee]->params.size();
+    if (call->args.size() != arity) {
+        errors << "Error: " << module.symbols->name(name) << " takes " << arity << " arguments but "
+               << call->args.size() << " were given\n";
+        fatal = true;
+        return -1;
+    }
+    return callee;
+}
+
+// Calls need rsp 16-byte aligned, which it is with an even depth
+void FunctionCompiler::call_runtime(Runtime runtime) {
+    bool pad = depth % 2 != 0;
+    if (pad) as.sub_rsp(8);
+    as.call_runtime(runtime);
+    if (pad) as.add_rsp(8);
+}
+
+void FunctionCompiler::release_lists() {
+    if (!uses_lists) return;
+    as.load64(RDI, disp(mark_slot));
+    call_runtime(RT_ARENA_RESTORE);
+}
+
+// Evaluate args left to right into the argument registers and, past six,
+// onto the stack below an aligning pad. Returns the bytes of stack to drop
+// after the call, which depth still counts.
+size_t FunctionCompiler::push_arguments(const ExprList& args) {
+    size_t stacked = args.size() > REG_ARGS ? args.size() - REG_ARGS : 0;
+    size_t reserved = stacked + (depth + stacked) % 2;
+    if (reserved > 0) as.sub_rsp(static_cast<int32_t>(8 * reserved));
+    depth += static_cast<int>(reserved);
+    size_t pushed = 0;
+    for (size_t i = 0; i < args.size(); i++) {
+        compile_expr(args[i]);
+        if (i < REG_ARGS) {
+            as.push(RAX);
+            depth++;
+            pushed++;
+        } else {
+            // mov [rsp + disp32], eax
+            as.bytes({0x89, 0x84, 0x24});
+            as.u32(static_cast<uint32_t>(8 * (pushed + i - REG_ARGS)));
+        }
+    }
+    for (size_t i = pushed; i > 0; i--) {
+        as.pop(ARG_REGS[i - 1]);
+        depth--;
+    }
+    return 8 * reserved;
+}
+
+void FunctionCompiler::compile_call(CallNode* call) {
+    if (call->function_name == SYM_PRINT) {
+        if (call->args.size() != 1) {
+            errors << "Error: print takes exactly one argument\n";
+            as.xor_(RAX, RAX);
+            return;
+        }
+        compile_expr(call->args[0]);
+        as.mov(RDI, RAX);
+        call_runtime(options.unbuffered_print ? RT_PRINT_UNBUFFERED : RT_PRINT);
+        as.xor_(RAX, RAX);
+        return;
+    }
+    int callee = lookup_function(call);
+    if (callee < 0) {
+        as.xor_(RAX, RAX);
+        return;
+    }
+    size_t reserved = push_arguments(call->args);
+    as.call_function(callee);
+    if (reserved > 0) {
+        as.add_rsp(static_cast<int32_t>(reserved));
+        depth -= static_cast<int>(reserved / 8);
+    }
+}
+
+// `return f(...)`: a self call jumps back to the body with new parameters,
+// and a call passing everything in registers jumps to the callee, which then
+// returns to our caller. A memoized function has to record its result, so
+// its calls return to it as usual.
+void FunctionCompiler::compile_tail_call(CallNode* call) {
+    int callee = lookup_function(call);
+    const char* caller = module.symbols->name(function->name);
+    bool self = callee >= 0 && static_cast<size_t>(callee) == index;
+    if (callee >= 0 && !function->memoize && (self || call->args.size() <= REG_ARGS)) {
+        for (ExprNode* arg : call->args) {
+            compile_expr(arg);
+            as.push(RAX);
+            depth++;
+        }
+        if (self) {
+            for (size_t i = call->args.size(); i > 0; i--) {
+                as.pop(RAX);
+                depth--;
+                as.store(disp(static_cast<int>(i - 1)), RAX);
+            }
+            release_lists();
+            as.jmp(body_label);
+            notes << "note: " << caller << ": self tail call turned into a loop\n";
+        } else {
+            release_lists();
+            for (size_t i = call->args.size(); i > 0; i--) {
+                as.pop(ARG_REGS[i - 1]);
+                depth--;
+            }
+            as.byte(0xc9);  // leave
+            as.jmp_function(callee);
+            notes << "note: " << caller << ": tail call to " << module.symbols->name(call->function_name)
+                  << " turned into a jump\n";
+        }
+        terminated = true;
+        return;
+    }
+    if (callee < 0) {
+        as.xor_(RAX, RAX);
+        as.jmp(epilogue_label);
+        terminated = true;
+        return;
+    }
+    compile_call(call);
+    as.jmp(epilogue_label);
+    terminated = true;
+}
+
+// rax = the checked index into list, rdx = its data; false, with nothing
+// usable in them, if list is not a defined list. A negative index counts from
+// the end, and an index still out of range raises IndexError.
+bool FunctionCompiler::element(Symbol list, ExprNode* index) {
+    int slot = lookup_list(list);
+    if (slot < 0) return false;
+    compile_expr(index);
+    int positive = as.new_label();
+    as.load(RCX, disp(locals.list_length[slot]));
+    as.test(RAX);
+    as.jcc(COND_NS, positive);
+    as.add(RAX, RCX);
+    as.bind(positive);
+    as.cmp(RAX, RCX);
+    as.jcc(COND_AE, index_error_label);
+    index_error = true;
+    as.load64(RDX, disp(slot));
+    return true;
+}
+
+// [value] * length: value is evaluated first, and a negative length makes
+// an empty list. Lists always come from the arena.
+void FunctionCompiler::compile_new_list(NewListNode* node, int slot) {
+    compile_expr(node->value);
+    as.push(RAX);
+    depth++;
+    compile_expr(node->length);
+    as.xor_(RCX, RCX);
+    as.test(RAX);
+    as.bytes({0x0f, 0x48, 0xc1});  // cmovs eax, ecx
+    as.push(RAX);
+    depth++;
+    as.mov(RDI, RAX);
+    call_runtime(RT_LIST_ALLOC);
+    as.pop(RCX);
+    as.pop(RDX);
+    depth -= 2;
+    as.store64(disp(slot), RAX);
+    as.store(disp(locals.list_length[slot]), RCX);
+    as.mov64(RDI, RAX);
+    as.mov(RAX, RDX);
+    as.bytes({0xf3, 0xab});  // rep stosd
+    defined[slot] = true;
+    defined[locals.list_length[slot]] = true;
+}
+
+// eax = left, ecx = right. A literal or variable on the right is loaded
+// straight into ecx; anything else is evaluated with left saved on the stack.
+void FunctionCompiler::compile_operands(BinaryOpNode* node) {
+    compile_expr(node->left);
+    ExprNode* right = node->right;
+    if (right->type == NodeType::INTEGER) {
+        as.mov_imm(RCX, static_cast<IntegerNode*>(right)->value);
+        return;
+    }
+    if (right->type == NodeType::IDENTIFIER) {
+        int slot = locals.lookup(static_cast<IdentifierNode*>(right)->name);
+        if (slot >= 0 && defined[slot] && locals.list_length[slot] < 0) {
+            as.load(RCX, disp(slot));
+            return;
+        }
+    }
+    as.push(RAX);
+    depth++;
+    compile_expr(right);
+    as.mov(RCX, RAX);
+    as.pop(RAX);
+    depth--;
+}
+
+void FunctionCompiler::compile_expr(ExprNode* expr) {
+    switch (expr->type) {
+        case NodeType::INTEGER:
+            as.mov_imm(RAX, static_cast<IntegerNode*>(expr)->value);
+            return;
+
+        case NodeType::IDENTIFIER: {
+            IdentifierNode* node = static_cast<IdentifierNode*>(expr);
+            int slot = locals.lookup(node->name);
+            if (slot < 0 || !defined[slot]) {
+                errors << "Error: undefined variable " << module.symbols->name(node->name) << std::endl;
+                as.xor_(RAX, RAX);
+                return;
+            }
+            if (locals.list_length[slot] >= 0) {
+                errors << "Error: list " << module.symbols->name(node->name)
+                       << " can only be indexed or passed to len()\n";
+                as.xor_(RAX, RAX);
+                return;
+            }
+            as.load(RAX, disp(slot));
+            return;
+        }
+
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            if (element(node->list_name, node->index)) {
+                as.bytes({0x8b, 0x04, 0x82});  // mov eax, [rdx + rax * 4]
+            } else {
+                as.xor_(RAX, RAX);
+            }
+            return;
+        }
+
+        case NodeType::LEN: {
+            int slot = lookup_list(static_cast<LenNode*>(expr)->list_name);
+            if (slot < 0) {
+                as.xor_(RAX, RAX);
+            } else {
+                as.load(RAX, disp(locals.list_length[slot]));
+            }
+            return;
+        }
+
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            // and/or give 0 or 1, evaluating the right only when it decides
+            if (node->op == BinaryOp::AND || node->op == BinaryOp::OR) {
+                int right_label = as.new_label();
+                int end_label = as.new_label();
+                compile_expr(node->left);
+                as.test(RAX);
+                if (node->op == BinaryOp::AND) {
+                    as.jcc(COND_E, end_label);
+                } else {
+                    as.jcc(COND_E, right_label);
+                    as.mov_imm(RAX, 1);
+                    as.jmp(end_label);
+                }
+                as.bind(right_label);
+                compile_expr(node->right);
+                as.test(RAX);
+                as.set_eax(COND_NE);
+                as.bind(end_label);
+                return;
+            }
+
+            compile_operands(node);
+            switch (node->op) {
+                case BinaryOp::ADD:
+                    as.add(RAX, RCX);
+                    break;
+                case BinaryOp::SUB:
+                    as.sub(RAX, RCX);
+                    break;
+                case BinaryOp::MUL:
+                    as.imul(RAX, RCX);
+                    break;
+                case BinaryOp::DIV:
+                case BinaryOp::MOD: {
+                    // Round toward negative infinity like Python: when the
+                    // remainder is nonzero and its sign differs from the
+                    // divisor's, step the quotient down and the remainder into range
+                    int done = as.new_label();
+                    as.bytes({0x99, 0xf7, 0xf9});  // cdq; idiv ecx
+                    as.test(RDX);
+                    as.jcc(COND_E, done);
+                    as.mov(RSI, RDX);
+                    as.xor_(RSI, RCX);
+                    as.jcc(COND_NS, done);
+                    if (node->op == BinaryOp::DIV) {
+                        as.bytes({0xff, 0xc8});  // dec eax
+                    } else {
+                        as.add(RDX, RCX);
+                    }
+                    as.bind(done);
+                    if (node->op == BinaryOp::MOD) as.mov(RAX, RDX);
+                    break;
+                }
+                case BinaryOp::EQ:
+                case BinaryOp::NEQ:
+                case BinaryOp::GT:
+                case BinaryOp::LT:
+                case BinaryOp::GTE:
+                case BinaryOp::LTE: {
+                    static const Cond conditions[] = {COND_E, COND_G, COND_L, COND_GE, COND_LE, COND_NE};
+                    as.cmp(RAX, RCX);
+                    as.set_eax(conditions[static_cast<int>(node->op) - static_cast<int>(BinaryOp::EQ)]);
+                    break;
+                }
+                default:
+                    break;
+            }
+            return;
+        }
+
+        case NodeType::UNARY_OP: {
+            UnaryOpNode* node = static_cast<UnaryOpNode*>(expr);
+            compile_expr(node->operand);
+            if (node->op == UnaryOp::NEG) {
+                as.bytes({0xf7, 0xd8});  // neg eax
+            } else if (node->op == UnaryOp::NOT) {
+                as.test(RAX);
+                as.set_eax(COND_E);
+            }
+            return;
+        }
+
+        case NodeType::CALL:
+            compile_call(static_cast<CallNode*>(expr));
+            return;
+
+        default:
+            as.xor_(RAX, RAX);
+            return;
+    }
+}
+
+void FunctionCompiler::compile_stmt(StmtNode* stmt) {
+    switch (stmt->type) {
+        case NodeType::ASSIGN: {
+            AssignNode* node = static_cast<AssignNode*>(stmt);
+            int slot = locals.lookup(node->var_name);
+            if (node->value->type == NodeType::NEW_LIST) {
+                if (locals.list_length[slot] >= 0) {
+                    compile_new_list(static_cast<NewListNode*>(node->value), slot);
+                }
+                break;
+            }
+            if (locals.list_length[slot] >= 0) {
+                errors << "Error: list " << module.symbols->name(node->var_name) << " can only be assigned a new list\n";
+                break;
+            }
+            compile_expr(node->value);
+            as.store(disp(slot), RAX);
+            defined[slot] = true;
+            break;
+        }
+
+        case NodeType::INDEX_ASSIGN: {
+            IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+            // Python evaluates the value before the target
+            compile_expr(node->value);
+            as.push(RAX);
+            depth++;
+            bool valid = element(node->list_name, node->index);
+            as.pop(RCX);
+            depth--;
+            if (valid) {
+                as.bytes({0x89, 0x0c, 0x82});  // mov [rdx + rax * 4], ecx
+            }
+            break;
+        }
+
+        case NodeType::RETURN_STMT: {
+            ReturnNode* node = static_cast<ReturnNode*>(stmt);
+            if (in_parallel_body) {
+                errors << "Error: return inside a prange loop\n";
+                break;
+            }
+            if (node->value->type == NodeType::CALL &&
+                static_cast<CallNode*>(node->value)->function_name != SYM_PRINT) {
+                compile_tail_call(static_cast<CallNode*>(node->value));
+                break;
+            }
+            compile_expr(node->value);
+            as.jmp(epilogue_label);
+            terminated = true;
+            break;
+        }
+
+        case NodeType::IF_STMT: {
+            IfNode* node = static_cast<IfNode*>(stmt);
+            int else_label = as.new_label();
+            int end_label = as.new_label();
+            compile_expr(node->condition);
+            as.test(RAX);
+            as.jcc(COND_E, node->else_block.empty() ? end_label : else_label);
+
+            // Defined after the if: on any edge into its end
+            std::vector<bool> entry_defined = defined;
+            std::vector<bool> merged(defined.size(), false);
+            bool reachable = false;
+            auto merge = [&]() {
+                for (size_t slot = 0; slot < merged.size(); slot++) {
+                    merged[slot] = merged[slot] || defined[slot];
+                }
+                reachable = true;
+            };
+            if (node->else_block.empty()) merge();
+
+            compile_block(node->then_block);
+            if (!terminated) {
+                merge();
+                if (!node->else_block.empty()) as.jmp(end_label);
+            }
+            if (!node->else_block.empty()) {
+                defined = entry_defined;
+                terminated = false;
+                as.bind(else_label);
+                compile_block(node->else_block);
+                if (!terminated) merge();
+            }
+            as.bind(end_label);
+            defined = merged;
+            terminated = !reachable;
+            break;
+        }
+
+        case NodeType::WHILE_STMT: {
+            WhileNode* node = static_cast<WhileNode*>(stmt);
+            int cond_label = as.new_label();
+            int end_label = as.new_label();
+            // Like a loop header's phis, anything the body assigns counts as
+            // defined from the condition on
+            std::vector<bool> assigned(locals.size(), false);
+            locals.collect_assigned(node->body, assigned);
+            for (size_t slot = 0; slot < locals.size(); slot++) {
+                defined[slot] = defined[slot] || assigned[slot];
+            }
+            std::vector<bool> header_defined = defined;
+            as.bind(cond_label);
+            compile_expr(node->condition);
+            as.test(RAX);
+            as.jcc(COND_E, end_label);
+            compile_block(node->body);
+            if (!terminated) as.jmp(cond_label);
+            as.bind(end_label);
+            defined = header_defined;
+            terminated = false;
+            break;
+        }
+
+        case NodeType::FOR_RANGE_STMT:
+            compile_for_range(static_cast<ForRangeNode*>(stmt));
+            break;
+
+        case NodeType::EXPR_STMT:
+            compile_expr(static_cast<ExprStmtNode*>(stmt)->expr);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void FunctionCompiler::compile_block(const StmtList& stmts) {
+    for (StmtNode* stmt : stmts) {
+        if (terminated) continue;
+        compile_stmt(stmt);
+    }
+}
+
+// As with CodeGenerator, the range is evaluated once into an unsigned trip
+// count, and the loop variable is derived from an iteration counter. A prange
+// loop runs sequentially here, with the same rules: its private variables
+// are saved before it and restored after.
+void FunctionCompiler::compile_for_range(ForRangeNode* node) {
+    int var_slot = locals.lookup(node->var_name);
+    if (locals.list_length[var_slot] >= 0) {
+        errors << "Error: loop variable " << module.symbols->name(node->var_name) << " holds a list\n";
+        return;
+    }
+    int start_slot = new_slot();
+    int end_label = as.new_label();
+    compile_expr(node->start);
+    as.store(disp(start_slot), RAX);
+    compile_expr(node->stop);
+    if (!node->parallel || in_parallel_body) {
+        compile_counted_loop(node, var_slot, start_slot, end_label);
+        return;
+    }
+
+    ParallelLoop loop = analyze_parallel_loop(node, module.symbols->size());
+    auto report_carried = [&](Symbol name) {
+        errors << "Error: a prange loop in " << module.symbols->name(function->name) << " reads "
+               << module.symbols->name(name) << " before assigning it; its iterations only share "
+               << "reductions and the variables they do not assign\n";
+    };
+    if (!loop.carried.empty()) {
+        report_carried(loop.carried[0]);
+        return;
+    }
+    for (const auto& reduction : loop.reductions) {
+        if (!defined[locals.lookup(reduction.first)]) {
+            report_carried(reduction.first);
+            return;
+        }
+    }
+    std::vector<std::pair<int, int>> saved;   // (variable slot, hidden slot)
+    for (Symbol name : loop.privates) {
+        int slot = locals.lookup(name);
+        saved.push_back(std::make_pair(slot, new_slot()));
+        if (locals.list_length[slot] >= 0) saved.push_back(std::make_pair(locals.list_length[slot], new_slot()));
+    }
+    as.push(RAX);
+    depth++;
+    for (const auto& save : saved) {
+        as.load64(RAX, disp(save.first));
+        as.store64(disp(save.second), RAX);
+    }
+    as.pop(RAX);
+    depth--;
+
+    std::vector<bool> entry_defined = defined;
+    in_parallel_body = true;
+    compile_counted_loop(node, var_slot, start_slot, end_label);
+    in_parallel_body = false;
+    for (const auto& save : saved) {
+        as.load64(RAX, disp(save.second));
+        as.store64(disp(save.first), RAX);
+    }
+    defined = entry_defined;
+}
+
+// The loop for range(start, eax, step), with start already in start_slot;
+// end_label is bound at its exit
+void FunctionCompiler::compile_counted_loop(ForRangeNode* node, int var_slot, int start_slot, int end_label) {
+    int index_slot = new_slot();
+    int trip_slot = new_slot();
+    bool up = node->step > 0;
+    uint32_t magnitude = up ? static_cast<uint32_t>(node->step) : 0u - static_cast<uint32_t>(node->step);
+
+    // Trip count: |stop - start| rounded up to whole steps, if the range is not empty
+    as.load(RCX, disp(start_slot));
+    as.cmp(RCX, RAX);
+    as.jcc(up ? COND_GE : COND_LE, end_label);
+    if (up) {
+        as.sub(RAX, RCX);
+    } else {
+        as.sub(RCX, RAX);
+        as.mov(RAX, RCX);
+    }
+    if (magnitude != 1) {
+        as.bytes({0xff, 0xc8});  // dec eax
+        as.xor_(RDX, RDX);
+        as.mov_imm(RCX, static_cast<int32_t>(magnitude));
+        as.bytes({0xf7, 0xf1});  // div ecx
+        as.bytes({0xff, 0xc0});  // inc eax
+    }
+    as.store(disp(trip_slot), RAX);
+    as.xor_(RAX, RAX);
+    as.store(disp(index_slot), RAX);
+
+    std::vector<bool> entry_defined = defined;
+    std::vector<bool> assigned(locals.size(), false);
+    locals.collect_assigned(node->body, assigned);
+    for (size_t slot = 0; slot < locals.size(); slot++) {
+        defined[slot] = defined[slot] || assigned[slot];
+    }
+    defined[var_slot] = true;
+
+    int body_label = as.new_label();
+    as.bind(body_label);
+    as.load(RAX, disp(index_slot));
+    as.bytes({0x69, 0xc0});  // imul eax, eax, step
+    as.u32(static_cast<uint32_t>(node->step));
+    as.frame_op(false, 0x03, RAX, disp(start_slot));  // add eax, [start]
+    as.store(disp(var_slot), RAX);
+    compile_block(node->body);
+    bool has_backedge = !terminated;
+    if (has_backedge) {
+        as.load(RAX, disp(index_slot));
+        as.bytes({0xff, 0xc0});  // inc eax
+        as.store(disp(index_slot), RAX);
+        as.frame_op(false, 0x3b, RAX, disp(trip_slot));  // cmp eax, [trip]
+        as.jcc(COND_B, body_label);
+    }
+    as.bind(end_label);
+
+    // The loop is left from before it or from its last iteration
+    if (has_backedge) {
+        for (size_t slot = 0; slot < locals.size(); slot++) {
+            entry_defined[slot] = entry_defined[slot] || defined[slot];
+        }
+    }
+    defined = entry_defined;
+    terminated = false;
+}
+
+bool FunctionCompiler::compile(size_t function_index) {
+    index = function_index;
+    function = module.functions[index];
+    locals.assign(function, *module.symbols, errors);
+    defined.assign(locals.size(), false);
+    for (size_t i = 0; i < function->params.size(); i++) {
+        defined[i] = true;
+    }
+    uses_lists = locals.size() > locals.variables;
+    slot_count = static_cast<int>(locals.size());
+    mark_slot = uses_lists ? new_slot() : -1;
+    result_slot = new_slot();
+    size_t param_count = function->params.size();
+    memo_args_slot = -1;
+    if (function->memoize) {
+        // The lowest of these slots starts the array
+        for (size_t i = 0; i < (param_count + 1) / 2; i++) {
+            memo_args_slot = new_slot();
+        }
+    }
+    depth = 0;
+    terminated = false;
+    in_parallel_body = false;
+    index_error = false;
+    body_label = as.new_label();
+    epilogue_label = as.new_label();
+    index_error_label = as.new_label();
+
+    // Prologue: frame, zeroed variables, parameters into their slots
+    as.bytes({0x55, 0x48, 0x89, 0xe5});  // push rbp; mov rbp, rsp
+    size_t frame_size_at = as.code.size() + 3;
+    as.sub_rsp(0);
+    for (size_t slot = param_count; slot < locals.size(); slot++) {
+        as.frame_op(true, 0xc7, 0, disp(static_cast<int>(slot)));  // mov qword [slot], 0
+        as.u32(0);
+    }
+    for (size_t i = 0; i < param_count; i++) {
+        if (i < REG_ARGS) {
+            as.store(disp(static_cast<int>(i)), ARG_REGS[i]);
+        } else {
+            as.load(RAX, static_cast<int32_t>(16 + 8 * (i - REG_ARGS)));
+            as.store(disp(static_cast<int>(i)), RAX);
+        }
+    }
+
+    // A memoized function returns a recorded result straight away
+    int32_t memo_args = memo_args_slot >= 0 ? disp(memo_args_slot) : disp(result_slot);
+    auto memo_call = [&](Runtime runtime) {
+        as.lea_bss(RDI, module.memo_table[index]);
+        as.lea(RSI, memo_args);
+        as.mov_imm(RDX, static_cast<int32_t>(param_count));
+        as.call_runtime(runtime);
+    };
+    if (function->memoize) {
+        for (size_t i = 0; i < param_count; i++) {
+            as.load(RAX, disp(static_cast<int>(i)));
+            as.store(memo_args + static_cast<int32_t>(4 * i), RAX);
+        }
+        int miss = as.new_label();
+        as.lea(RCX, disp(result_slot));
+        memo_call(RT_MEMO_LOOKUP);
+        as.test(RAX);
+        as.jcc(COND_E, miss);
+        as.load(RAX, disp(result_slot));
+        as.bytes({0xc9, 0xc3});  // leave; ret
+        as.bind(miss);
+    }
+    if (uses_lists) {
+        as.call_runtime(RT_ARENA_SAVE);
+        as.store64(disp(mark_slot), RAX);
+    }
+
+    as.bind(body_label);
+    compile_block(function->body);
+    // Falling off the end returns None, which we model as 0
+    if (!terminated) as.xor_(RAX, RAX);
+
+    as.bind(epilogue_label);
+    if (uses_lists || function->memoize) {
+        as.store(disp(result_slot), RAX);
+        release_lists();
+        if (function->memoize) {
+            as.load(RCX, disp(result_slot));
+            memo_call(RT_MEMO_STORE);
+        }
+        as.load(RAX, disp(result_slot));
+    }
+    as.bytes({0xc9, 0xc3});  // leave; ret
+    if (index_error) {
+        as.bind(index_error_label);
+        as.bytes({0x48, 0x83, 0xe4, 0xf0});  // and rsp, -16
+        as.call_runtime(RT_INDEX_ERROR);
+    }
+    as.patch32(frame_size_at, static_cast<uint32_t>((8 * slot_count + 15) & ~15));
+
+    return !fatal;
+}
+
+void put16(std::string& out, uint16_t value) {
+    for (int i = 0; i < 2; i++) out += static_cast<char>(value >> (8 * i));
+}
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out += static_cast<char>(value >> (8 * i));
+}
+void put64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out += static_cast<char>(value >> (8 * i));
+}
+
+// Name offset of text in a string table, appending it
+uint32_t add_string(std::string& table, const char* text) {
+    uint32_t offset = static_cast<uint32_t>(table.size());
+    table += text;
+    table += '\0';
+    return offset;
+}
+
+// The ELF64 relocatable object for the module's code: .text, its
+// relocations, .bss for the memo tables, and a symbol table in which main is
+// the only global definition
+std::string write_elf(const Assembler& as, const ModuleInfo& module, const std::vector<size_t>& offsets,
+                      const std::vector<size_t>& sizes, size_t bss_size) {
+    enum { SEC_NULL, SEC_TEXT, SEC_RELA, SEC_BSS, SEC_STACK, SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_COUNT };
+    const uint8_t STB_LOCAL = 0, STB_GLOBAL = 1;
+    const uint8_t STT_NOTYPE = 0, STT_FUNC = 2, STT_SECTION = 3;
+
+    std::string strtab(1, '\0');
+    std::string symtab(24, '\0');
+    auto add_symbol = [&](uint32_t name, uint8_t bind, uint8_t type, uint16_t section, uint64_t value,
+                          uint64_t size) {
+        put32(symtab, name);
+        symtab += static_cast<char>(bind << 4 | type);
+        symtab += '\0';
+        put16(symtab, section);
+        put64(symtab, value);
+        put64(symtab, size);
+        return static_cast<uint32_t>(symtab.size() / 24 - 1);
+    };
+    add_symbol(0, STB_LOCAL, STT_SECTION, SEC_TEXT, 0, 0);
+    uint32_t bss_symbol = add_symbol(0, STB_LOCAL, STT_SECTION, SEC_BSS, 0, 0);
+    size_t main_index = module.functions.size();
+    for (size_t i = 0; i < module.functions.size(); i++) {
+        if (module.functions[i]->name == SYM_MAIN) {
+            main_index = i;
+            continue;
+        }
+        add_symbol(add_string(strtab, module.symbols->name(module.functions[i]->name)), STB_LOCAL, STT_FUNC, SEC_TEXT,
+                   offsets[i], sizes[i]);
+    }
+    uint32_t first_global = static_cast<uint32_t>(symtab.size() / 24);
+    if (main_index < module.functions.size()) {
+        add_symbol(add_string(strtab, "main"), STB_GLOBAL, STT_FUNC, SEC_TEXT, offsets[main_index],
+                   sizes[main_index]);
+    }
+    std::vector<uint32_t> runtime_symbol(RUNTIME_COUNT, 0);
+    for (const auto& call : as.runtime_calls) {
+        if (runtime_symbol[call.target] == 0) {
+            runtime_symbol[call.target] =
+                add_symbol(add_string(strtab, RUNTIME_NAMES[call.target]), STB_GLOBAL, STT_NOTYPE, 0, 0, 0);
+        }
+    }
+
+    std::string rela;
+    const uint32_t R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4;
+    for (const auto& call : as.runtime_calls) {
+        put64(rela, call.offset);
+        put64(rela, static_cast<uint64_t>(runtime_symbol[call.target]) << 32 | R_X86_64_PLT32);
+        put64(rela, static_cast<uint64_t>(-4));
+    }
+    for (const auto& ref : as.bss_refs) {
+        put64(rela, ref.offset);
+        put64(rela, static_cast<uint64_t>(bss_symbol) << 32 | R_X86_64_PC32);
+        put64(rela, static_cast<uint64_t>(static_cast<int64_t>(ref.target) - 4));
+    }
+
+    std::string shstrtab(1, '\0');
+    uint32_t names[SEC_COUNT] = {0};
+    const char* section_names[SEC_COUNT] = {"", ".text", ".rela.text", ".bss", ".note.GNU-stack",
+                                            ".symtab", ".strtab", ".shstrtab"};
+    for (int i = 1; i < SEC_COUNT; i++) {
+        names[i] = add_string(shstrtab, section_names[i]);
+    }
+
+    // Header, then the section contents, then the section headers
+    std::string out(64, '\0');
+    auto place = [&](const std::string& data, size_t alignment) {
+        while (out.size() % alignment != 0) out += '\0';
+        size_t offset = out.size();
+        out += data;
+        return offset;
+    };
+    size_t text_at = place(as.code, 16);
+    size_t rela_at = place(rela, 8);
+    size_t symtab_at = place(symtab, 8);
+    size_t strtab_at = place(strtab, 1);
+    size_t shstrtab_at = place(shstrtab, 1);
+    size_t headers_at = place(std::string(), 8);
+
+    auto section = [&](int index, uint32_t type, uint64_t flags, size_t offset, size_t size, uint32_t link,
+                       uint32_t info, uint64_t alignment, uint64_t entry_size) {
+        put32(out, names[index]);
+        put32(out, type);
+        put64(out, flags);
+        put64(out, 0);
+        put64(out, offset);
+        put64(out, size);
+        put32(out, link);
+        put32(out, info);
+        put64(out, alignment);
+        put64(out, entry_size);
+    };
+    const uint32_t SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_RELA = 4, SHT_NOBITS = 8;
+    const uint64_t SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4, SHF_INFO_LINK = 0x40;
+    out.append(64, '\0');
+    section(SEC_TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, text_at, as.code.size(), 0, 0, 16, 0);
+    section(SEC_RELA, SHT_RELA, SHF_INFO_LINK, rela_at, rela.size(), SEC_SYMTAB, SEC_TEXT, 8, 24);
+    section(SEC_BSS, SHT_NOBITS, SHF_WRITE | SHF_ALLOC, headers_at, bss_size, 0, 0, 8, 0);
+    section(SEC_STACK, SHT_PROGBITS, 0, headers_at, 0, 0, 0, 1, 0);
+    section(SEC_SYMTAB, SHT_SYMTAB, 0, symtab_at, symtab.size(), SEC_STRTAB, first_global, 8, 24);
+    section(SEC_STRTAB, SHT_STRTAB, 0, strtab_at, strtab.size(), 0, 0, 1, 0);
+    section(SEC_SHSTRTAB, SHT_STRTAB, 0, shstrtab_at, shstrtab.size(), 0, 0, 1, 0);
+
+    std::string header;
+    header += "\x7f" "ELF";
+    header += '\x02';  // 64-bit
+    header += '\x01';  // Little endian
+    header += '\x01';  // Version
+    header.append(9, '\0');
+    put16(header, 1);   // Relocatable
+    put16(header, 62);  // x86-64
+    put32(header, 1);
+    put64(header, 0);   // Entry
+    put64(header, 0);   // Program headers
+    put64(header, headers_at);
+    put32(header, 0);   // Flags
+    put16(header, 64);  // Header size
+    put16(header, 0);
+    put16(header, 0);
+    put16(header, 64);  // Section header size
+    put16(header, SEC_COUNT);
+    put16(header, SEC_SHSTRTAB);
+    out.replace(0, header.size(), header);
+    return out;
+}
+
+} // namespace
+
+int emit_object_fast(ProgramNode* program, const CodegenOptions& options, std::string& object_code,
+                     std::string& diagnostics) {
+    ModuleInfo module;
+    module.symbols = program->symbols;
+    module.function_index.assign(program->symbols->size(), -1);
+    size_t bss_size = 0;
+    bool ok = true;
+    for (FunctionDefNode* func : program->functions) {
+        if (module.function_index[func->name] >= 0) {
+            diagnostics += std::string("Error: function ") + module.symbols->name(func->name) + " is defined twice\n";
+            ok = false;
+            continue;
+        }
+        module.function_index[func->name] = static_cast<int>(module.functions.size());
+        module.functions.push_back(func);
+        module.memo_table.push_back(bss_size);
+        if (func->memoize) bss_size += 8;
+    }
+
+    Assembler as;
+    LocalSlots locals;
+    std::vector<size_t> offsets;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < module.functions.size(); i++) {
+        std::ostringstream errors;
+        std::ostringstream notes;
+        FunctionCompiler compiler(as, module, options, errors, notes, locals);
+        as.align(16);
+        offsets.push_back(as.code.size());
+        ok = compiler.compile(i) && ok;
+        sizes.push_back(as.code.size() - offsets.back());
+        diagnostics += errors.str();
+        if (options.report_tail_calls) diagnostics += notes.str();
+    }
+    if (!ok) return 1;
+    as.resolve(offsets);
+    object_code = write_elf(as, module, offsets, sizes, bss_size);
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef FAST_BACKEND_H
+#define FAST_BACKEND_H
+
+#include <string>
+#include "ast.h"
+#include "codegen.h"
+
+// --backend=fast: one pass over the AST writing x86-64 machine code straight
+// into an ELF relocatable object, with no IR and no LLVM. Every expression is
+// evaluated into eax with intermediate values on the stack and every variable
+// lives in the frame, so the code is several times slower than LLVM's but
+// takes microseconds to produce. Programs behave as with CodeGenerator and
+// get the same diagnostics, except that prange loops run sequentially and
+// profiles are not supported.
+//
+// Of options, only unbuffered_print and report_tail_calls apply. Returns
+// nonzero if the program calls a function it does not define or with the
+// wrong number of arguments; diagnostics are appended to diagnostics.
+int emit_object_fast(ProgramNode* program, const CodegenOptions& options, std::string& object_code,
+                     std::string& diagnostics);
+
+#endif // FAST_BACKEND_H
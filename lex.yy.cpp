@@ -0,0 +1,82 @@
+// Test-only hand-written stand-in for flex output (flex is unavailable here)
+#include <cstring>
+#include <string>
+#include "parser.tab.hpp"
+
+struct Scanner { ParseContext* ctx; const char* p; const char* end; int line; bool bol; const char* tok; int len; };
+
+static void indent(ParseContext* ctx, int spaces, int line) {
+    int cur = ctx->indent_depth == 0 ? 0 : ctx->indent_stack[ctx->indent_depth - 1];
+    if (spaces > cur) {
+        if (ctx->indent_depth == ParseContext::MAX_INDENT) { *ctx->errors << "Too many levels of indentation at line " << line << "\n"; return; }
+        ctx->indent_stack[ctx->indent_depth++] = spaces; ctx->push_pending(INDENT); }
+    else if (spaces < cur) {
+        while (ctx->indent_depth > 0 && ctx->indent_stack[ctx->indent_depth - 1] > spaces) { ctx->indent_depth--; ctx->push_pending(DEDENT); }
+        if (ctx->indent_depth > 0 && ctx->indent_stack[ctx->indent_depth - 1] != spaces) *ctx->errors << "Indentation error at line " << line << "\n";
+    }
+}
+char* yyget_text(yyscan_t s) { return const_cast<char*>(static_cast<Scanner*>(s)->tok); }
+int yyget_leng(yyscan_t s) { return static_cast<Scanner*>(s)->len; }
+int yyget_lineno(yyscan_t s) { return static_cast<Scanner*>(s)->line; }
+
+static int lex_orig(YYSTYPE* lv, Scanner* s) {
+    ParseContext* ctx = s->ctx;
+    for (;;) {
+        if (s->bol) {
+            const char* q = s->p; int spaces = 0;
+            while (q < s->end && (*q == ' ' || *q == '\t')) { spaces += *q == '\t' ? 4 : 1; q++; }
+            if (q < s->end && *q == '\n') { s->p = q + 1; s->line++; continue; }
+            if (q < s->end && *q == '#') { while (q < s->end && *q != '\n') q++; if (q < s->end) { s->p = q + 1; s->line++; continue; } }
+            if (q >= s->end) { s->p = q; s->bol = false; continue; }
+            s->p = q; s->bol = false;
+            indent(ctx, spaces, s->line);
+            if (int t = ctx->pop_pending()) return t;
+            continue;
+        }
+        if (s->p >= s->end) {
+            while (ctx->indent_depth > 0) { ctx->indent_depth--; ctx->push_pending(DEDENT); }
+            return ctx->pop_pending();
+        }
+        char c = *s->p; s->tok = s->p; s->len = 1;
+        if (c == '\n') { s->p++; s->line++; s->bol = true; return NEWLINE; }
+        if (c == ' ' || c == '\t') { s->p++; continue; }
+        if (c == '#') { while (s->p < s->end && *s->p != '\n') s->p++; continue; }
+        if (isalpha((unsigned char)c) || c == '_') {
+            const char* b = s->p; while (s->p < s->end && (isalnum((unsigned char)*s->p) || *s->p == '_')) s->p++;
+            std::string w(b, s->p);
+            static const struct { const char* k; int t; } kw[] = {{"def",DEF},{"return",RETURN},{"if",IF},{"elif",ELIF},{"else",ELSE},{"while",WHILE},{"for",FOR},{"in",IN},{"and",AND},{"or",OR},{"print",PRINT},{"import",IMPORT},{"from",FROM},{"__name__",NAME_VAR}};
+            for (auto& k : kw) if (w == k.k) return k.t;
+            s->len = s->p - b; lv->sym = ctx->symbols->intern(b, s->p - b); return IDENTIFIER;
+        }
+        if (isdigit((unsigned char)c)) { const char* b = s->p; while (s->p < s->end && isdigit((unsigned char)*s->p)) s->p++; lv->int_val = atoi(std::string(b, s->p).c_str()); return INTEGER; }
+        if (c == '"' || c == '\'') { const char* q = s->p + 1; while (q < s->end && *q != c) q++; s->p = q + 1; lv->sym = ctx->symbols->intern("__main__", 8); return STRING; }
+        s->p++;
+        if (s->p < s->end && *s->p == '=') {
+            switch (c) { case '=': s->p++; return EQ; case '!': s->p++; return NEQ; case '>': s->p++; return GTE; case '<': s->p++; return LTE; }
+        }
+        switch (c) {
+            case '>': return GT; case '<': return LT; case '=': return ASSIGN; case '+': return PLUS; case '-': return MINUS;
+            case '*': return MULTIPLY; case '/': return DIVIDE; case '%': return MODULO; case '(': return LPAREN; case ')': return RPAREN;
+            case '[': return LBRACKET; case ']': return RBRACKET; case ':': return COLON; case ',': return COMMA; case '.': return DOT; case '@': return AT;
+        }
+        *ctx->errors << "Unexpected character: '" << c << "' at line " << s->line << "\n";
+    }
+}
+
+int yylex_orig(YYSTYPE* lv, yyscan_t scanner) { return lex_orig(lv, static_cast<Scanner*>(scanner)); }
+int yylex(YYSTYPE* lv, yyscan_t scanner) {
+    Scanner* s = static_cast<Scanner*>(scanner);
+    if (int t = s->ctx->pop_pending()) return t;
+    return lex_orig(lv, s);
+}
+int begin_scan(char* source, size_t length, ParseContext& ctx, yyscan_t* scanner) {
+    if (source[length] || source[length + 1]) return 1;
+    ctx.source = source;
+    *scanner = new Scanner{&ctx, source, source + length, 1, true, source, 0};
+    return 0;
+}
+void end_scan(yyscan_t scanner) { delete static_cast<Scanner*>(scanner); }
+int parse_source(char* source, size_t length, ParseContext& ctx) {
+    yyscan_t s; if (begin_scan(source, length, ctx, &s)) return 1;
+    int r = yyparse(s, &ctx); end_scan(s); return r;
+}
@@ -0,0 +1,284 @@
+#include "llvm_backend.h"
+#include <csetjmp>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include "codegen.h"
+#include "runtime.h"
+
+// Incremental builds compile functions on several threads at once
+static void initialize_native_target() {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+}
+
+static llvm::CodeGenOpt::Level codegen_level(int opt_level) {
+    switch (opt_level) {
+        case 0: return llvm::CodeGenOpt::None;
+        case 1: return llvm::CodeGenOpt::Less;
+        case 3: return llvm::CodeGenOpt::Aggressive;
+        default: return llvm::CodeGenOpt::Default;
+    }
+}
+
+static llvm::OptimizationLevel pipeline_level(int opt_level) {
+    switch (opt_level) {
+        case 1: return llvm::OptimizationLevel::O1;
+        case 3: return llvm::OptimizationLevel::O3;
+        default: return llvm::OptimizationLevel::O2;
+    }
+}
+
+// Run the IR pipeline: the standard per-module pipeline for -O1..-O3 (SROA,
+// instcombine, GVN, LICM, unrolling, vectorization), only inlining at -O0,
+// or a custom one.
+static int optimize_module(llvm::Module& module, llvm::TargetMachine* machine,
+                           int opt_level, const std::string& custom_passes, std::ostream& errors) {
+    std::string passes = opt_level == 0 && custom_passes.empty() ? O0_PIPELINE : custom_passes;
+
+    // Analysis managers must outlive the pass manager that queries them
+    llvm::LoopAnalysisManager loop_am;
+    llvm::FunctionAnalysisManager function_am;
+    llvm::CGSCCAnalysisManager cgscc_am;
+    llvm::ModuleAnalysisManager module_am;
+
+    llvm::PassBuilder builder(machine);
+    builder.registerModuleAnalyses(module_am);
+    builder.registerCGSCCAnalyses(cgscc_am);
+    builder.registerFunctionAnalyses(function_am);
+    builder.registerLoopAnalyses(loop_am);
+    builder.crossRegisterProxies(loop_am, function_am, cgscc_am, module_am);
+
+    llvm::ModulePassManager pipeline;
+    if (!passes.empty()) {
+        if (llvm::Error err = builder.parsePassPipeline(pipeline, passes)) {
+            errors << "Error: invalid pass pipeline '" << passes << "': "
+                      << llvm::toString(std::move(err)) << "\n";
+            return 1;
+        }
+    } else {
+        pipeline = builder.buildPerModuleDefaultPipeline(pipeline_level(opt_level));
+    }
+    pipeline.run(module, module_am);
+    return 0;
+}
+
+// The module is read back from the text CodeGenerator prints, which is also
+// what --backend=llc and the cache work with, rather than built with
+// IRBuilder. Parsing costs about 30 ms per MB of IR (a 1000-function program
+// prints about 1 MB), a few percent of an -O0 compile and less at -O2.
+static std::unique_ptr<llvm::Module> parse_module(const std::string& ir_code, llvm::LLVMContext& context,
+                                                  std::ostream& errors) {
+    llvm::SMDiagnostic diag;
+    std::unique_ptr<llvm::Module> module = llvm::parseAssemblyString(ir_code, diag, context);
+    if (!module) {
+        std::string message;
+        llvm::raw_string_ostream os(message);
+        diag.print("pyc", os);
+        errors << "Error: invalid LLVM IR\n" << os.str();
+        return nullptr;
+    }
+
+    // llc verifies its input before codegen; keep the same guarantee here
+    std::string verify_message;
+    llvm::raw_string_ostream verify_os(verify_message);
+    if (llvm::verifyModule(*module, &verify_os)) {
+        errors << "Error: generated IR failed verification\n" << verify_os.str();
+        return nullptr;
+    }
+    return module;
+}
+
+int emit_object_in_process(const std::string& ir_code, std::string& object_code,
+                           int opt_level, const std::string& passes, std::ostream& errors) {
+    initialize_native_target();
+
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> module = parse_module(ir_code, context, errors);
+    if (!module) {
+        return 1;
+    }
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    std::string lookup_error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, lookup_error);
+    if (!target) {
+        errors << "Error: " << lookup_error << "\n";
+        return 1;
+    }
+
+    // Same defaults llc uses: generic CPU, target-default relocation model
+    llvm::TargetOptions options;
+    std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+        triple, "generic", "", options, llvm::Optional<llvm::Reloc::Model>(),
+        llvm::Optional<llvm::CodeModel::Model>(), codegen_level(opt_level)));
+    module->setTargetTriple(triple);
+    module->setDataLayout(machine->createDataLayout());
+
+    if (optimize_module(*module, machine.get(), opt_level, passes, errors) != 0) {
+        return 1;
+    }
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream os(buffer);
+    llvm::legacy::PassManager codegen_passes;
+    if (machine->addPassesToEmitFile(codegen_passes, os, nullptr, llvm::CGFT_ObjectFile)) {
+        errors << "Error: target cannot emit object files\n";
+        return 1;
+    }
+    codegen_passes.run(*module);
+
+    object_code.assign(buffer.data(), buffer.size());
+    return 0;
+}
+
+// Where a fatal runtime error in the program running on this thread returns to
+static thread_local std::jmp_buf* program_exit;
+static thread_local int program_status;
+
+[[noreturn]] static void leave_program(int status) {
+    program_status = status;
+    std::longjmp(*program_exit, 1);
+}
+
+// Call main and return its result, or the status of a fatal runtime error,
+// which releases the lists the program had made instead of exiting. No C++
+// frame lies between here and the error, so the longjmp skips no destructor.
+static int call_main(int (*main_function)()) {
+    std::jmp_buf exit_point;
+    program_exit = &exit_point;
+    void* arena_mark = pyc_arena_save();
+    pyc_set_error_handler(leave_program);
+    if (setjmp(exit_point) == 0) {
+        program_status = main_function();
+    } else {
+        pyc_arena_restore(arena_mark);
+    }
+    pyc_set_error_handler(nullptr);
+    return program_status;
+}
+
+int run_in_process(const std::string& ir_code, int opt_level, const std::string& passes,
+                   std::chrono::steady_clock::time_point start, double& startup_seconds,
+                   int& exit_code, std::ostream& errors) {
+    initialize_native_target();
+
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> machine_builder =
+        llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!machine_builder) {
+        errors << "Error: " << llvm::toString(machine_builder.takeError()) << "\n";
+        return 1;
+    }
+    machine_builder->setCodeGenOptLevel(codegen_level(opt_level));
+    llvm::Expected<std::unique_ptr<llvm::TargetMachine>> machine = machine_builder->createTargetMachine();
+    if (!machine) {
+        errors << "Error: " << llvm::toString(machine.takeError()) << "\n";
+        return 1;
+    }
+    llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> jit =
+        llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(*machine_builder).create();
+    if (!jit) {
+        errors << "Error: could not create JIT: " << llvm::toString(jit.takeError()) << "\n";
+        return 1;
+    }
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> module = parse_module(ir_code, *context, errors);
+    if (!module) {
+        return 1;
+    }
+    module->setTargetTriple((*jit)->getTargetTriple().str());
+    module->setDataLayout((*jit)->getDataLayout());
+    if (optimize_module(*module, machine->get(), opt_level, passes, errors) != 0) {
+        return 1;
+    }
+
+    // The runtime is linked into pyc itself; anything else the program needs
+    // comes from the host process
+    llvm::orc::MangleAndInterner mangle((*jit)->getExecutionSession(), (*jit)->getDataLayout());
+    llvm::orc::SymbolMap runtime;
+    runtime[mangle("pyc_print_i32")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_print_i32), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_print_i32_unbuffered")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_print_i32_unbuffered), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_profile_register")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_profile_register), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_arena_save")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_arena_save), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_arena_restore")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_arena_restore), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_list_alloc")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_list_alloc), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_index_error")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_index_error), llvm::JITSymbolFlags::Exported);
+    runtime[mangle("pyc_parallel_for")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&pyc_parallel_for), llvm::JITSymbolFlags::Exported);
+    if (llvm::Error err = (*jit)->getMainJITDylib().define(llvm::orc::absoluteSymbols(runtime))) {
+        errors << "Error: " << llvm::toString(std::move(err)) << "\n";
+        return 1;
+    }
+    llvm::Expected<std::unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> host_symbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            (*jit)->getDataLayout().getGlobalPrefix());
+    if (!host_symbols) {
+        errors << "Error: " << llvm::toString(host_symbols.takeError()) << "\n";
+        return 1;
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*host_symbols));
+
+    if (llvm::Error err = (*jit)->addIRModule(
+            llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+        errors << "Error: " << llvm::toString(std::move(err)) << "\n";
+        return 1;
+    }
+    // Looking main up is what actually compiles the module
+    llvm::Expected<llvm::JITEvaluatedSymbol> main_symbol = (*jit)->lookup("main");
+    if (!main_symbol) {
+        errors << "Error: " << llvm::toString(main_symbol.takeError()) << "\n";
+        return 1;
+    }
+
+    auto main_function = reinterpret_cast<int (*)()>(static_cast<uintptr_t>(main_symbol->getAddress()));
+    {
+        // Programs share the runtime's output buffer and profile list, so
+        // they run one at a time and leave them empty
+        static std::mutex running;
+        std::lock_guard<std::mutex> guard(running);
+        // Static constructors register profile counters
+        if (llvm::Error err = (*jit)->initialize((*jit)->getMainJITDylib())) {
+            errors << "Error: " << llvm::toString(std::move(err)) << "\n";
+            return 1;
+        }
+        startup_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        exit_code = call_main(main_function);
+        pyc_flush();
+        pyc_profile_write();
+    }
+    return 0;
+}
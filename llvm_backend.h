@@ -0,0 +1,29 @@
+#ifndef LLVM_BACKEND_H
+#define LLVM_BACKEND_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+// In-process LLVM backend: parses the generated IR text with the LLVM C++ API
+// and emits a native object file into memory, replacing the llc round-trip
+// (no files and no child process, though the text is still parsed).
+// Only available when pyc is built against LLVM (PYC_HAVE_LLVM).
+//
+// opt_level (0-3) selects both the IR pass pipeline and the codegen level,
+// mirroring `opt -O<n>` followed by `llc -O<n>`. A non-empty `passes` string
+// is parsed as a new-pass-manager pipeline (e.g. "sroa,instcombine,gvn") and
+// replaces the default pipeline for that level. Errors go to errors.
+int emit_object_in_process(const std::string& ir_code, std::string& object_code,
+                           int opt_level, const std::string& passes, std::ostream& errors);
+
+// JIT-compile the module with ORC LLJIT, resolving the runtime's and other
+// external symbols from the host process, and call its main(). startup_seconds is the
+// time from start until main's first instruction, static constructors included.
+// A fatal runtime error on the calling thread ends the program with exit_code
+// 1 rather than exiting the process; see pyc_set_error_handler.
+int run_in_process(const std::string& ir_code, int opt_level, const std::string& passes,
+                   std::chrono::steady_clock::time_point start, double& startup_seconds,
+                   int& exit_code, std::ostream& errors);
+
+#endif // LLVM_BACKEND_H
@@ -0,0 +1,121 @@
+#include "locals.h"
+
+void LocalSlots::assign(FunctionDefNode* func, const Interner& symbols, std::ostream& errors) {
+    current++;
+    names.clear();
+    for (Symbol param : func->params) {
+        declare(param);
+    }
+    declare_variables(func->body);
+    variables = names.size();
+    list_length.assign(variables, -1);
+    declare_lists(func->body, func->params.size(), symbols, errors);
+}
+
+int LocalSlots::declare(Symbol name) {
+    int existing = lookup(name);
+    if (existing >= 0) return existing;
+    if (name >= stamp.size()) {
+        stamp.resize(name + 1, 0);
+        slot.resize(name + 1, -1);
+    }
+    int index = static_cast<int>(names.size());
+    names.push_back(name);
+    slot[name] = index;
+    stamp[name] = current;
+    return index;
+}
+
+void LocalSlots::declare_variables(const StmtList& stmts) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                declare(static_cast<AssignNode*>(stmt)->var_name);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                declare_variables(node->then_block);
+                declare_variables(node->else_block);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                declare_variables(static_cast<WhileNode*>(stmt)->body);
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                declare(node->var_name);
+                declare_variables(node->body);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// Variables assigned [value] * length hold lists
+void LocalSlots::declare_lists(const StmtList& stmts, size_t params, const Interner& symbols,
+                               std::ostream& errors) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                if (node->value->type != NodeType::NEW_LIST) break;
+                int index = lookup(node->var_name);
+                if (list_length[index] >= 0) break;
+                if (static_cast<size_t>(index) < params) {
+                    errors << "Error: parameter " << symbols.name(node->var_name) << " cannot hold a list\n";
+                    break;
+                }
+                list_length[index] = static_cast<int>(names.size());
+                names.push_back(node->var_name);
+                list_length.push_back(-1);
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                declare_lists(node->then_block, params, symbols, errors);
+                declare_lists(node->else_block, params, symbols, errors);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                declare_lists(static_cast<WhileNode*>(stmt)->body, params, symbols, errors);
+                break;
+            case NodeType::FOR_RANGE_STMT:
+                declare_lists(static_cast<ForRangeNode*>(stmt)->body, params, symbols, errors);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void LocalSlots::collect_assigned(const StmtList& stmts, std::vector<bool>& assigned) const {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                int index = lookup(static_cast<AssignNode*>(stmt)->var_name);
+                assigned[index] = true;
+                if (list_length[index] >= 0) assigned[list_length[index]] = true;
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                collect_assigned(node->then_block, assigned);
+                collect_assigned(node->else_block, assigned);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                collect_assigned(static_cast<WhileNode*>(stmt)->body, assigned);
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                assigned[lookup(node->var_name)] = true;
+                collect_assigned(node->body, assigned);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
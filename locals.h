@@ -0,0 +1,42 @@
+#ifndef LOCALS_H
+#define LOCALS_H
+
+#include <ostream>
+#include <vector>
+#include "ast.h"
+
+// How a function's locals are numbered, shared by the LLVM and fast
+// backends so that they agree on which names are variables and which hold
+// lists. The parameters come first, then every other name the body assigns
+// (loop variables included) in source order, then a hidden slot for the
+// length of each variable that is assigned a new list.
+class LocalSlots {
+private:
+    // slot[name] is only valid where stamp[name] matches current, so
+    // numbering another function never has to clear them
+    std::vector<int> slot;
+    std::vector<unsigned> stamp;
+    unsigned current = 0;
+
+    int declare(Symbol name);
+    void declare_variables(const StmtList& stmts);
+    void declare_lists(const StmtList& stmts, size_t params, const Interner& symbols, std::ostream& errors);
+
+public:
+    std::vector<Symbol> names;       // Per slot; a length slot repeats its list's name
+    std::vector<int> list_length;    // Per slot: the slot of its length if it holds a list, else -1
+    size_t variables = 0;            // Slots before the length slots
+
+    // Number the locals of func, reporting parameters assigned a list to errors
+    void assign(FunctionDefNode* func, const Interner& symbols, std::ostream& errors);
+    // Slot of name in the function last numbered, or -1
+    int lookup(Symbol name) const {
+        return name < stamp.size() && stamp[name] == current ? slot[name] : -1;
+    }
+    size_t size() const { return names.size(); }
+    // Mark the slots assigned anywhere in stmts, nested blocks included,
+    // along with the lengths of the lists they make
+    void collect_assigned(const StmtList& stmts, std::vector<bool>& assigned) const;
+};
+
+#endif // LOCALS_H
@@ -1,72 +1,73 @@
 #include <iostream>
-#include <fstream>
+#include <iomanip>
 #include <string>
+#include <cstdio>
 #include <cstring>
-#include <unistd.h>
-#include <sys/wait.h>
-#include "ast.h"
-#include "codegen.h"
-
-extern FILE* yyin;
-extern int yyparse();
-extern ProgramNode* root;
-extern void reset_lexer();
-
-void print_usage(const char* prog_name) {
-    std::cerr << "Usage: " << prog_name << " <input.py> [-o output] [-c]\n";
-    std::cerr << "  -o <file>   Specify output file (default: a.out)\n";
-    std::cerr << "  -c          Generate object file instead of executable\n";
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include "pyc.h"
+
+// The command-line compiler is a thin client of libpyc (pyc.h)
+
+static std::atomic<uint64_t> allocations(0);
+
+// Count the allocations --time-report shows. Only the pyc command replaces
+// the global allocator; the library leaves its host's alone
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
 }
 
-int compile_llvm_ir(const std::string& ir_code, const std::string& output_file, bool object_only) {
-    // Write IR to temporary file
-    std::string ir_file = output_file + ".ll";
-    std::ofstream ir_out(ir_file);
-    if (!ir_out) {
-        std::cerr << "Error: Could not create IR file " << ir_file << std::endl;
-        return 1;
-    }
-    ir_out << ir_code;
-    ir_out.close();
-
-    if (object_only) {
-        // Compile to object file
-        std::string obj_file = output_file;
-        std::string cmd = "llc -filetype=obj " + ir_file + " -o " + obj_file;
-        int result = system(cmd.c_str());
-        if (result != 0) {
-            std::cerr << "Error: llc failed\n";
-            return 1;
-        }
-        std::cout << "Object file created: " << obj_file << std::endl;
-    } else {
-        // Compile to executable
-        std::string obj_file = output_file + ".o";
-        std::string cmd1 = "llc -filetype=obj " + ir_file + " -o " + obj_file;
-        int result = system(cmd1.c_str());
-        if (result != 0) {
-            std::cerr << "Error: llc failed\n";
-            return 1;
-        }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
 
-        // Link to create executable
-        std::string cmd2 = "gcc -no-pie " + obj_file + " -o " + output_file;
-        result = system(cmd2.c_str());
-        if (result != 0) {
-            std::cerr << "Error: gcc linking failed\n";
-            return 1;
-        }
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
 
-        // Clean up intermediate files
-        remove(obj_file.c_str());
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
 
-        std::cout << "Executable created: " << output_file << std::endl;
-    }
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
 
-    // Clean up IR file
-    remove(ir_file.c_str());
+static uint64_t count_allocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
 
-    return 0;
+void print_usage(const char* prog_name) {
+    std::cerr << "Usage: " << prog_name << " <input.py> [-o output] [-c] [-O0|-O1|-O2|-O3] [--backend=llvm|llc|fast]\n";
+    std::cerr << "  -o <file>   Specify output file (default: a.out)\n";
+    std::cerr << "  -c          Generate object file instead of executable\n";
+    std::cerr << "  -O<n>       Optimization level 0-3 (default: 0, no IR passes)\n";
+    std::cerr << "  -j <n>      Generate function bodies on n threads (default: 1, 0 = one per core)\n";
+    std::cerr << "  --no-ast-opt  Skip AST constant folding, simplification and dead-code elimination\n";
+    std::cerr << "  --opt-stats   Print AST optimizer statistics\n";
+    std::cerr << "  --arena-stats Print AST arena memory usage\n";
+    std::cerr << "  --time-report[=json]  Print time, peak memory and allocations per compiler phase\n";
+    std::cerr << "  --tail-call-report  List the calls turned into loops or guaranteed tail calls\n";
+    std::cerr << "  --passes=<pipeline>  Run a custom LLVM pass pipeline, e.g. \"sroa,instcombine,gvn\"\n";
+    std::cerr << "  --backend=llvm  Emit object code in-process via the LLVM API (default when built with LLVM)\n";
+    std::cerr << "  --backend=llc   Write a .ll file and run the external llc tool\n";
+    std::cerr << "  --backend=fast  Write x86-64 code directly, without LLVM: compiles in microseconds, runs slower\n";
+    std::cerr << "  --run       JIT-compile the program in memory and run it instead of writing a binary\n";
+    std::cerr << "  --unbuffered  Write each print() line out immediately instead of buffering output\n";
+    std::cerr << "  --static-runtime  Link a static executable with pyc's own minimal runtime and no C\n";
+    std::cerr << "                    library, for fast startup; prange loops run serially\n";
+    std::cerr << "  --profile-generate[=<file>]  Build a program that counts its branches and calls\n";
+    std::cerr << "                     and writes them to <file> (default: default.pycprof) at exit\n";
+    std::cerr << "  --profile-use=<file>  Optimize with the counts from a --profile-generate run\n";
+    std::cerr << "  --startup-time  With --run, report the time from compile start to main's first instruction\n";
+    std::cerr << "  --cache-dir=<dir>  Compile functions separately and reuse unchanged ones from\n";
+    std::cerr << "                     <dir> (default: $PYC_CACHE_DIR; empty disables the cache)\n";
 }
 
 int main(int argc, char** argv) {
@@ -78,6 +79,17 @@ int main(int argc, char** argv) {
     std::string input_file = argv[1];
     std::string output_file = "a.out";
     bool object_only = false;
+    bool opt_stats = false;
+    bool arena_stats = false;
+    bool run = false;
+    bool startup_time = false;
+    bool time_report = false;
+    bool time_report_json = false;
+    pyc::Options options;
+    set_allocation_counter(count_allocations);
+    options.use_llc = !pyc::has_llvm_backend();
+    const char* cache_env = getenv("PYC_CACHE_DIR");
+    options.cache_dir = cache_env ? cache_env : "";
 
     // Parse command-line arguments
     for (int i = 2; i < argc; i++) {
@@ -90,6 +102,66 @@ int main(int argc, char** argv) {
             output_file = argv[++i];
         } else if (strcmp(argv[i], "-c") == 0) {
             object_only = true;
+        } else if (strlen(argv[i]) == 3 && strncmp(argv[i], "-O", 2) == 0 &&
+                   argv[i][2] >= '0' && argv[i][2] <= '3') {
+            options.opt_level = argv[i][2] - '0';
+        } else if (strcmp(argv[i], "--run") == 0) {
+            run = true;
+        } else if (strcmp(argv[i], "--unbuffered") == 0) {
+            options.unbuffered_print = true;
+        } else if (strcmp(argv[i], "--static-runtime") == 0) {
+            options.static_runtime = true;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            options.profile_generate = "default.pycprof";
+        } else if (strncmp(argv[i], "--profile-generate=", 19) == 0) {
+            options.profile_generate = argv[i] + 19;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            options.profile_use = argv[i] + 14;
+        } else if (strcmp(argv[i], "--startup-time") == 0) {
+            startup_time = true;
+        } else if (strcmp(argv[i], "--no-ast-opt") == 0) {
+            options.ast_opt = false;
+        } else if (strcmp(argv[i], "--opt-stats") == 0) {
+            opt_stats = true;
+        } else if (strcmp(argv[i], "--arena-stats") == 0) {
+            arena_stats = true;
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            time_report = true;
+        } else if (strcmp(argv[i], "--time-report=json") == 0) {
+            time_report = true;
+            time_report_json = true;
+        } else if (strcmp(argv[i], "--tail-call-report") == 0) {
+            options.report_tail_calls = true;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char* count = argv[i] + 2;
+            if (*count == '\0') {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: -j requires an argument\n";
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                count = argv[++i];
+            }
+            options.jobs = static_cast<unsigned>(atoi(count));
+            if (options.jobs == 0) {
+                options.jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            options.passes = argv[i] + 9;
+        } else if (strncmp(argv[i], "--cache-dir=", 12) == 0) {
+            options.cache_dir = argv[i] + 12;
+        } else if (strcmp(argv[i], "--backend=llc") == 0) {
+            options.use_llc = true;
+            options.fast_backend = false;
+        } else if (strcmp(argv[i], "--backend=fast") == 0) {
+            options.fast_backend = true;
+        } else if (strcmp(argv[i], "--backend=llvm") == 0) {
+            if (!pyc::has_llvm_backend()) {
+                std::cerr << "Error: pyc was built without the LLVM library backend\n";
+                return 1;
+            }
+            options.use_llc = false;
+            options.fast_backend = false;
         } else {
             std::cerr << "Error: Unknown option " << argv[i] << "\n";
             print_usage(argv[0]);
@@ -97,49 +169,67 @@ int main(int argc, char** argv) {
         }
     }
 
-    // Open input file
-    yyin = fopen(input_file.c_str(), "r");
-    if (!yyin) {
+    // Map the input file; the scanner reads it in place
+    SourceBuffer source;
+    if (!source.load_file(input_file.c_str())) {
         std::cerr << "Error: Could not open input file " << input_file << std::endl;
         return 1;
     }
 
-    // Parse the input
-    reset_lexer();
-    int parse_result = yyparse();
-    fclose(yyin);
+    int exit_code = 0;
+    pyc::Result result = run ? pyc::run(source, options, exit_code)
+                             : pyc::compile(source, options);
+    std::cerr << result.diagnostics;
 
-    if (parse_result != 0) {
-        std::cerr << "Error: Parsing failed\n";
-        return 1;
+    if (opt_stats && options.ast_opt) {
+        result.opt_stats.print(std::cerr);
     }
-
-    if (!root) {
-        std::cerr << "Error: No program parsed\n";
+    if (arena_stats) {
+        std::cerr << "AST arena: " << result.arena_bytes_used << " bytes used, "
+                  << result.arena_bytes_reserved << " bytes reserved in "
+                  << result.arena_blocks << " blocks\n";
+    }
+    if (!options.cache_dir.empty() && (result.cache_hits || result.cache_misses)) {
+        std::cout << "Cache: " << result.cache_hits << (result.cache_hits == 1 ? " hit, " : " hits, ")
+                  << result.cache_misses << (result.cache_misses == 1 ? " miss" : " misses") << std::endl;
+    }
+    // Printed once everything, linking included, is done
+    auto report_time = [&]() {
+        if (!time_report) return;
+        std::fflush(stdout);
+        if (time_report_json) {
+            result.time_report.print_json(std::cerr);
+        } else {
+            result.time_report.print(std::cerr);
+        }
+    };
+    if (!result.success) {
+        report_time();
         return 1;
     }
 
-    // Check for main function
-    bool has_main = false;
-    for (auto& func : root->functions) {
-        if (func->name == "main") {
-            has_main = true;
-            break;
+    if (run) {
+        report_time();
+        if (startup_time) {
+            std::fflush(stdout);
+            std::cerr << "Time to first instruction: " << std::fixed << std::setprecision(2)
+                      << result.startup_seconds * 1000 << " ms\n";
         }
+        return exit_code;
     }
 
-    if (!has_main) {
-        std::cerr << "Error: Program must have a main() function\n";
+    std::string diagnostics;
+    PhaseTimer link_timer("link");
+    bool linked = object_only ? pyc::link_object(result.object, output_file, diagnostics, options.static_runtime)
+                              : pyc::link_executable(result.object, output_file, diagnostics,
+                                                     options.static_runtime);
+    result.time_report.phases.push_back(link_timer.stop());
+    if (!linked) {
+        std::cerr << diagnostics;
+        report_time();
         return 1;
     }
-
-    // Generate LLVM IR
-    CodeGenerator codegen;
-    std::string ir_code = codegen.generate(root);
-
-    // Compile to binary
-    int result = compile_llvm_ir(ir_code, output_file, object_only);
-
-    delete root;
-    return result;
+    std::cout << (object_only ? "Object file created: " : "Executable created: ") << output_file << std::endl;
+    report_time();
+    return 0;
 }
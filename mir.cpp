@@ -0,0 +1,600 @@
+#include "mir.h"
+#include "symbol.h"
+
+namespace mir {
+
+void Function::clear() {
+    prefix.clear();
+    attributes.clear();
+    params.clear();
+    counters.clear();
+    counter_count = 0;
+    insts.clear();
+    blocks.clear();
+    order.clear();
+    extra.clear();
+    constants.clear();
+    slots.clear();
+    layouts.clear();
+    globals.clear();
+    constant_ids.clear();
+}
+
+// Constants are interned, so equal constants are equal values
+Value Function::constant(int64_t value, Type type) {
+    uint64_t key = static_cast<uint64_t>(value) << 8 | static_cast<uint8_t>(type);
+    auto found = constant_ids.find(key);
+    if (found != constant_ids.end()) return found->second;
+    Value id = make_value(ValueKind::CONSTANT, static_cast<uint32_t>(constants.size()));
+    constants.push_back(Constant{value, type});
+    constant_ids.emplace(key, id);
+    return id;
+}
+
+Value Function::slot(bool env, uint32_t length_or_layout) {
+    slots.push_back(Slot{env, length_or_layout});
+    return make_value(ValueKind::SLOT, static_cast<uint32_t>(slots.size() - 1));
+}
+
+Value Function::global(const std::string& name) {
+    return global(Global{name, GlobalKind::FUNCTION, 0, std::string(), {NONE, NONE, NONE}});
+}
+
+Value Function::global(const Global& definition) {
+    globals.push_back(definition);
+    return make_value(ValueKind::GLOBAL, static_cast<uint32_t>(globals.size() - 1));
+}
+
+Value Function::call(Op op, Type type, uint32_t callee, const Value* args, uint32_t count, uint8_t flags) {
+    uint32_t at = static_cast<uint32_t>(extra.size());
+    extra.insert(extra.end(), args, args + count);
+    return emit(op, type, callee, at, count, NONE, flags);
+}
+
+Value Function::phi(Type type) {
+    return emit(Op::PHI, type, 0, 0);
+}
+
+void Function::set_incoming(Value phi, const std::vector<std::pair<Value, uint32_t>>& incoming) {
+    Inst& node = inst(phi);
+    node.a = static_cast<uint32_t>(extra.size());
+    node.b = static_cast<uint32_t>(incoming.size());
+    for (const auto& edge : incoming) {
+        extra.push_back(edge.first);
+        extra.push_back(edge.second);
+    }
+}
+
+uint32_t Function::branch_info(const BranchInfo& info) {
+    uint32_t at = static_cast<uint32_t>(extra.size());
+    extra.push_back(info.has_weights);
+    extra.push_back(info.taken);
+    extra.push_back(info.not_taken);
+    extra.push_back(info.loop_id);
+    return at;
+}
+
+uint32_t Function::new_block() {
+    blocks.push_back(Block{0, 0});
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void Function::start_block(uint32_t block) {
+    uint32_t here = static_cast<uint32_t>(insts.size());
+    if (!order.empty()) blocks[order.back()].end = here;
+    blocks[block].begin = here;
+    order.push_back(block);
+}
+
+void Function::finish() {
+    if (!order.empty()) blocks[order.back()].end = static_cast<uint32_t>(insts.size());
+}
+
+Type Function::type_of(Value value) const {
+    uint32_t index = value_index(value);
+    switch (value_kind(value)) {
+        case ValueKind::INST:
+            return insts[index].type;
+        case ValueKind::CONSTANT:
+            return constants[index].type;
+        case ValueKind::PARAM:
+            return params[index].type;
+        case ValueKind::SLOT:
+            return slots[index].env ? Type::ENV : Type::ARRAY;
+        case ValueKind::GLOBAL:
+            switch (globals[index].kind) {
+                case GlobalKind::FUNCTION: return Type::FUNCTION_PTR;
+                case GlobalKind::TABLE: return Type::ARRAY;
+                case GlobalKind::RECORD: return Type::RECORD;
+                default: return Type::VOID;
+            }
+    }
+    return Type::VOID;
+}
+
+namespace {
+
+const char* const RUNTIME_NAMES[] = {
+    "pyc_print_i32", "pyc_print_i32_unbuffered", "pyc_arena_save", "pyc_arena_restore",
+    "pyc_list_alloc", "pyc_index_error", "pyc_parallel_for", "pyc_profile_register"
+};
+const Type RUNTIME_RESULTS[] = {
+    Type::VOID, Type::VOID, Type::BYTES, Type::VOID, Type::PTR, Type::VOID, Type::VOID, Type::VOID
+};
+const char* const PREDICATES[] = {"eq", "ne", "slt", "sgt", "sle", "sge", "ult"};
+// Layout of struct pyc_profile_record (runtime.h)
+const char* const PROFILE_RECORD = "{ i8*, i8*, i64*, i32, i8* }";
+
+// LLVM string constant body with a terminating NUL
+std::string ir_string(const std::string& text) {
+    static const char* const hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text) {
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+            out += static_cast<char>(c);
+        } else {
+            out += '\\';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out + "\\00";
+}
+
+class Printer {
+public:
+    Printer(const Function& f, const Interner& symbols, std::string& out) : f(f), symbols(symbols), out(out) {}
+    void function();
+
+private:
+    const Function& f;
+    const Interner& symbols;
+    std::string& out;
+
+    void number(int64_t value) {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0) *--p = '-';
+        out.append(p, end);
+    }
+
+    void layout(uint32_t index) {
+        out += "{ ";
+        const std::vector<Type>& fields = f.layouts[index];
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (i > 0) out += ", ";
+            type(fields[i], 0);
+        }
+        out += " }";
+    }
+
+    // layout_or_length picks the struct of an ENV and the size of an ARRAY
+    void type(Type t, uint32_t layout_or_length) {
+        switch (t) {
+            case Type::VOID: out += "void"; break;
+            case Type::I1: out += "i1"; break;
+            case Type::I32: out += "i32"; break;
+            case Type::I64: out += "i64"; break;
+            case Type::PTR: out += "i32*"; break;
+            case Type::PTR_PTR: out += "i32**"; break;
+            case Type::BYTES: out += "i8*"; break;
+            case Type::PAIR: out += "{ i32, i1 }"; break;
+            case Type::ARRAY: array(layout_or_length); out += "*"; break;
+            case Type::ENV: layout(layout_or_length); out += "*"; break;
+            case Type::FUNCTION_PTR: out += "void (i8*, i32, i32)*"; break;
+            case Type::RECORD: out += PROFILE_RECORD; out += "*"; break;
+        }
+    }
+
+    void array(uint32_t length) {
+        out += "[";
+        number(length);
+        out += " x i32]";
+    }
+
+    // The layout of an ENV value or length of an ARRAY one
+    uint32_t detail(Value value) const {
+        uint32_t index = value_index(value);
+        if (value_kind(value) == ValueKind::SLOT) return f.slots[index].length_or_layout;
+        if (value_kind(value) == ValueKind::INST) return f.insts[index].b;
+        if (value_kind(value) == ValueKind::GLOBAL) return f.globals[index].length;
+        return 0;
+    }
+
+    void value_type(Value value) { type(f.type_of(value), detail(value)); }
+
+    void value(Value v) {
+        uint32_t index = value_index(v);
+        switch (value_kind(v)) {
+            case ValueKind::INST:
+                out += "%t";
+                number(index);
+                break;
+            case ValueKind::CONSTANT: {
+                const Constant& constant = f.constants[index];
+                if (constant.type == Type::I1) {
+                    out += constant.value ? "true" : "false";
+                } else if (constant.type == Type::PTR && constant.value == 0) {
+                    out += "null";
+                } else {
+                    number(constant.value);
+                }
+                break;
+            }
+            case ValueKind::PARAM:
+                out += f.params[index].name;
+                break;
+            case ValueKind::SLOT:
+                out += f.slots[index].env ? "%env" : "%list";
+                number(index);
+                break;
+            case ValueKind::GLOBAL:
+                out += "@";
+                out += f.globals[index].name;
+                break;
+        }
+    }
+
+    void typed(Value v) {
+        value_type(v);
+        out += " ";
+        value(v);
+    }
+
+    void label(uint32_t block) {
+        if (block == 0) {
+            out += "entry";
+        } else {
+            out += "label";
+            number(block);
+        }
+    }
+
+    void result(uint32_t index) {
+        out += "  %t";
+        number(index);
+        out += " = ";
+    }
+
+    void counter(uint32_t index) {
+        out += "getelementptr inbounds ([";
+        number(f.counter_count);
+        out += " x i64], [";
+        number(f.counter_count);
+        out += " x i64]* ";
+        out += f.counters;
+        out += ", i32 0, i32 ";
+        number(index);
+        out += ")";
+    }
+
+    void arguments(const Inst& inst) {
+        out += "(";
+        for (uint32_t i = 0; i < inst.c; i++) {
+            if (i > 0) out += ", ";
+            typed(f.extra[inst.b + i]);
+        }
+        out += ")";
+    }
+
+    // i8* or i64* to the first element of a STRING or COUNTERS global
+    void first_element(const Global& global) {
+        bool string = global.kind == GlobalKind::STRING;
+        std::string array = "[" + std::to_string(string ? global.text.size() + 1 : global.length) +
+                            (string ? " x i8]" : " x i64]");
+        out += string ? "i8* " : "i64* ";
+        out += "getelementptr inbounds (" + array + ", " + array + "* @" + global.name + ", i32 0, i32 0)";
+    }
+
+    void instruction(uint32_t index);
+    bool definition(const Global& global);
+};
+
+void Printer::instruction(uint32_t index) {
+    const Inst& inst = f.insts[index];
+    switch (inst.op) {
+        case Op::ADD: case Op::SUB: case Op::MUL: case Op::SDIV: case Op::SREM:
+        case Op::UDIV: case Op::AND: case Op::OR: case Op::XOR: case Op::LSHR: {
+            static const char* const names[] = {"add", "sub", "mul", "sdiv", "srem", "udiv", "and", "or", "xor", "lshr"};
+            result(index);
+            out += names[static_cast<int>(inst.op)];
+            if (inst.flags & NUW) out += " nuw";
+            if (inst.flags & NSW) out += " nsw";
+            out += " ";
+            type(inst.type, 0);
+            out += " ";
+            value(inst.a);
+            out += ", ";
+            value(inst.b);
+            break;
+        }
+        case Op::ICMP:
+            result(index);
+            out += "icmp ";
+            out += PREDICATES[static_cast<int>(inst.pred)];
+            out += " ";
+            typed(inst.a);
+            out += ", ";
+            value(inst.b);
+            break;
+        case Op::SELECT:
+            result(index);
+            out += "select i1 ";
+            value(inst.a);
+            out += ", ";
+            typed(inst.b);
+            out += ", ";
+            typed(inst.c);
+            break;
+        case Op::ZEXT:
+            result(index);
+            out += "zext ";
+            typed(inst.a);
+            out += " to ";
+            type(inst.type, 0);
+            break;
+        case Op::LOAD:
+            result(index);
+            out += "load ";
+            type(inst.type, 0);
+            out += ", ";
+            typed(inst.a);
+            if (inst.flags & ALIGN4) out += ", align 4";
+            break;
+        case Op::STORE:
+            out += "  store ";
+            typed(inst.a);
+            out += ", ";
+            typed(inst.b);
+            if (inst.flags & ALIGN4) out += ", align 4";
+            break;
+        case Op::ELEMENT:
+            result(index);
+            out += "getelementptr inbounds i32, i32* ";
+            value(inst.a);
+            out += ", i64 ";
+            value(inst.b);
+            break;
+        case Op::ARRAY: {
+            uint32_t length = detail(inst.a);
+            result(index);
+            out += "getelementptr inbounds ";
+            array(length);
+            out += ", ";
+            typed(inst.a);
+            out += ", i32 0, i32 0";
+            break;
+        }
+        case Op::FIELD:
+            result(index);
+            out += "getelementptr inbounds ";
+            layout(inst.b);
+            out += ", ";
+            typed(inst.a);
+            out += ", i32 0, i32 ";
+            number(inst.c);
+            break;
+        case Op::BITCAST:
+            result(index);
+            out += "bitcast ";
+            typed(inst.a);
+            out += " to ";
+            type(inst.type, inst.b);
+            break;
+        case Op::CALL:
+            result(index);
+            if (inst.flags & MUSTTAIL) out += "musttail ";
+            if (inst.flags & TAIL) out += "tail ";
+            out += "call i32 @";
+            out += symbols.name(inst.a);
+            if (inst.flags & IMPL) out += ".impl";
+            arguments(inst);
+            break;
+        case Op::CALL_RUNTIME: {
+            Type returns = RUNTIME_RESULTS[inst.a];
+            if (returns == Type::VOID) {
+                out += "  ";
+            } else {
+                result(index);
+            }
+            out += "call ";
+            type(returns, 0);
+            out += " @";
+            out += RUNTIME_NAMES[inst.a];
+            arguments(inst);
+            break;
+        }
+        case Op::ATOMIC_ADD:
+            out += "  atomicrmw add ";
+            typed(inst.a);
+            out += ", ";
+            typed(inst.b);
+            out += " monotonic";
+            break;
+        case Op::CMPXCHG:
+            result(index);
+            out += "cmpxchg ";
+            typed(inst.a);
+            out += ", ";
+            typed(inst.b);
+            out += ", ";
+            typed(inst.c);
+            out += " monotonic monotonic";
+            break;
+        case Op::EXTRACT:
+            result(index);
+            out += "extractvalue { i32, i1 } ";
+            value(inst.a);
+            out += ", ";
+            number(inst.b);
+            break;
+        case Op::COUNT:
+            out += "  %t";
+            number(index);
+            out += ".old = load i64, i64* ";
+            counter(inst.a);
+            out += "\n  %t";
+            number(index);
+            out += ".new = add i64 %t";
+            number(index);
+            out += ".old, ";
+            value(inst.b);
+            out += "\n  store i64 %t";
+            number(index);
+            out += ".new, i64* ";
+            counter(inst.a);
+            break;
+        case Op::PHI:
+            result(index);
+            out += "phi ";
+            type(inst.type, 0);
+            for (uint32_t i = 0; i < inst.b; i++) {
+                out += i > 0 ? ", [ " : " [ ";
+                value(f.extra[inst.a + 2 * i]);
+                out += ", %";
+                label(f.extra[inst.a + 2 * i + 1]);
+                out += " ]";
+            }
+            break;
+        case Op::BR:
+            out += "  br label %";
+            label(inst.a);
+            break;
+        case Op::BR_COND:
+            out += "  br i1 ";
+            value(inst.a);
+            out += ", label %";
+            label(inst.b);
+            out += ", label %";
+            label(inst.c);
+            if (inst.d != NONE) {
+                const uint32_t* info = &f.extra[inst.d];
+                if (info[0]) {
+                    out += ", !prof !{!\"branch_weights\", i32 ";
+                    number(info[1]);
+                    out += ", i32 ";
+                    number(info[2]);
+                    out += "}";
+                }
+                if (info[3] != NONE) {
+                    out += ", !llvm.loop !";
+                    number(info[3]);
+                }
+            }
+            break;
+        case Op::RET:
+            out += "  ret ";
+            if (inst.a == NONE) {
+                out += "void";
+            } else {
+                typed(inst.a);
+            }
+            break;
+        case Op::UNREACHABLE:
+            out += "  unreachable";
+            break;
+    }
+    out += "\n";
+}
+
+// Define global if the function is where it is defined; returns whether it was
+bool Printer::definition(const Global& global) {
+    if (global.kind == GlobalKind::FUNCTION) return false;
+    out += "@" + global.name;
+    switch (global.kind) {
+        case GlobalKind::FUNCTION:
+            break;
+        case GlobalKind::TABLE:
+            out += " = internal global ";
+            array(global.length);
+            out += " zeroinitializer\n";
+            break;
+        case GlobalKind::COUNTERS:
+            out += " = internal global [";
+            number(global.length);
+            out += " x i64] zeroinitializer\n";
+            break;
+        case GlobalKind::STRING:
+            out += " = private constant [";
+            number(static_cast<int64_t>(global.text.size() + 1));
+            out += " x i8] c\"" + ir_string(global.text) + "\"\n";
+            break;
+        case GlobalKind::RECORD: {
+            const Global& counters = f.globals[value_index(global.fields[2])];
+            out += " = internal global ";
+            out += PROFILE_RECORD;
+            out += " { ";
+            first_element(f.globals[value_index(global.fields[0])]);
+            out += ", ";
+            first_element(f.globals[value_index(global.fields[1])]);
+            out += ", ";
+            first_element(counters);
+            out += ", i32 ";
+            number(counters.length);
+            out += ", i8* null }\n";
+            break;
+        }
+    }
+    return true;
+}
+
+void Printer::function() {
+    // The globals the function defines come first
+    bool defined = false;
+    for (const Global& global : f.globals) {
+        if (definition(global)) defined = true;
+    }
+    if (defined) out += "\n";
+    out += f.prefix;
+    out += "(";
+    for (size_t i = 0; i < f.params.size(); i++) {
+        if (i > 0) out += ", ";
+        type(f.params[i].type, 0);
+        out += " ";
+        out += f.params[i].name;
+    }
+    out += ")";
+    out += f.attributes;
+    out += " {\n";
+    for (uint32_t block : f.order) {
+        label(block);
+        out += ":\n";
+        // The stack slots are all made on entry
+        if (block == 0) {
+            for (size_t i = 0; i < f.slots.size(); i++) {
+                Value slot = make_value(ValueKind::SLOT, static_cast<uint32_t>(i));
+                out += "  ";
+                value(slot);
+                out += " = alloca ";
+                if (f.slots[i].env) {
+                    layout(f.slots[i].length_or_layout);
+                } else {
+                    array(f.slots[i].length_or_layout);
+                    out += ", align 16";
+                }
+                out += "\n";
+            }
+        }
+        const Block& range = f.blocks[block];
+        // A block nothing can reach may have been left empty
+        if (range.begin == range.end) out += "  unreachable\n";
+        for (uint32_t i = range.begin; i < range.end; i++) {
+            instruction(i);
+        }
+    }
+    out += "}\n\n";
+}
+
+} // namespace
+
+void print(const Function& f, const Interner& symbols, std::string& out) {
+    Printer(f, symbols, out).function();
+}
+
+} // namespace mir
@@ -0,0 +1,210 @@
+#ifndef MIR_H
+#define MIR_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "symbol.h"
+
+// pyc's mid-level IR, which FunctionEmitter lowers function bodies, memo
+// wrappers and profile constructors to and print() turns into LLVM IR
+// text. A function is a flat array of fixed-size instructions. Values are
+// 32-bit IDs and basic blocks are ranges of the array, so building a
+// function costs no allocation per instruction, and passes can walk it and
+// patch it in place.
+namespace mir {
+
+enum class Type : uint8_t {
+    VOID, I1, I32, I64,
+    PTR,           // i32*: a list's data or one of its elements
+    PTR_PTR,       // i32**: a list field of a prange environment
+    BYTES,         // i8*
+    PAIR,          // { i32, i1 }, from CMPXCHG
+    ARRAY,         // A stack list slot
+    ENV,           // Pointer to a prange environment struct (see Function::layouts)
+    FUNCTION_PTR,  // void (i8*, i32, i32)*: a prange body
+    RECORD         // struct pyc_profile_record* (runtime.h)
+};
+
+// A value is a kind in the top bits and an index into the function's table
+// of that kind. Instructions that produce nothing still have a value ID.
+typedef uint32_t Value;
+const Value NONE = UINT32_MAX;
+
+enum class ValueKind : uint32_t { INST, CONSTANT, PARAM, SLOT, GLOBAL };
+const unsigned KIND_SHIFT = 28;
+inline Value make_value(ValueKind kind, uint32_t index) {
+    return static_cast<uint32_t>(kind) << KIND_SHIFT | index;
+}
+inline ValueKind value_kind(Value value) { return static_cast<ValueKind>(value >> KIND_SHIFT); }
+inline uint32_t value_index(Value value) { return value & ((1u << KIND_SHIFT) - 1); }
+
+enum class Op : uint8_t {
+    ADD, SUB, MUL, SDIV, SREM, UDIV, AND, OR, XOR, LSHR,  // a op b
+    ICMP,          // a pred b, on i32
+    SELECT,        // a ? b : c
+    ZEXT,          // a, to the result type
+    LOAD,          // *a
+    STORE,         // *b = a
+    ELEMENT,       // &a[b], a an i32* and b an i64
+    ARRAY,         // &a[0] for stack list slot or TABLE global a
+    FIELD,         // &a->field c, a an ENV of layout b
+    BITCAST,       // a as BYTES, or as an ENV of layout b
+    CALL,          // Function symbol a (its .impl with IMPL) with the c values at extra[b]
+    CALL_RUNTIME,  // Runtime function a with the c values at extra[b]
+    ATOMIC_ADD,    // *a += b
+    CMPXCHG,       // *a from b to c, giving the old value and whether it swapped
+    EXTRACT,       // Field b of PAIR a
+    COUNT,         // Profile counter a += b, an i64
+    PHI,           // b (value, block) pairs at extra[a]
+    BR,            // To block a
+    BR_COND,       // a ? block b : block c; d is NONE or the offset of a BranchInfo in extra
+    RET,           // a, or NONE for ret void
+    UNREACHABLE
+};
+
+enum class Pred : uint8_t { EQ, NE, SLT, SGT, SLE, SGE, ULT };
+
+enum Flags : uint8_t {
+    NUW = 1, NSW = 2,            // Arithmetic
+    ALIGN4 = 4,                  // Loads and stores of list elements
+    TAIL = 8, MUSTTAIL = 16,     // Calls
+    IMPL = 32                    // Calls: the body of a memoized function
+};
+
+enum class Runtime : uint32_t {
+    PRINT, PRINT_UNBUFFERED, ARENA_SAVE, ARENA_RESTORE, LIST_ALLOC, INDEX_ERROR, PARALLEL_FOR,
+    PROFILE_REGISTER
+};
+
+struct Inst {
+    Op op;
+    Type type;       // Of the result; VOID if there is none
+    Pred pred;
+    uint8_t flags;
+    uint32_t a, b, c, d;
+};
+
+// Profile data and loop metadata of a conditional branch, stored in extra
+struct BranchInfo {
+    uint32_t has_weights;
+    uint32_t taken;
+    uint32_t not_taken;
+    uint32_t loop_id;    // llvm.loop metadata ID, or NONE
+};
+
+struct Block {
+    uint32_t begin;
+    uint32_t end;        // Instructions [begin, end)
+};
+
+struct Constant {
+    int64_t value;
+    Type type;
+};
+
+struct Param {
+    std::string name;    // With its %
+    Type type;
+};
+
+// A stack allocation made on entry: a list of length ints, or the
+// environment struct of the given layout
+struct Slot {
+    bool env;
+    uint32_t length_or_layout;
+};
+
+// A global a function refers to. prange bodies are defined elsewhere in the
+// module; a function defines the other kinds itself, ahead of its code.
+enum class GlobalKind : uint8_t {
+    FUNCTION,      // A prange body, typed FUNCTION_PTR
+    TABLE,         // length ints, zeroed; typed ARRAY like a stack list
+    COUNTERS,      // length i64 profile counters, zeroed
+    STRING,        // text and a terminating NUL, constant
+    RECORD         // pyc_profile_record of the STRINGs fields[0] (file) and
+                   // fields[1] (function) and the COUNTERS fields[2]; typed RECORD
+};
+
+struct Global {
+    std::string name;    // Without the @
+    GlobalKind kind;
+    uint32_t length;
+    std::string text;
+    Value fields[3];
+};
+
+class Function {
+public:
+    std::string prefix;      // "define ... @name", up to the parameters
+    std::string attributes;  // Written after the parameters
+    std::vector<Param> params;
+    std::string counters;    // Global the COUNT instructions add to
+    uint32_t counter_count = 0;
+
+    std::vector<Inst> insts;
+    std::vector<Block> blocks;     // Indexed by block ID; blocks[0] is the entry
+    std::vector<uint32_t> order;   // Block IDs in layout order
+    std::vector<uint32_t> extra;   // Variable-length operands
+    std::vector<Constant> constants;
+    std::vector<Slot> slots;
+    std::vector<std::vector<Type>> layouts;  // Field types of environment structs
+    std::vector<Global> globals;
+
+    void clear();
+
+    Value constant(int64_t value, Type type = Type::I32);
+    Value param(uint32_t index) const { return make_value(ValueKind::PARAM, index); }
+    Value slot(bool env, uint32_t length_or_layout);
+    // A prange body
+    Value global(const std::string& name);
+    Value global(const Global& definition);
+
+    // Append an instruction to the current block
+    Value emit(Op op, Type type, uint32_t a = NONE, uint32_t b = NONE, uint32_t c = NONE,
+               uint32_t d = NONE, uint8_t flags = 0) {
+        insts.push_back(Inst{op, type, Pred::EQ, flags, a, b, c, d});
+        return make_value(ValueKind::INST, static_cast<uint32_t>(insts.size() - 1));
+    }
+    Value icmp(Pred pred, Value left, Value right) {
+        Value result = emit(Op::ICMP, Type::I1, left, right);
+        insts.back().pred = pred;
+        return result;
+    }
+    Value binary(Op op, Type type, Value left, Value right, uint8_t flags = 0) {
+        return emit(op, type, left, right, NONE, NONE, flags);
+    }
+    Value load(Type type, Value pointer, uint8_t flags = 0) {
+        return emit(Op::LOAD, type, pointer, NONE, NONE, NONE, flags);
+    }
+    void store(Value value, Value pointer, uint8_t flags = 0) {
+        emit(Op::STORE, Type::VOID, value, pointer, NONE, NONE, flags);
+    }
+    // Operands are stored in extra
+    Value call(Op op, Type type, uint32_t callee, const Value* args, uint32_t count, uint8_t flags = 0);
+    // A phi with no incoming values yet; set_incoming fills them in
+    Value phi(Type type);
+    void set_incoming(Value phi, const std::vector<std::pair<Value, uint32_t>>& incoming);
+    uint32_t branch_info(const BranchInfo& info);
+
+    uint32_t new_block();
+    // Later instructions go to block, after the previous one in the layout
+    void start_block(uint32_t block);
+    // Close the last block once everything is emitted
+    void finish();
+
+    Type type_of(Value value) const;
+    Inst& inst(Value value) { return insts[value_index(value)]; }
+    const Inst& inst(Value value) const { return insts[value_index(value)]; }
+
+private:
+    std::unordered_map<uint64_t, Value> constant_ids;
+};
+
+// Append f as an LLVM IR function definition to out; symbols names its callees
+void print(const Function& f, const Interner& symbols, std::string& out);
+
+} // namespace mir
+
+#endif // MIR_H
@@ -0,0 +1,281 @@
+#include "parallel.h"
+#include <algorithm>
+
+namespace {
+
+// Reads of each variable in expr, indexed by Symbol
+void count_reads(ExprNode* expr, std::vector<int>& reads) {
+    switch (expr->type) {
+        case NodeType::IDENTIFIER:
+            reads[static_cast<IdentifierNode*>(expr)->name]++;
+            break;
+        case NodeType::INDEX: {
+            IndexNode* node = static_cast<IndexNode*>(expr);
+            reads[node->list_name]++;
+            count_reads(node->index, reads);
+            break;
+        }
+        case NodeType::LEN:
+            reads[static_cast<LenNode*>(expr)->list_name]++;
+            break;
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            count_reads(node->left, reads);
+            count_reads(node->right, reads);
+            break;
+        }
+        case NodeType::UNARY_OP:
+            count_reads(static_cast<UnaryOpNode*>(expr)->operand, reads);
+            break;
+        case NodeType::CALL:
+            for (ExprNode* arg : static_cast<CallNode*>(expr)->args) count_reads(arg, reads);
+            break;
+        case NodeType::NEW_LIST: {
+            NewListNode* node = static_cast<NewListNode*>(expr);
+            count_reads(node->value, reads);
+            count_reads(node->length, reads);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void count_reads(const StmtList& stmts, std::vector<int>& reads) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                count_reads(static_cast<AssignNode*>(stmt)->value, reads);
+                break;
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                reads[node->list_name]++;
+                count_reads(node->index, reads);
+                count_reads(node->value, reads);
+                break;
+            }
+            case NodeType::RETURN_STMT:
+                count_reads(static_cast<ReturnNode*>(stmt)->value, reads);
+                break;
+            case NodeType::EXPR_STMT:
+                count_reads(static_cast<ExprStmtNode*>(stmt)->expr, reads);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                count_reads(node->condition, reads);
+                count_reads(node->then_block, reads);
+                count_reads(node->else_block, reads);
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                count_reads(node->condition, reads);
+                count_reads(node->body, reads);
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                count_reads(node->start, reads);
+                count_reads(node->stop, reads);
+                count_reads(node->body, reads);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// Variables assigned anywhere in stmts, loop variables included, in order
+void collect_assigned(const StmtList& stmts, std::vector<bool>& assigned, std::vector<Symbol>& order) {
+    auto assign = [&](Symbol name) {
+        if (!assigned[name]) {
+            assigned[name] = true;
+            order.push_back(name);
+        }
+    };
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN:
+                assign(static_cast<AssignNode*>(stmt)->var_name);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                collect_assigned(node->then_block, assigned, order);
+                collect_assigned(node->else_block, assigned, order);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                collect_assigned(static_cast<WhileNode*>(stmt)->body, assigned, order);
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                assign(node->var_name);
+                collect_assigned(node->body, assigned, order);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// True if expr combines name with other terms using op alone, + and - for
+// ADD or * for MUL, and name is not subtracted
+bool accumulates(ExprNode* expr, Symbol name, BinaryOp op) {
+    if (expr->type == NodeType::IDENTIFIER) {
+        return static_cast<IdentifierNode*>(expr)->name == name;
+    }
+    if (expr->type != NodeType::BINARY_OP) return false;
+    BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+    if (node->op == BinaryOp::SUB && op == BinaryOp::ADD) return accumulates(node->left, name, op);
+    if (node->op != op) return false;
+    return accumulates(node->left, name, op) || accumulates(node->right, name, op);
+}
+
+// True if every assignment to name in stmts accumulates into it, all with
+// the same op; count is the number of assignments, so the caller can check
+// that they are the only reads of name
+bool reduction_updates(const StmtList& stmts, Symbol name, BinaryOp& op, int& count) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                if (node->var_name != name) break;
+                BinaryOp combine = BinaryOp::ADD;
+                if (!accumulates(node->value, name, combine)) {
+                    combine = BinaryOp::MUL;
+                    if (!accumulates(node->value, name, combine)) return false;
+                }
+                if (count > 0 && combine != op) return false;
+                op = combine;
+                count++;
+                break;
+            }
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                if (!reduction_updates(node->then_block, name, op, count) ||
+                    !reduction_updates(node->else_block, name, op, count)) {
+                    return false;
+                }
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                if (!reduction_updates(static_cast<WhileNode*>(stmt)->body, name, op, count)) return false;
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                if (node->var_name == name) return false;
+                if (!reduction_updates(node->body, name, op, count)) return false;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// Variables stmts may read before assigning them. defined holds the
+// variables assigned on every path so far and is updated past stmts.
+void collect_exposed(const StmtList& stmts, std::vector<bool>& defined, std::vector<bool>& exposed) {
+    std::vector<int> reads(defined.size());
+    auto check = [&](ExprNode* expr) {
+        std::fill(reads.begin(), reads.end(), 0);
+        count_reads(expr, reads);
+        for (size_t name = 0; name < reads.size(); name++) {
+            if (reads[name] > 0 && !defined[name]) exposed[name] = true;
+        }
+    };
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::ASSIGN: {
+                AssignNode* node = static_cast<AssignNode*>(stmt);
+                check(node->value);
+                defined[node->var_name] = true;
+                break;
+            }
+            case NodeType::INDEX_ASSIGN: {
+                IndexAssignNode* node = static_cast<IndexAssignNode*>(stmt);
+                check(node->index);
+                check(node->value);
+                if (!defined[node->list_name]) exposed[node->list_name] = true;
+                break;
+            }
+            case NodeType::RETURN_STMT:
+                check(static_cast<ReturnNode*>(stmt)->value);
+                break;
+            case NodeType::EXPR_STMT:
+                check(static_cast<ExprStmtNode*>(stmt)->expr);
+                break;
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                check(node->condition);
+                std::vector<bool> then_defined = defined;
+                collect_exposed(node->then_block, then_defined, exposed);
+                collect_exposed(node->else_block, defined, exposed);
+                for (size_t name = 0; name < defined.size(); name++) {
+                    defined[name] = defined[name] && then_defined[name];
+                }
+                break;
+            }
+            case NodeType::WHILE_STMT: {
+                WhileNode* node = static_cast<WhileNode*>(stmt);
+                check(node->condition);
+                std::vector<bool> body_defined = defined;
+                collect_exposed(node->body, body_defined, exposed);
+                break;
+            }
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                check(node->start);
+                check(node->stop);
+                std::vector<bool> body_defined = defined;
+                body_defined[node->var_name] = true;
+                collect_exposed(node->body, body_defined, exposed);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+} // namespace
+
+ParallelLoop analyze_parallel_loop(ForRangeNode* loop, size_t symbol_count) {
+    size_t count = symbol_count;
+    std::vector<int> reads(count, 0);
+    count_reads(loop->body, reads);
+    std::vector<bool> assigned(count, false);
+    std::vector<Symbol> order;
+    assigned[loop->var_name] = true;
+    order.push_back(loop->var_name);
+    collect_assigned(loop->body, assigned, order);
+
+    ParallelLoop result;
+    for (size_t name = 0; name < count; name++) {
+        if (reads[name] > 0 && !assigned[name]) result.inputs.push_back(static_cast<Symbol>(name));
+    }
+    std::vector<bool> reduction(count, false);
+    for (Symbol name : order) {
+        BinaryOp op = BinaryOp::ADD;
+        int updates = 0;
+        if (name != loop->var_name && reduction_updates(loop->body, name, op, updates) &&
+            updates == reads[name]) {
+            result.reductions.push_back(std::make_pair(name, op));
+            reduction[name] = true;
+        } else {
+            result.privates.push_back(name);
+        }
+    }
+
+    std::vector<bool> defined(count, false);
+    std::vector<bool> exposed(count, false);
+    defined[loop->var_name] = true;
+    collect_exposed(loop->body, defined, exposed);
+    for (Symbol name : result.privates) {
+        if (exposed[name]) result.carried.push_back(name);
+    }
+    return result;
+}
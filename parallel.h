@@ -0,0 +1,26 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <utility>
+#include <vector>
+#include "ast.h"
+
+// How the iterations of a prange loop use the variables of their function,
+// from the loop's body alone. Iterations share the variables the body reads
+// but never assigns, and reductions: variables the body only updates with
+// v = v + e, v - e or v * e (all with + and -, or all with *) and reads
+// nowhere else. Every other variable the body assigns, the loop variable
+// included, is private to an iteration, so the body must assign it before
+// reading it. A list counts as one variable.
+struct ParallelLoop {
+    std::vector<Symbol> inputs;       // Read but never assigned
+    // Each with the operation that combines partial results, ADD or MUL
+    std::vector<std::pair<Symbol, BinaryOp>> reductions;
+    std::vector<Symbol> privates;
+    std::vector<Symbol> carried;      // Privates the body may read before assigning
+};
+
+// symbol_count is the size of the program's symbol table
+ParallelLoop analyze_parallel_loop(ForRangeNode* loop, size_t symbol_count);
+
+#endif // PARALLEL_H
@@ -0,0 +1,2073 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 2
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 55 "parser.y"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <utility>
+#include "ast.h"
+
+#line 78 "parser.tab.cpp"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+#include "parser.tab.hpp"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_INTEGER = 3,                    /* INTEGER  */
+  YYSYMBOL_IDENTIFIER = 4,                 /* IDENTIFIER  */
+  YYSYMBOL_STRING = 5,                     /* STRING  */
+  YYSYMBOL_MAIN_STR = 6,                   /* MAIN_STR  */
+  YYSYMBOL_DEF = 7,                        /* DEF  */
+  YYSYMBOL_RETURN = 8,                     /* RETURN  */
+  YYSYMBOL_IF = 9,                         /* IF  */
+  YYSYMBOL_ELIF = 10,                      /* ELIF  */
+  YYSYMBOL_ELSE = 11,                      /* ELSE  */
+  YYSYMBOL_WHILE = 12,                     /* WHILE  */
+  YYSYMBOL_FOR = 13,                       /* FOR  */
+  YYSYMBOL_IN = 14,                        /* IN  */
+  YYSYMBOL_AND = 15,                       /* AND  */
+  YYSYMBOL_OR = 16,                        /* OR  */
+  YYSYMBOL_PRINT = 17,                     /* PRINT  */
+  YYSYMBOL_NAME_VAR = 18,                  /* NAME_VAR  */
+  YYSYMBOL_IMPORT = 19,                    /* IMPORT  */
+  YYSYMBOL_FROM = 20,                      /* FROM  */
+  YYSYMBOL_EQ = 21,                        /* EQ  */
+  YYSYMBOL_NEQ = 22,                       /* NEQ  */
+  YYSYMBOL_GT = 23,                        /* GT  */
+  YYSYMBOL_LT = 24,                        /* LT  */
+  YYSYMBOL_GTE = 25,                       /* GTE  */
+  YYSYMBOL_LTE = 26,                       /* LTE  */
+  YYSYMBOL_ASSIGN = 27,                    /* ASSIGN  */
+  YYSYMBOL_PLUS = 28,                      /* PLUS  */
+  YYSYMBOL_MINUS = 29,                     /* MINUS  */
+  YYSYMBOL_MULTIPLY = 30,                  /* MULTIPLY  */
+  YYSYMBOL_DIVIDE = 31,                    /* DIVIDE  */
+  YYSYMBOL_MODULO = 32,                    /* MODULO  */
+  YYSYMBOL_LPAREN = 33,                    /* LPAREN  */
+  YYSYMBOL_RPAREN = 34,                    /* RPAREN  */
+  YYSYMBOL_LBRACKET = 35,                  /* LBRACKET  */
+  YYSYMBOL_RBRACKET = 36,                  /* RBRACKET  */
+  YYSYMBOL_COLON = 37,                     /* COLON  */
+  YYSYMBOL_COMMA = 38,                     /* COMMA  */
+  YYSYMBOL_DOT = 39,                       /* DOT  */
+  YYSYMBOL_AT = 40,                        /* AT  */
+  YYSYMBOL_NEWLINE = 41,                   /* NEWLINE  */
+  YYSYMBOL_INDENT = 42,                    /* INDENT  */
+  YYSYMBOL_DEDENT = 43,                    /* DEDENT  */
+  YYSYMBOL_UNEG = 44,                      /* UNEG  */
+  YYSYMBOL_UNOT = 45,                      /* UNOT  */
+  YYSYMBOL_YYACCEPT = 46,                  /* $accept  */
+  YYSYMBOL_program = 47,                   /* program  */
+  YYSYMBOL_imports = 48,                   /* imports  */
+  YYSYMBOL_import_statement = 49,          /* import_statement  */
+  YYSYMBOL_import_names = 50,              /* import_names  */
+  YYSYMBOL_if_main_block = 51,             /* if_main_block  */
+  YYSYMBOL_function_list = 52,             /* function_list  */
+  YYSYMBOL_function_def = 53,              /* function_def  */
+  YYSYMBOL_decorators = 54,                /* decorators  */
+  YYSYMBOL_decorator = 55,                 /* decorator  */
+  YYSYMBOL_decorator_name = 56,            /* decorator_name  */
+  YYSYMBOL_plain_function_def = 57,        /* plain_function_def  */
+  YYSYMBOL_parameters = 58,                /* parameters  */
+  YYSYMBOL_statements = 59,                /* statements  */
+  YYSYMBOL_statement = 60,                 /* statement  */
+  YYSYMBOL_assignment = 61,                /* assignment  */
+  YYSYMBOL_return_statement = 62,          /* return_statement  */
+  YYSYMBOL_if_statement = 63,              /* if_statement  */
+  YYSYMBOL_while_statement = 64,           /* while_statement  */
+  YYSYMBOL_for_statement = 65,             /* for_statement  */
+  YYSYMBOL_expr_statement = 66,            /* expr_statement  */
+  YYSYMBOL_expression = 67,                /* expression  */
+  YYSYMBOL_logical_or = 68,                /* logical_or  */
+  YYSYMBOL_logical_and = 69,               /* logical_and  */
+  YYSYMBOL_comparison = 70,                /* comparison  */
+  YYSYMBOL_term = 71,                      /* term  */
+  YYSYMBOL_factor = 72,                    /* factor  */
+  YYSYMBOL_primary = 73,                   /* primary  */
+  YYSYMBOL_arguments = 74                  /* arguments  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+/* Unqualified %code blocks.  */
+#line 66 "parser.y"
+
+int yyget_lineno(yyscan_t scanner);
+void yyerror(yyscan_t scanner, ParseContext* ctx, const char* s);
+
+// AST nodes and the parser's list values all live in the parse's arena
+template<typename T, typename... Args>
+static T* node(ParseContext* ctx, Args&&... args) {
+    return ctx->arena->make<T>(std::forward<Args>(args)...);
+}
+
+template<typename T>
+static ArenaList<T>* new_list(ParseContext* ctx) {
+    return ctx->arena->make<ArenaList<T>>(ctx->arena);
+}
+
+// Value of an integer literal, possibly negated
+static bool literal_value(ExprNode* expr, int* value) {
+    if (expr->type == NodeType::INTEGER) {
+        *value = static_cast<IntegerNode*>(expr)->value;
+        return true;
+    }
+    if (expr->type == NodeType::UNARY_OP && static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NEG &&
+        literal_value(static_cast<UnaryOpNode*>(expr)->operand, value)) {
+        *value = static_cast<int>(0u - static_cast<unsigned>(*value));
+        return true;
+    }
+    return false;
+}
+
+#line 217 "parser.tab.cpp"
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  18
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   256
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  46
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  29
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  78
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  186
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   300
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
+      45
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
+{
+       0,   137,   137,   141,   145,   149,   158,   159,   163,   169,
+     178,   179,   183,   187,   191,   195,   199,   202,   208,   209,
+     218,   219,   223,   224,   225,   229,   236,   247,   250,   256,
+     260,   267,   271,   275,   281,   282,   283,   284,   285,   286,
+     290,   293,   296,   302,   305,   311,   314,   320,   328,   351,
+     357,   361,   362,   368,   369,   375,   376,   379,   382,   385,
+     388,   391,   397,   398,   401,   407,   408,   411,   414,   420,
+     423,   426,   429,   440,   443,   448,   451,   457,   461
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "INTEGER",
+  "IDENTIFIER", "STRING", "MAIN_STR", "DEF", "RETURN", "IF", "ELIF",
+  "ELSE", "WHILE", "FOR", "IN", "AND", "OR", "PRINT", "NAME_VAR", "IMPORT",
+  "FROM", "EQ", "NEQ", "GT", "LT", "GTE", "LTE", "ASSIGN", "PLUS", "MINUS",
+  "MULTIPLY", "DIVIDE", "MODULO", "LPAREN", "RPAREN", "LBRACKET",
+  "RBRACKET", "COLON", "COMMA", "DOT", "AT", "NEWLINE", "INDENT", "DEDENT",
+  "UNEG", "UNOT", "$accept", "program", "imports", "import_statement",
+  "import_names", "if_main_block", "function_list", "function_def",
+  "decorators", "decorator", "decorator_name", "plain_function_def",
+  "parameters", "statements", "statement", "assignment",
+  "return_statement", "if_statement", "while_statement", "for_statement",
+  "expr_statement", "expression", "logical_or", "logical_and",
+  "comparison", "term", "factor", "primary", "arguments", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-101)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-1)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
+{
+      -1,     5,    11,    51,    53,    59,    -1,    20,    -5,  -101,
+       1,  -101,  -101,    44,  -101,    63,    52,   -28,  -101,    45,
+      -5,  -101,    75,  -101,     1,  -101,  -101,  -101,  -101,     8,
+      96,   100,    13,  -101,  -101,  -101,    84,  -101,  -101,    72,
+     -24,  -101,    80,  -101,    83,    79,   117,    82,    87,   124,
+     128,   209,  -101,    99,    98,    97,  -101,  -101,  -101,    15,
+     108,   209,   209,   112,   126,   135,  -101,   225,     2,  -101,
+     113,   212,   114,    68,   209,   209,  -101,   125,   119,   209,
+     209,   209,   209,   209,   209,   209,   209,   209,   209,   209,
+     209,   209,   116,    27,   209,   209,   209,   160,    86,  -101,
+     127,   131,  -101,  -101,  -101,   133,  -101,   212,  -101,  -101,
+     -18,   141,   142,  -101,  -101,   135,  -101,    47,    47,    47,
+      47,    47,    47,     2,     2,  -101,  -101,  -101,   212,    23,
+     209,  -101,   145,   149,   164,  -101,  -101,  -101,  -101,  -101,
+    -101,   104,  -101,   209,  -101,  -101,   122,   209,  -101,   154,
+     151,   153,   191,  -101,  -101,  -101,   168,   169,   166,   172,
+     167,   180,   209,   212,   212,   209,   209,  -101,   140,   158,
+     -13,  -101,   207,  -101,   185,   193,   187,   190,   192,   197,
+     212,   212,   176,   194,  -101,  -101
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
+{
+       0,     0,     0,     0,     0,     0,     0,     0,     2,    13,
+       0,    20,    18,     0,     8,     0,    25,     0,     1,     0,
+       4,     6,     0,    16,    17,     3,    15,    21,    19,     0,
+       0,     0,     0,    22,     7,     5,     0,    14,    29,     0,
+       0,    10,     9,    26,     0,     0,     0,     0,     0,     0,
+       0,     0,    23,     0,     0,     0,    30,    11,    69,    70,
+       0,     0,     0,     0,    50,    51,    53,    55,    62,    65,
+       0,     0,     0,     0,     0,     0,    76,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,    70,    44,     0,     0,     0,     0,    31,
+       0,     0,    36,    37,    38,     0,    49,     0,    73,    77,
+       0,     0,     0,    75,    24,    52,    54,    56,    57,    58,
+      59,    60,    61,    63,    64,    66,    67,    68,     0,     0,
+       0,    43,     0,     0,     0,    33,    28,    32,    34,    35,
+      39,     0,    72,     0,    71,    74,     0,     0,    40,     0,
+       0,     0,     0,    27,    78,    12,     0,    71,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,    42,     0,     0,
+       0,    41,    45,    47,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,    48,    46
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
+{
+    -101,  -101,  -101,   226,  -101,   213,   230,    29,  -101,   233,
+    -101,   234,  -101,  -100,   -95,  -101,  -101,  -101,  -101,  -101,
+    -101,   -51,  -101,   161,   175,   -16,    -4,   -60,    91
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int8 yydefgoto[] =
+{
+       0,     5,     6,     7,    42,    25,     8,     9,    10,    11,
+      17,    12,    40,    98,    99,   100,   101,   102,   103,   104,
+     105,   106,    64,    65,    66,    67,    68,    69,   110
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_uint8 yytable[] =
+{
+      63,    76,     1,   137,    22,    32,     1,   141,     1,    13,
+      48,    77,    38,    33,    49,    14,   142,    44,     2,     3,
+     143,   174,   109,   111,   112,   143,    58,    59,   146,   125,
+     126,   127,    89,    90,    91,     4,    23,    26,    24,     4,
+      60,     4,    39,   131,   132,   133,   137,    45,    73,    26,
+      74,   137,    61,    37,   129,    15,    62,    16,   147,    18,
+      73,    21,   130,   168,   169,   117,   118,   119,   120,   121,
+     122,    58,    59,   137,   137,    87,    88,    29,   148,   149,
+     182,   183,    30,   123,   124,    60,    34,   137,   137,    58,
+      93,    31,   154,    36,    94,    95,   156,    61,    96,    97,
+      41,    62,   108,    60,    43,    46,   171,    58,    93,    47,
+      51,   167,    94,    95,   109,    61,    96,    97,    50,    62,
+      52,    60,    53,    54,    55,    58,    93,   135,    56,   136,
+      94,    95,    57,    61,    96,    97,    70,    62,    72,    60,
+      71,    75,    79,    58,    93,   135,    78,   153,    94,    95,
+      80,    61,    96,    97,    92,    62,   107,    60,   128,   113,
+     114,    58,    93,   135,   134,   155,    94,    95,   138,    61,
+      96,    97,   139,    62,   140,    60,   145,   144,   152,    58,
+      93,   135,   150,   172,    94,    95,   151,    61,    96,    97,
+     157,    62,   158,    60,   159,   160,   162,    58,    93,   135,
+     165,   173,    94,    95,   161,    61,    96,    97,   163,    62,
+     166,    60,    58,    59,   164,    58,    93,   135,   175,   184,
+      94,    95,   176,    61,    96,    97,    60,    62,   178,    60,
+     177,   179,    19,    35,   180,   135,    20,   185,    61,   181,
+     115,    61,    62,    27,    28,    62,    81,    82,    83,    84,
+      85,    86,     0,    87,    88,   116,   170
+};
+
+static const yytype_int16 yycheck[] =
+{
+      51,    61,     7,    98,     9,    33,     7,   107,     7,     4,
+      34,    62,     4,    41,    38,     4,    34,     4,    19,    20,
+      38,    34,    73,    74,    75,    38,     3,     4,   128,    89,
+      90,    91,    30,    31,    32,    40,    41,     8,    43,    40,
+      17,    40,    34,    94,    95,    96,   141,    34,    33,    20,
+      35,   146,    29,    24,    27,     4,    33,     4,    35,     0,
+      33,    41,    35,   163,   164,    81,    82,    83,    84,    85,
+      86,     3,     4,   168,   169,    28,    29,    33,   129,   130,
+     180,   181,    19,    87,    88,    17,    41,   182,   183,     3,
+       4,    39,   143,    18,     8,     9,   147,    29,    12,    13,
+       4,    33,    34,    17,     4,    21,   166,     3,     4,    37,
+      27,   162,     8,     9,   165,    29,    12,    13,    38,    33,
+      41,    17,     5,    41,    37,     3,     4,    41,     4,    43,
+       8,     9,     4,    29,    12,    13,    37,    33,    41,    17,
+      42,    33,    16,     3,     4,    41,    34,    43,     8,     9,
+      15,    29,    12,    13,    41,    33,    42,    17,    42,    34,
+      41,     3,     4,    41,     4,    43,     8,     9,    41,    29,
+      12,    13,    41,    33,    41,    17,    34,    36,    14,     3,
+       4,    41,    37,    43,     8,     9,    37,    29,    12,    13,
+      36,    33,    41,    17,    41,     4,    27,     3,     4,    41,
+      33,    43,     8,     9,    36,    29,    12,    13,    42,    33,
+      30,    17,     3,     4,    42,     3,     4,    41,    11,    43,
+       8,     9,    37,    29,    12,    13,    17,    33,    41,    17,
+      37,    41,     6,    20,    42,    41,     6,    43,    29,    42,
+      79,    29,    33,    10,    10,    33,    21,    22,    23,    24,
+      25,    26,    -1,    28,    29,    80,   165
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
+{
+       0,     7,    19,    20,    40,    47,    48,    49,    52,    53,
+      54,    55,    57,     4,     4,     4,     4,    56,     0,    49,
+      52,    41,     9,    41,    43,    51,    53,    55,    57,    33,
+      19,    39,    33,    41,    41,    51,    18,    53,     4,    34,
+      58,     4,    50,     4,     4,    34,    21,    37,    34,    38,
+      38,    27,    41,     5,    41,    37,     4,     4,     3,     4,
+      17,    29,    33,    67,    68,    69,    70,    71,    72,    73,
+      37,    42,    41,    33,    35,    33,    73,    67,    34,    16,
+      15,    21,    22,    23,    24,    25,    26,    28,    29,    30,
+      31,    32,    41,     4,     8,     9,    12,    13,    59,    60,
+      61,    62,    63,    64,    65,    66,    67,    42,    34,    67,
+      74,    67,    67,    34,    41,    69,    70,    71,    71,    71,
+      71,    71,    71,    72,    72,    73,    73,    73,    42,    27,
+      35,    67,    67,    67,     4,    41,    43,    60,    41,    41,
+      41,    59,    34,    38,    36,    34,    59,    35,    67,    67,
+      37,    37,    14,    43,    67,    43,    67,    36,    41,    41,
+       4,    36,    27,    42,    42,    33,    30,    67,    59,    59,
+      74,    73,    43,    43,    34,    11,    37,    37,    41,    41,
+      42,    42,    59,    59,    43,    43
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
+{
+       0,    46,    47,    47,    47,    47,    48,    48,    49,    49,
+      50,    50,    51,    52,    52,    52,    52,    52,    53,    53,
+      54,    54,    55,    55,    55,    56,    56,    57,    57,    58,
+      58,    59,    59,    59,    60,    60,    60,    60,    60,    60,
+      61,    61,    61,    62,    62,    63,    63,    64,    65,    66,
+      67,    68,    68,    69,    69,    70,    70,    70,    70,    70,
+      70,    70,    71,    71,    71,    72,    72,    72,    72,    73,
+      73,    73,    73,    73,    73,    73,    73,    74,    74
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     1,     2,     2,     3,     2,     3,     2,     4,
+       1,     3,     9,     1,     3,     2,     2,     2,     1,     2,
+       1,     2,     3,     5,     8,     1,     3,    10,     9,     1,
+       3,     1,     2,     2,     2,     2,     1,     1,     1,     2,
+       3,     7,     6,     2,     1,     7,    13,     7,    12,     1,
+       1,     1,     3,     1,     3,     1,     3,     3,     3,     3,
+       3,     3,     1,     3,     3,     1,     3,     3,     3,     1,
+       1,     4,     4,     3,     4,     3,     2,     1,     3
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (scanner, ctx, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value, scanner, ctx); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, ParseContext* ctx)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (ctx);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, ParseContext* ctx)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, ctx);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, yyscan_t scanner, ParseContext* ctx)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, ctx);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, ctx); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner, ParseContext* ctx)
+{
+  YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (ctx);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (yyscan_t scanner, ParseContext* ctx)
+{
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, scanner);
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 2: /* program: function_list  */
+#line 137 "parser.y"
+                  {
+        (yyval.program) = node<ProgramNode>(ctx, *(yyvsp[0].func_list), ctx->symbols);
+        ctx->root = (yyval.program);
+    }
+#line 1315 "parser.tab.cpp"
+    break;
+
+  case 3: /* program: function_list if_main_block  */
+#line 141 "parser.y"
+                                  {
+        (yyval.program) = node<ProgramNode>(ctx, *(yyvsp[-1].func_list), ctx->symbols);
+        ctx->root = (yyval.program);
+    }
+#line 1324 "parser.tab.cpp"
+    break;
+
+  case 4: /* program: imports function_list  */
+#line 145 "parser.y"
+                            {
+        (yyval.program) = node<ProgramNode>(ctx, *(yyvsp[0].func_list), ctx->symbols);
+        ctx->root = (yyval.program);
+    }
+#line 1333 "parser.tab.cpp"
+    break;
+
+  case 5: /* program: imports function_list if_main_block  */
+#line 149 "parser.y"
+                                          {
+        (yyval.program) = node<ProgramNode>(ctx, *(yyvsp[-1].func_list), ctx->symbols);
+        ctx->root = (yyval.program);
+    }
+#line 1342 "parser.tab.cpp"
+    break;
+
+  case 8: /* import_statement: IMPORT IDENTIFIER  */
+#line 163 "parser.y"
+                      {
+        if ((yyvsp[0].sym) != ctx->symbols->intern("functools", 9)) {
+            yyerror(scanner, ctx, "only functools can be imported");
+            YYERROR;
+        }
+    }
+#line 1353 "parser.tab.cpp"
+    break;
+
+  case 9: /* import_statement: FROM IDENTIFIER IMPORT import_names  */
+#line 169 "parser.y"
+                                          {
+        if ((yyvsp[-2].sym) != ctx->symbols->intern("functools", 9) && (yyvsp[-2].sym) != ctx->symbols->intern("numba", 5)) {
+            yyerror(scanner, ctx, "only functools and numba can be imported from");
+            YYERROR;
+        }
+    }
+#line 1364 "parser.tab.cpp"
+    break;
+
+  case 13: /* function_list: function_def  */
+#line 187 "parser.y"
+                 {
+        (yyval.func_list) = new_list<FunctionDefNode*>(ctx);
+        (yyval.func_list)->push_back((yyvsp[0].func));
+    }
+#line 1373 "parser.tab.cpp"
+    break;
+
+  case 14: /* function_list: function_list DEDENT function_def  */
+#line 191 "parser.y"
+                                        {
+        (yyvsp[-2].func_list)->push_back((yyvsp[0].func));
+        (yyval.func_list) = (yyvsp[-2].func_list);
+    }
+#line 1382 "parser.tab.cpp"
+    break;
+
+  case 15: /* function_list: function_list function_def  */
+#line 195 "parser.y"
+                                 {
+        (yyvsp[-1].func_list)->push_back((yyvsp[0].func));
+        (yyval.func_list) = (yyvsp[-1].func_list);
+    }
+#line 1391 "parser.tab.cpp"
+    break;
+
+  case 16: /* function_list: function_list NEWLINE  */
+#line 199 "parser.y"
+                            {
+        (yyval.func_list) = (yyvsp[-1].func_list);
+    }
+#line 1399 "parser.tab.cpp"
+    break;
+
+  case 17: /* function_list: function_list DEDENT  */
+#line 202 "parser.y"
+                           {
+        (yyval.func_list) = (yyvsp[-1].func_list);
+    }
+#line 1407 "parser.tab.cpp"
+    break;
+
+  case 18: /* function_def: plain_function_def  */
+#line 208 "parser.y"
+                       { (yyval.func) = (yyvsp[0].func); }
+#line 1413 "parser.tab.cpp"
+    break;
+
+  case 19: /* function_def: decorators plain_function_def  */
+#line 209 "parser.y"
+                                    {
+        (yyvsp[0].func)->memoize = true;
+        (yyval.func) = (yyvsp[0].func);
+    }
+#line 1422 "parser.tab.cpp"
+    break;
+
+  case 25: /* decorator_name: IDENTIFIER  */
+#line 229 "parser.y"
+               {
+        if ((yyvsp[0].sym) != ctx->symbols->intern("cache", 5) && (yyvsp[0].sym) != ctx->symbols->intern("lru_cache", 9)) {
+            yyerror(scanner, ctx, "unsupported decorator");
+            YYERROR;
+        }
+        (yyval.sym) = (yyvsp[0].sym);
+    }
+#line 1434 "parser.tab.cpp"
+    break;
+
+  case 26: /* decorator_name: IDENTIFIER DOT IDENTIFIER  */
+#line 236 "parser.y"
+                                {
+        if ((yyvsp[-2].sym) != ctx->symbols->intern("functools", 9) ||
+            ((yyvsp[0].sym) != ctx->symbols->intern("cache", 5) && (yyvsp[0].sym) != ctx->symbols->intern("lru_cache", 9))) {
+            yyerror(scanner, ctx, "unsupported decorator");
+            YYERROR;
+        }
+        (yyval.sym) = (yyvsp[0].sym);
+    }
+#line 1447 "parser.tab.cpp"
+    break;
+
+  case 27: /* plain_function_def: DEF IDENTIFIER LPAREN parameters RPAREN COLON NEWLINE INDENT statements DEDENT  */
+#line 247 "parser.y"
+                                                                                   {
+        (yyval.func) = node<FunctionDefNode>(ctx, (yyvsp[-8].sym), *(yyvsp[-6].str_list), *(yyvsp[-1].stmt_list));
+    }
+#line 1455 "parser.tab.cpp"
+    break;
+
+  case 28: /* plain_function_def: DEF IDENTIFIER LPAREN RPAREN COLON NEWLINE INDENT statements DEDENT  */
+#line 250 "parser.y"
+                                                                          {
+        (yyval.func) = node<FunctionDefNode>(ctx, (yyvsp[-7].sym), NameList(), *(yyvsp[-1].stmt_list));
+    }
+#line 1463 "parser.tab.cpp"
+    break;
+
+  case 29: /* parameters: IDENTIFIER  */
+#line 256 "parser.y"
+               {
+        (yyval.str_list) = new_list<Symbol>(ctx);
+        (yyval.str_list)->push_back((yyvsp[0].sym));
+    }
+#line 1472 "parser.tab.cpp"
+    break;
+
+  case 30: /* parameters: parameters COMMA IDENTIFIER  */
+#line 260 "parser.y"
+                                  {
+        (yyvsp[-2].str_list)->push_back((yyvsp[0].sym));
+        (yyval.str_list) = (yyvsp[-2].str_list);
+    }
+#line 1481 "parser.tab.cpp"
+    break;
+
+  case 31: /* statements: statement  */
+#line 267 "parser.y"
+              {
+        (yyval.stmt_list) = new_list<StmtNode*>(ctx);
+        (yyval.stmt_list)->push_back((yyvsp[0].stmt));
+    }
+#line 1490 "parser.tab.cpp"
+    break;
+
+  case 32: /* statements: statements statement  */
+#line 271 "parser.y"
+                           {
+        (yyvsp[-1].stmt_list)->push_back((yyvsp[0].stmt));
+        (yyval.stmt_list) = (yyvsp[-1].stmt_list);
+    }
+#line 1499 "parser.tab.cpp"
+    break;
+
+  case 33: /* statements: statements NEWLINE  */
+#line 275 "parser.y"
+                         {
+        (yyval.stmt_list) = (yyvsp[-1].stmt_list);
+    }
+#line 1507 "parser.tab.cpp"
+    break;
+
+  case 34: /* statement: assignment NEWLINE  */
+#line 281 "parser.y"
+                       { (yyval.stmt) = (yyvsp[-1].stmt); }
+#line 1513 "parser.tab.cpp"
+    break;
+
+  case 35: /* statement: return_statement NEWLINE  */
+#line 282 "parser.y"
+                               { (yyval.stmt) = (yyvsp[-1].stmt); }
+#line 1519 "parser.tab.cpp"
+    break;
+
+  case 36: /* statement: if_statement  */
+#line 283 "parser.y"
+                   { (yyval.stmt) = (yyvsp[0].stmt); }
+#line 1525 "parser.tab.cpp"
+    break;
+
+  case 37: /* statement: while_statement  */
+#line 284 "parser.y"
+                      { (yyval.stmt) = (yyvsp[0].stmt); }
+#line 1531 "parser.tab.cpp"
+    break;
+
+  case 38: /* statement: for_statement  */
+#line 285 "parser.y"
+                    { (yyval.stmt) = (yyvsp[0].stmt); }
+#line 1537 "parser.tab.cpp"
+    break;
+
+  case 39: /* statement: expr_statement NEWLINE  */
+#line 286 "parser.y"
+                             { (yyval.stmt) = (yyvsp[-1].stmt); }
+#line 1543 "parser.tab.cpp"
+    break;
+
+  case 40: /* assignment: IDENTIFIER ASSIGN expression  */
+#line 290 "parser.y"
+                                 {
+        (yyval.stmt) = node<AssignNode>(ctx, (yyvsp[-2].sym), (yyvsp[0].expr));
+    }
+#line 1551 "parser.tab.cpp"
+    break;
+
+  case 41: /* assignment: IDENTIFIER ASSIGN LBRACKET expression RBRACKET MULTIPLY primary  */
+#line 293 "parser.y"
+                                                                      {
+        (yyval.stmt) = node<AssignNode>(ctx, (yyvsp[-6].sym), node<NewListNode>(ctx, (yyvsp[-3].expr), (yyvsp[0].expr)));
+    }
+#line 1559 "parser.tab.cpp"
+    break;
+
+  case 42: /* assignment: IDENTIFIER LBRACKET expression RBRACKET ASSIGN expression  */
+#line 296 "parser.y"
+                                                                {
+        (yyval.stmt) = node<IndexAssignNode>(ctx, (yyvsp[-5].sym), (yyvsp[-3].expr), (yyvsp[0].expr));
+    }
+#line 1567 "parser.tab.cpp"
+    break;
+
+  case 43: /* return_statement: RETURN expression  */
+#line 302 "parser.y"
+                      {
+        (yyval.stmt) = node<ReturnNode>(ctx, (yyvsp[0].expr));
+    }
+#line 1575 "parser.tab.cpp"
+    break;
+
+  case 44: /* return_statement: RETURN  */
+#line 305 "parser.y"
+             {
+        (yyval.stmt) = node<ReturnNode>(ctx, node<IntegerNode>(ctx, 0));
+    }
+#line 1583 "parser.tab.cpp"
+    break;
+
+  case 45: /* if_statement: IF expression COLON NEWLINE INDENT statements DEDENT  */
+#line 311 "parser.y"
+                                                         {
+        (yyval.stmt) = node<IfNode>(ctx, (yyvsp[-5].expr), *(yyvsp[-1].stmt_list), StmtList());
+    }
+#line 1591 "parser.tab.cpp"
+    break;
+
+  case 46: /* if_statement: IF expression COLON NEWLINE INDENT statements DEDENT ELSE COLON NEWLINE INDENT statements DEDENT  */
+#line 314 "parser.y"
+                                                                                                       {
+        (yyval.stmt) = node<IfNode>(ctx, (yyvsp[-11].expr), *(yyvsp[-7].stmt_list), *(yyvsp[-1].stmt_list));
+    }
+#line 1599 "parser.tab.cpp"
+    break;
+
+  case 47: /* while_statement: WHILE expression COLON NEWLINE INDENT statements DEDENT  */
+#line 320 "parser.y"
+                                                            {
+        (yyval.stmt) = node<WhileNode>(ctx, (yyvsp[-5].expr), *(yyvsp[-1].stmt_list));
+    }
+#line 1607 "parser.tab.cpp"
+    break;
+
+  case 48: /* for_statement: FOR IDENTIFIER IN IDENTIFIER LPAREN arguments RPAREN COLON NEWLINE INDENT statements DEDENT  */
+#line 328 "parser.y"
+                                                                                                {
+        ExprList& args = *(yyvsp[-6].expr_list);
+        bool parallel = (yyvsp[-8].sym) == ctx->symbols->intern("prange", 6);
+        if ((yyvsp[-8].sym) != ctx->symbols->intern("range", 5) && !parallel) {
+            yyerror(scanner, ctx, "for loops can only iterate over range() or prange()");
+            YYERROR;
+        }
+        if (args.size() > 3) {
+            yyerror(scanner, ctx, "range() takes at most 3 arguments");
+            YYERROR;
+        }
+        int step = 1;
+        if (args.size() == 3 && (!literal_value(args[2], &step) || step == 0)) {
+            yyerror(scanner, ctx, "range() step must be a nonzero integer literal");
+            YYERROR;
+        }
+        ExprNode* start = args.size() == 1 ? node<IntegerNode>(ctx, 0) : args[0];
+        ExprNode* stop = args.size() == 1 ? args[0] : args[1];
+        (yyval.stmt) = node<ForRangeNode>(ctx, (yyvsp[-10].sym), start, stop, step, *(yyvsp[-1].stmt_list), parallel);
+    }
+#line 1632 "parser.tab.cpp"
+    break;
+
+  case 49: /* expr_statement: expression  */
+#line 351 "parser.y"
+               {
+        (yyval.stmt) = node<ExprStmtNode>(ctx, (yyvsp[0].expr));
+    }
+#line 1640 "parser.tab.cpp"
+    break;
+
+  case 50: /* expression: logical_or  */
+#line 357 "parser.y"
+               { (yyval.expr) = (yyvsp[0].expr); }
+#line 1646 "parser.tab.cpp"
+    break;
+
+  case 51: /* logical_or: logical_and  */
+#line 361 "parser.y"
+                { (yyval.expr) = (yyvsp[0].expr); }
+#line 1652 "parser.tab.cpp"
+    break;
+
+  case 52: /* logical_or: logical_or OR logical_and  */
+#line 362 "parser.y"
+                                {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::OR, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1660 "parser.tab.cpp"
+    break;
+
+  case 53: /* logical_and: comparison  */
+#line 368 "parser.y"
+               { (yyval.expr) = (yyvsp[0].expr); }
+#line 1666 "parser.tab.cpp"
+    break;
+
+  case 54: /* logical_and: logical_and AND comparison  */
+#line 369 "parser.y"
+                                 {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::AND, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1674 "parser.tab.cpp"
+    break;
+
+  case 55: /* comparison: term  */
+#line 375 "parser.y"
+         { (yyval.expr) = (yyvsp[0].expr); }
+#line 1680 "parser.tab.cpp"
+    break;
+
+  case 56: /* comparison: term EQ term  */
+#line 376 "parser.y"
+                   {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::EQ, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1688 "parser.tab.cpp"
+    break;
+
+  case 57: /* comparison: term NEQ term  */
+#line 379 "parser.y"
+                    {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::NEQ, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1696 "parser.tab.cpp"
+    break;
+
+  case 58: /* comparison: term GT term  */
+#line 382 "parser.y"
+                   {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::GT, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1704 "parser.tab.cpp"
+    break;
+
+  case 59: /* comparison: term LT term  */
+#line 385 "parser.y"
+                   {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::LT, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1712 "parser.tab.cpp"
+    break;
+
+  case 60: /* comparison: term GTE term  */
+#line 388 "parser.y"
+                    {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::GTE, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1720 "parser.tab.cpp"
+    break;
+
+  case 61: /* comparison: term LTE term  */
+#line 391 "parser.y"
+                    {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::LTE, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1728 "parser.tab.cpp"
+    break;
+
+  case 62: /* term: factor  */
+#line 397 "parser.y"
+           { (yyval.expr) = (yyvsp[0].expr); }
+#line 1734 "parser.tab.cpp"
+    break;
+
+  case 63: /* term: term PLUS factor  */
+#line 398 "parser.y"
+                       {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::ADD, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1742 "parser.tab.cpp"
+    break;
+
+  case 64: /* term: term MINUS factor  */
+#line 401 "parser.y"
+                        {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::SUB, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1750 "parser.tab.cpp"
+    break;
+
+  case 65: /* factor: primary  */
+#line 407 "parser.y"
+            { (yyval.expr) = (yyvsp[0].expr); }
+#line 1756 "parser.tab.cpp"
+    break;
+
+  case 66: /* factor: factor MULTIPLY primary  */
+#line 408 "parser.y"
+                              {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::MUL, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1764 "parser.tab.cpp"
+    break;
+
+  case 67: /* factor: factor DIVIDE primary  */
+#line 411 "parser.y"
+                            {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::DIV, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1772 "parser.tab.cpp"
+    break;
+
+  case 68: /* factor: factor MODULO primary  */
+#line 414 "parser.y"
+                            {
+        (yyval.expr) = node<BinaryOpNode>(ctx, BinaryOp::MOD, (yyvsp[-2].expr), (yyvsp[0].expr));
+    }
+#line 1780 "parser.tab.cpp"
+    break;
+
+  case 69: /* primary: INTEGER  */
+#line 420 "parser.y"
+            {
+        (yyval.expr) = node<IntegerNode>(ctx, (yyvsp[0].int_val));
+    }
+#line 1788 "parser.tab.cpp"
+    break;
+
+  case 70: /* primary: IDENTIFIER  */
+#line 423 "parser.y"
+                 {
+        (yyval.expr) = node<IdentifierNode>(ctx, (yyvsp[0].sym));
+    }
+#line 1796 "parser.tab.cpp"
+    break;
+
+  case 71: /* primary: IDENTIFIER LBRACKET expression RBRACKET  */
+#line 426 "parser.y"
+                                              {
+        (yyval.expr) = node<IndexNode>(ctx, (yyvsp[-3].sym), (yyvsp[-1].expr));
+    }
+#line 1804 "parser.tab.cpp"
+    break;
+
+  case 72: /* primary: IDENTIFIER LPAREN arguments RPAREN  */
+#line 429 "parser.y"
+                                         {
+        if ((yyvsp[-3].sym) == ctx->symbols->intern("len", 3)) {
+            if ((yyvsp[-1].expr_list)->size() != 1 || (*(yyvsp[-1].expr_list))[0]->type != NodeType::IDENTIFIER) {
+                yyerror(scanner, ctx, "len() takes one list variable");
+                YYERROR;
+            }
+            (yyval.expr) = node<LenNode>(ctx, static_cast<IdentifierNode*>((*(yyvsp[-1].expr_list))[0])->name);
+        } else {
+            (yyval.expr) = node<CallNode>(ctx, (yyvsp[-3].sym), *(yyvsp[-1].expr_list));
+        }
+    }
+#line 1820 "parser.tab.cpp"
+    break;
+
+  case 73: /* primary: IDENTIFIER LPAREN RPAREN  */
+#line 440 "parser.y"
+                               {
+        (yyval.expr) = node<CallNode>(ctx, (yyvsp[-2].sym), ExprList());
+    }
+#line 1828 "parser.tab.cpp"
+    break;
+
+  case 74: /* primary: PRINT LPAREN expression RPAREN  */
+#line 443 "parser.y"
+                                     {
+        ExprList args(ctx->arena);
+        args.push_back((yyvsp[-1].expr));
+        (yyval.expr) = node<CallNode>(ctx, SYM_PRINT, args);
+    }
+#line 1838 "parser.tab.cpp"
+    break;
+
+  case 75: /* primary: LPAREN expression RPAREN  */
+#line 448 "parser.y"
+                               {
+        (yyval.expr) = (yyvsp[-1].expr);
+    }
+#line 1846 "parser.tab.cpp"
+    break;
+
+  case 76: /* primary: MINUS primary  */
+#line 451 "parser.y"
+                               {
+        (yyval.expr) = node<UnaryOpNode>(ctx, UnaryOp::NEG, (yyvsp[0].expr));
+    }
+#line 1854 "parser.tab.cpp"
+    break;
+
+  case 77: /* arguments: expression  */
+#line 457 "parser.y"
+               {
+        (yyval.expr_list) = new_list<ExprNode*>(ctx);
+        (yyval.expr_list)->push_back((yyvsp[0].expr));
+    }
+#line 1863 "parser.tab.cpp"
+    break;
+
+  case 78: /* arguments: arguments COMMA expression  */
+#line 461 "parser.y"
+                                 {
+        (yyvsp[-2].expr_list)->push_back((yyvsp[0].expr));
+        (yyval.expr_list) = (yyvsp[-2].expr_list);
+    }
+#line 1872 "parser.tab.cpp"
+    break;
+
+
+#line 1876 "parser.tab.cpp"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (scanner, ctx, YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval, scanner, ctx);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, ctx);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (scanner, ctx, YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval, scanner, ctx);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, ctx);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 467 "parser.y"
+
+
+void yyerror(yyscan_t scanner, ParseContext* ctx, const char* s) {
+    *ctx->errors << "Parse error at line " << yyget_lineno(scanner) << ": " << s << "\n";
+}
@@ -0,0 +1,193 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_PARSER_TAB_HPP_INCLUDED
+# define YY_YY_PARSER_TAB_HPP_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+/* "%code requires" blocks.  */
+#line 1 "parser.y"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "ast.h"
+
+typedef void* yyscan_t;
+
+// Everything one parse needs: the scanner and parser keep no global state,
+// so any number of sources can be parsed at once on different threads
+struct ParseContext {
+    // Open blocks are limited like CPython's, so the indentation state has a
+    // fixed size: the stack, and a ring of the INDENT/DEDENT tokens a line
+    // produced that are still to be returned, which never holds more than
+    // one DEDENT per open block
+    static const int MAX_INDENT = 100;
+    static const unsigned PENDING_SIZE = 128;
+
+    Arena* arena;                    // AST nodes and parser values live here
+    Interner* symbols;               // Identifiers are interned here
+    std::ostream* errors;            // Lexer and parser diagnostics
+    ProgramNode* root;               // Result of a successful parse
+    const char* source;              // Text being scanned; tokens are spans of it
+    bool at_start;                   // Scanner has not read any input yet
+    int indent_depth;
+    int indent_stack[MAX_INDENT];    // Indentation of each open block
+    unsigned pending_head;
+    unsigned pending_tail;
+    int pending_tokens[PENDING_SIZE];
+
+    ParseContext(Arena* arena, Interner* symbols, std::ostream* errors)
+        : arena(arena), symbols(symbols), errors(errors), root(nullptr), source(nullptr), at_start(true),
+          indent_depth(0), pending_head(0), pending_tail(0) {}
+
+    void push_pending(int token) { pending_tokens[pending_tail++ % PENDING_SIZE] = token; }
+    // The next pending token, or 0 if there is none
+    int pop_pending() { return pending_head == pending_tail ? 0 : pending_tokens[pending_head++ % PENDING_SIZE]; }
+};
+
+// Scan source[0..length) in place (lexer.l). source[length] and
+// source[length + 1] must be '\0', as SourceBuffer leaves them, and the
+// scanner writes to source while it runs. begin_scan returns nonzero if the
+// scanner can't be created; every scanner it creates goes to end_scan.
+int begin_scan(char* source, size_t length, ParseContext& ctx, yyscan_t* scanner);
+void end_scan(yyscan_t scanner);
+
+// Parse source[0..length), scanned as above, into ctx.root; returns 0 on success
+int parse_source(char* source, size_t length, ParseContext& ctx);
+
+#line 99 "parser.tab.hpp"
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    INTEGER = 258,                 /* INTEGER  */
+    IDENTIFIER = 259,              /* IDENTIFIER  */
+    STRING = 260,                  /* STRING  */
+    MAIN_STR = 261,                /* MAIN_STR  */
+    DEF = 262,                     /* DEF  */
+    RETURN = 263,                  /* RETURN  */
+    IF = 264,                      /* IF  */
+    ELIF = 265,                    /* ELIF  */
+    ELSE = 266,                    /* ELSE  */
+    WHILE = 267,                   /* WHILE  */
+    FOR = 268,                     /* FOR  */
+    IN = 269,                      /* IN  */
+    AND = 270,                     /* AND  */
+    OR = 271,                      /* OR  */
+    PRINT = 272,                   /* PRINT  */
+    NAME_VAR = 273,                /* NAME_VAR  */
+    IMPORT = 274,                  /* IMPORT  */
+    FROM = 275,                    /* FROM  */
+    EQ = 276,                      /* EQ  */
+    NEQ = 277,                     /* NEQ  */
+    GT = 278,                      /* GT  */
+    LT = 279,                      /* LT  */
+    GTE = 280,                     /* GTE  */
+    LTE = 281,                     /* LTE  */
+    ASSIGN = 282,                  /* ASSIGN  */
+    PLUS = 283,                    /* PLUS  */
+    MINUS = 284,                   /* MINUS  */
+    MULTIPLY = 285,                /* MULTIPLY  */
+    DIVIDE = 286,                  /* DIVIDE  */
+    MODULO = 287,                  /* MODULO  */
+    LPAREN = 288,                  /* LPAREN  */
+    RPAREN = 289,                  /* RPAREN  */
+    LBRACKET = 290,                /* LBRACKET  */
+    RBRACKET = 291,                /* RBRACKET  */
+    COLON = 292,                   /* COLON  */
+    COMMA = 293,                   /* COMMA  */
+    DOT = 294,                     /* DOT  */
+    AT = 295,                      /* AT  */
+    NEWLINE = 296,                 /* NEWLINE  */
+    INDENT = 297,                  /* INDENT  */
+    DEDENT = 298,                  /* DEDENT  */
+    UNEG = 299,                    /* UNEG  */
+    UNOT = 300                     /* UNOT  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 96 "parser.y"
+
+    int int_val;
+    Symbol sym;
+    ExprNode* expr;
+    StmtNode* stmt;
+    FunctionDefNode* func;
+    ProgramNode* program;
+    ExprList* expr_list;
+    NameList* str_list;
+    StmtList* stmt_list;
+    ArenaList<FunctionDefNode*>* func_list;
+
+#line 174 "parser.tab.hpp"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+
+
+int yyparse (yyscan_t scanner, ParseContext* ctx);
+
+/* "%code provides" blocks.  */
+#line 51 "parser.y"
+
+int yylex(YYSTYPE* yylval, yyscan_t scanner);
+
+#line 192 "parser.tab.hpp"
+
+#endif /* !YY_YY_PARSER_TAB_HPP_INCLUDED  */
@@ -1,49 +1,122 @@
 %code requires {
-#include <string>
+#include <cstddef>
+#include <ostream>
 #include <vector>
-#include <memory>
 #include "ast.h"
+
+typedef void* yyscan_t;
+
+// Everything one parse needs: the scanner and parser keep no global state,
+// so any number of sources can be parsed at once on different threads
+struct ParseContext {
+    // Open blocks are limited like CPython's, so the indentation state has a
+    // fixed size: the stack, and a ring of the INDENT/DEDENT tokens a line
+    // produced that are still to be returned, which never holds more than
+    // one DEDENT per open block
+    static const int MAX_INDENT = 100;
+    static const unsigned PENDING_SIZE = 128;
+
+    Arena* arena;                    // AST nodes and parser values live here
+    Interner* symbols;               // Identifiers are interned here
+    std::ostream* errors;            // Lexer and parser diagnostics
+    ProgramNode* root;               // Result of a successful parse
+    const char* source;              // Text being scanned; tokens are spans of it
+    bool at_start;                   // Scanner has not read any input yet
+    int indent_depth;
+    int indent_stack[MAX_INDENT];    // Indentation of each open block
+    unsigned pending_head;
+    unsigned pending_tail;
+    int pending_tokens[PENDING_SIZE];
+
+    ParseContext(Arena* arena, Interner* symbols, std::ostream* errors)
+        : arena(arena), symbols(symbols), errors(errors), root(nullptr), source(nullptr), at_start(true),
+          indent_depth(0), pending_head(0), pending_tail(0) {}
+
+    void push_pending(int token) { pending_tokens[pending_tail++ % PENDING_SIZE] = token; }
+    // The next pending token, or 0 if there is none
+    int pop_pending() { return pending_head == pending_tail ? 0 : pending_tokens[pending_head++ % PENDING_SIZE]; }
+};
+
+// Scan source[0..length) in place (lexer.l). source[length] and
+// source[length + 1] must be '\0', as SourceBuffer leaves them, and the
+// scanner writes to source while it runs. begin_scan returns nonzero if the
+// scanner can't be created; every scanner it creates goes to end_scan.
+int begin_scan(char* source, size_t length, ParseContext& ctx, yyscan_t* scanner);
+void end_scan(yyscan_t scanner);
+
+// Parse source[0..length), scanned as above, into ctx.root; returns 0 on success
+int parse_source(char* source, size_t length, ParseContext& ctx);
+}
+
+%code provides {
+int yylex(YYSTYPE* yylval, yyscan_t scanner);
 }
 
 %{
 #include <stdio.h>
 #include <stdlib.h>
-#include <string>
-#include <vector>
-#include <memory>
+#include <utility>
 #include "ast.h"
+%}
 
-extern int yylex();
-extern int yylineno;
-extern void reset_lexer();
-void yyerror(const char *s);
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {ParseContext* ctx}
 
-ProgramNode* root = nullptr;
-%}
+%code {
+int yyget_lineno(yyscan_t scanner);
+void yyerror(yyscan_t scanner, ParseContext* ctx, const char* s);
+
+// AST nodes and the parser's list values all live in the parse's arena
+template<typename T, typename... Args>
+static T* node(ParseContext* ctx, Args&&... args) {
+    return ctx->arena->make<T>(std::forward<Args>(args)...);
+}
+
+template<typename T>
+static ArenaList<T>* new_list(ParseContext* ctx) {
+    return ctx->arena->make<ArenaList<T>>(ctx->arena);
+}
+
+// Value of an integer literal, possibly negated
+static bool literal_value(ExprNode* expr, int* value) {
+    if (expr->type == NodeType::INTEGER) {
+        *value = static_cast<IntegerNode*>(expr)->value;
+        return true;
+    }
+    if (expr->type == NodeType::UNARY_OP && static_cast<UnaryOpNode*>(expr)->op == UnaryOp::NEG &&
+        literal_value(static_cast<UnaryOpNode*>(expr)->operand, value)) {
+        *value = static_cast<int>(0u - static_cast<unsigned>(*value));
+        return true;
+    }
+    return false;
+}
+}
 
 %union {
     int int_val;
-    std::string* str_val;
+    Symbol sym;
     ExprNode* expr;
     StmtNode* stmt;
     FunctionDefNode* func;
     ProgramNode* program;
-    std::vector<std::unique_ptr<ExprNode>>* expr_list;
-    std::vector<std::string>* str_list;
-    std::vector<std::unique_ptr<StmtNode>>* stmt_list;
-    std::vector<std::unique_ptr<FunctionDefNode>>* func_list;
+    ExprList* expr_list;
+    NameList* str_list;
+    StmtList* stmt_list;
+    ArenaList<FunctionDefNode*>* func_list;
 }
 
 %token <int_val> INTEGER
-%token <str_val> IDENTIFIER STRING MAIN_STR
-%token DEF RETURN IF ELIF ELSE WHILE AND OR PRINT NAME_VAR
+%token <sym> IDENTIFIER STRING MAIN_STR
+%token DEF RETURN IF ELIF ELSE WHILE FOR IN AND OR PRINT NAME_VAR IMPORT FROM
 %token EQ NEQ GT LT GTE LTE ASSIGN
 %token PLUS MINUS MULTIPLY DIVIDE MODULO
-%token LPAREN RPAREN COLON COMMA NEWLINE INDENT DEDENT
+%token LPAREN RPAREN LBRACKET RBRACKET COLON COMMA DOT AT NEWLINE INDENT DEDENT
 
 %type <expr> expression term factor primary comparison logical_and logical_or
-%type <stmt> statement assignment if_statement while_statement return_statement expr_statement
-%type <func> function_def
+%type <stmt> statement assignment if_statement while_statement for_statement return_statement expr_statement
+%type <func> function_def plain_function_def
+%type <sym> decorator_name
 %type <program> program
 %type <expr_list> arguments
 %type <str_list> parameters
@@ -62,44 +135,65 @@ ProgramNode* root = nullptr;
 
 program:
     function_list {
-        root = new ProgramNode();
-        if ($1) {
-            for (auto& func : *$1) {
-                root->functions.push_back(std::move(func));
-            }
-            delete $1;
-        }
-        $$ = root;
+        $$ = node<ProgramNode>(ctx, *$1, ctx->symbols);
+        ctx->root = $$;
     }
     | function_list if_main_block {
-        root = new ProgramNode();
-        if ($1) {
-            for (auto& func : *$1) {
-                root->functions.push_back(std::move(func));
-            }
-            delete $1;
+        $$ = node<ProgramNode>(ctx, *$1, ctx->symbols);
+        ctx->root = $$;
+    }
+    | imports function_list {
+        $$ = node<ProgramNode>(ctx, *$2, ctx->symbols);
+        ctx->root = $$;
+    }
+    | imports function_list if_main_block {
+        $$ = node<ProgramNode>(ctx, *$2, ctx->symbols);
+        ctx->root = $$;
+    }
+    ;
+
+/* Only functools may be imported, for its memoizing decorators, and
+   numba, for prange */
+imports:
+    import_statement NEWLINE
+    | imports import_statement NEWLINE
+    ;
+
+import_statement:
+    IMPORT IDENTIFIER {
+        if ($2 != ctx->symbols->intern("functools", 9)) {
+            yyerror(scanner, ctx, "only functools can be imported");
+            YYERROR;
+        }
+    }
+    | FROM IDENTIFIER IMPORT import_names {
+        if ($2 != ctx->symbols->intern("functools", 9) && $2 != ctx->symbols->intern("numba", 5)) {
+            yyerror(scanner, ctx, "only functools and numba can be imported from");
+            YYERROR;
         }
-        $$ = root;
     }
     ;
 
+import_names:
+    IDENTIFIER
+    | import_names COMMA IDENTIFIER
+    ;
+
 if_main_block:
-    IF NAME_VAR EQ STRING COLON NEWLINE INDENT statements DEDENT {
-        delete $4;
-    }
+    IF NAME_VAR EQ STRING COLON NEWLINE INDENT statements DEDENT
     ;
 
 function_list:
     function_def {
-        $$ = new std::vector<std::unique_ptr<FunctionDefNode>>();
-        $$->push_back(std::unique_ptr<FunctionDefNode>($1));
+        $$ = new_list<FunctionDefNode*>(ctx);
+        $$->push_back($1);
     }
     | function_list DEDENT function_def {
-        $1->push_back(std::unique_ptr<FunctionDefNode>($3));
+        $1->push_back($3);
         $$ = $1;
     }
     | function_list function_def {
-        $1->push_back(std::unique_ptr<FunctionDefNode>($2));
+        $1->push_back($2);
         $$ = $1;
     }
     | function_list NEWLINE {
@@ -111,39 +205,71 @@ function_list:
     ;
 
 function_def:
+    plain_function_def { $$ = $1; }
+    | decorators plain_function_def {
+        $2->memoize = true;
+        $$ = $2;
+    }
+    ;
+
+/* @cache, @lru_cache, @lru_cache(), @lru_cache(maxsize=...) and their
+   functools. forms; all of them memoize */
+decorators:
+    decorator
+    | decorators decorator
+    ;
+
+decorator:
+    AT decorator_name NEWLINE
+    | AT decorator_name LPAREN RPAREN NEWLINE
+    | AT decorator_name LPAREN IDENTIFIER ASSIGN expression RPAREN NEWLINE
+    ;
+
+decorator_name:
+    IDENTIFIER {
+        if ($1 != ctx->symbols->intern("cache", 5) && $1 != ctx->symbols->intern("lru_cache", 9)) {
+            yyerror(scanner, ctx, "unsupported decorator");
+            YYERROR;
+        }
+        $$ = $1;
+    }
+    | IDENTIFIER DOT IDENTIFIER {
+        if ($1 != ctx->symbols->intern("functools", 9) ||
+            ($3 != ctx->symbols->intern("cache", 5) && $3 != ctx->symbols->intern("lru_cache", 9))) {
+            yyerror(scanner, ctx, "unsupported decorator");
+            YYERROR;
+        }
+        $$ = $3;
+    }
+    ;
+
+plain_function_def:
     DEF IDENTIFIER LPAREN parameters RPAREN COLON NEWLINE INDENT statements DEDENT {
-        $$ = new FunctionDefNode(*$2, *$4, std::move(*$9));
-        delete $2;
-        delete $4;
-        delete $9;
+        $$ = node<FunctionDefNode>(ctx, $2, *$4, *$9);
     }
     | DEF IDENTIFIER LPAREN RPAREN COLON NEWLINE INDENT statements DEDENT {
-        $$ = new FunctionDefNode(*$2, std::vector<std::string>(), std::move(*$8));
-        delete $2;
-        delete $8;
+        $$ = node<FunctionDefNode>(ctx, $2, NameList(), *$8);
     }
     ;
 
 parameters:
     IDENTIFIER {
-        $$ = new std::vector<std::string>();
-        $$->push_back(*$1);
-        delete $1;
+        $$ = new_list<Symbol>(ctx);
+        $$->push_back($1);
     }
     | parameters COMMA IDENTIFIER {
-        $1->push_back(*$3);
-        delete $3;
+        $1->push_back($3);
         $$ = $1;
     }
     ;
 
 statements:
     statement {
-        $$ = new std::vector<std::unique_ptr<StmtNode>>();
-        $$->push_back(std::unique_ptr<StmtNode>($1));
+        $$ = new_list<StmtNode*>(ctx);
+        $$->push_back($1);
     }
     | statements statement {
-        $1->push_back(std::unique_ptr<StmtNode>($2));
+        $1->push_back($2);
         $$ = $1;
     }
     | statements NEWLINE {
@@ -156,47 +282,74 @@ statement:
     | return_statement NEWLINE { $$ = $1; }
     | if_statement { $$ = $1; }
     | while_statement { $$ = $1; }
+    | for_statement { $$ = $1; }
     | expr_statement NEWLINE { $$ = $1; }
     ;
 
 assignment:
     IDENTIFIER ASSIGN expression {
-        $$ = new AssignNode(*$1, std::unique_ptr<ExprNode>($3));
-        delete $1;
+        $$ = node<AssignNode>(ctx, $1, $3);
+    }
+    | IDENTIFIER ASSIGN LBRACKET expression RBRACKET MULTIPLY primary {
+        $$ = node<AssignNode>(ctx, $1, node<NewListNode>(ctx, $4, $7));
+    }
+    | IDENTIFIER LBRACKET expression RBRACKET ASSIGN expression {
+        $$ = node<IndexAssignNode>(ctx, $1, $3, $6);
     }
     ;
 
 return_statement:
     RETURN expression {
-        $$ = new ReturnNode(std::unique_ptr<ExprNode>($2));
+        $$ = node<ReturnNode>(ctx, $2);
     }
     | RETURN {
-        $$ = new ReturnNode(std::unique_ptr<ExprNode>(new IntegerNode(0)));
+        $$ = node<ReturnNode>(ctx, node<IntegerNode>(ctx, 0));
     }
     ;
 
 if_statement:
     IF expression COLON NEWLINE INDENT statements DEDENT {
-        $$ = new IfNode(std::unique_ptr<ExprNode>($2), std::move(*$6), std::vector<std::unique_ptr<StmtNode>>());
-        delete $6;
+        $$ = node<IfNode>(ctx, $2, *$6, StmtList());
     }
     | IF expression COLON NEWLINE INDENT statements DEDENT ELSE COLON NEWLINE INDENT statements DEDENT {
-        $$ = new IfNode(std::unique_ptr<ExprNode>($2), std::move(*$6), std::move(*$12));
-        delete $6;
-        delete $12;
+        $$ = node<IfNode>(ctx, $2, *$6, *$12);
     }
     ;
 
 while_statement:
     WHILE expression COLON NEWLINE INDENT statements DEDENT {
-        $$ = new WhileNode(std::unique_ptr<ExprNode>($2), std::move(*$6));
-        delete $6;
+        $$ = node<WhileNode>(ctx, $2, *$6);
+    }
+    ;
+
+/* for i in range(stop), range(start, stop) or range(start, stop, step), or
+   the same with prange */
+for_statement:
+    FOR IDENTIFIER IN IDENTIFIER LPAREN arguments RPAREN COLON NEWLINE INDENT statements DEDENT {
+        ExprList& args = *$6;
+        bool parallel = $4 == ctx->symbols->intern("prange", 6);
+        if ($4 != ctx->symbols->intern("range", 5) && !parallel) {
+            yyerror(scanner, ctx, "for loops can only iterate over range() or prange()");
+            YYERROR;
+        }
+        if (args.size() > 3) {
+            yyerror(scanner, ctx, "range() takes at most 3 arguments");
+            YYERROR;
+        }
+        int step = 1;
+        if (args.size() == 3 && (!literal_value(args[2], &step) || step == 0)) {
+            yyerror(scanner, ctx, "range() step must be a nonzero integer literal");
+            YYERROR;
+        }
+        ExprNode* start = args.size() == 1 ? node<IntegerNode>(ctx, 0) : args[0];
+        ExprNode* stop = args.size() == 1 ? args[0] : args[1];
+        $$ = node<ForRangeNode>(ctx, $2, start, stop, step, *$11, parallel);
     }
     ;
 
 expr_statement:
     expression {
-        $$ = new ExprStmtNode(std::unique_ptr<ExprNode>($1));
+        $$ = node<ExprStmtNode>(ctx, $1);
     }
     ;
 
@@ -207,105 +360,112 @@ expression:
 logical_or:
     logical_and { $$ = $1; }
     | logical_or OR logical_and {
-        $$ = new BinaryOpNode(BinaryOp::OR, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::OR, $1, $3);
     }
     ;
 
 logical_and:
     comparison { $$ = $1; }
     | logical_and AND comparison {
-        $$ = new BinaryOpNode(BinaryOp::AND, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::AND, $1, $3);
     }
     ;
 
 comparison:
     term { $$ = $1; }
     | term EQ term {
-        $$ = new BinaryOpNode(BinaryOp::EQ, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::EQ, $1, $3);
     }
     | term NEQ term {
-        $$ = new BinaryOpNode(BinaryOp::NEQ, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::NEQ, $1, $3);
     }
     | term GT term {
-        $$ = new BinaryOpNode(BinaryOp::GT, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::GT, $1, $3);
     }
     | term LT term {
-        $$ = new BinaryOpNode(BinaryOp::LT, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::LT, $1, $3);
     }
     | term GTE term {
-        $$ = new BinaryOpNode(BinaryOp::GTE, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::GTE, $1, $3);
     }
     | term LTE term {
-        $$ = new BinaryOpNode(BinaryOp::LTE, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::LTE, $1, $3);
     }
     ;
 
 term:
     factor { $$ = $1; }
     | term PLUS factor {
-        $$ = new BinaryOpNode(BinaryOp::ADD, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::ADD, $1, $3);
     }
     | term MINUS factor {
-        $$ = new BinaryOpNode(BinaryOp::SUB, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::SUB, $1, $3);
     }
     ;
 
 factor:
     primary { $$ = $1; }
     | factor MULTIPLY primary {
-        $$ = new BinaryOpNode(BinaryOp::MUL, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::MUL, $1, $3);
     }
     | factor DIVIDE primary {
-        $$ = new BinaryOpNode(BinaryOp::DIV, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::DIV, $1, $3);
     }
     | factor MODULO primary {
-        $$ = new BinaryOpNode(BinaryOp::MOD, std::unique_ptr<ExprNode>($1), std::unique_ptr<ExprNode>($3));
+        $$ = node<BinaryOpNode>(ctx, BinaryOp::MOD, $1, $3);
     }
     ;
 
 primary:
     INTEGER {
-        $$ = new IntegerNode($1);
+        $$ = node<IntegerNode>(ctx, $1);
     }
     | IDENTIFIER {
-        $$ = new IdentifierNode(*$1);
-        delete $1;
+        $$ = node<IdentifierNode>(ctx, $1);
+    }
+    | IDENTIFIER LBRACKET expression RBRACKET {
+        $$ = node<IndexNode>(ctx, $1, $3);
     }
     | IDENTIFIER LPAREN arguments RPAREN {
-        $$ = new CallNode(*$1, std::move(*$3));
-        delete $1;
-        delete $3;
+        if ($1 == ctx->symbols->intern("len", 3)) {
+            if ($3->size() != 1 || (*$3)[0]->type != NodeType::IDENTIFIER) {
+                yyerror(scanner, ctx, "len() takes one list variable");
+                YYERROR;
+            }
+            $$ = node<LenNode>(ctx, static_cast<IdentifierNode*>((*$3)[0])->name);
+        } else {
+            $$ = node<CallNode>(ctx, $1, *$3);
+        }
     }
     | IDENTIFIER LPAREN RPAREN {
-        $$ = new CallNode(*$1, std::vector<std::unique_ptr<ExprNode>>());
-        delete $1;
+        $$ = node<CallNode>(ctx, $1, ExprList());
     }
     | PRINT LPAREN expression RPAREN {
-        std::vector<std::unique_ptr<ExprNode>> args;
-        args.push_back(std::unique_ptr<ExprNode>($3));
-        $$ = new CallNode("print", std::move(args));
+        ExprList args(ctx->arena);
+        args.push_back($3);
+        $$ = node<CallNode>(ctx, SYM_PRINT, args);
     }
     | LPAREN expression RPAREN {
         $$ = $2;
     }
     | MINUS primary %prec UNEG {
-        $$ = new UnaryOpNode(UnaryOp::NEG, std::unique_ptr<ExprNode>($2));
+        $$ = node<UnaryOpNode>(ctx, UnaryOp::NEG, $2);
     }
     ;
 
 arguments:
     expression {
-        $$ = new std::vector<std::unique_ptr<ExprNode>>();
-        $$->push_back(std::unique_ptr<ExprNode>($1));
+        $$ = new_list<ExprNode*>(ctx);
+        $$->push_back($1);
     }
     | arguments COMMA expression {
-        $1->push_back(std::unique_ptr<ExprNode>($3));
+        $1->push_back($3);
         $$ = $1;
     }
     ;
 
 %%
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Parse error at line %d: %s\n", yylineno, s);
+void yyerror(yyscan_t scanner, ParseContext* ctx, const char* s) {
+    *ctx->errors << "Parse error at line " << yyget_lineno(scanner) << ": " << s << "\n";
 }
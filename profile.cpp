@@ -0,0 +1,71 @@
+#include "profile.h"
+#include <fstream>
+#include <sstream>
+
+int Profile::load(const std::string& path, const Interner& symbols, std::ostream& errors) {
+    std::ifstream in(path);
+    if (!in) {
+        errors << "Error: Could not read profile " << path << "\n";
+        return 1;
+    }
+    std::string header;
+    if (!std::getline(in, header) || header != "pyc-profile 1") {
+        errors << "Error: " << path << " is not a pyc profile\n";
+        return 1;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        size_t count;
+        if (!(fields >> name >> count)) {
+            errors << "Error: malformed profile " << path << "\n";
+            return 1;
+        }
+        std::vector<uint64_t> values(count);
+        for (uint64_t& value : values) {
+            if (!(fields >> value)) {
+                errors << "Error: malformed profile " << path << "\n";
+                return 1;
+            }
+        }
+        Symbol symbol = symbols.find(name.data(), name.size());
+        if (symbol == NO_SYMBOL) continue;
+        if (symbol >= counts.size()) counts.resize(symbol + 1);
+        if (!values.empty() && values[0] > max_entry) max_entry = values[0];
+        counts[symbol] = std::move(values);
+    }
+    return 0;
+}
+
+const std::vector<uint64_t>* Profile::function(Symbol name) const {
+    if (name >= counts.size() || counts[name].empty()) return nullptr;
+    return &counts[name];
+}
+
+size_t profile_site_count(StmtNode* stmt) {
+    if (stmt->type == NodeType::IF_STMT) {
+        IfNode* node = static_cast<IfNode*>(stmt);
+        return 1 + profile_site_count(node->then_block) + profile_site_count(node->else_block);
+    }
+    if (stmt->type == NodeType::WHILE_STMT) {
+        return 1 + profile_site_count(static_cast<WhileNode*>(stmt)->body);
+    }
+    if (stmt->type == NodeType::FOR_RANGE_STMT) {
+        return 1 + profile_site_count(static_cast<ForRangeNode*>(stmt)->body);
+    }
+    return 0;
+}
+
+size_t profile_site_count(const StmtList& stmts) {
+    size_t count = 0;
+    for (StmtNode* stmt : stmts) {
+        count += profile_site_count(stmt);
+    }
+    return count;
+}
+
+size_t profile_counter_count(FunctionDefNode* func) {
+    return 1 + 2 * profile_site_count(func->body);
+}
@@ -0,0 +1,36 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+// Execution counts written by a program built with --profile-generate, read
+// back for --profile-use. Each function has its entry count followed by an
+// execution count and a taken count for every if, while and for in its body,
+// in source order.
+class Profile {
+private:
+    std::vector<std::vector<uint64_t>> counts;   // Indexed by Symbol
+    uint64_t max_entry;
+
+public:
+    Profile() : max_entry(0) {}
+    // Read a profile file for the program whose names are symbols; functions
+    // it does not define are skipped. Returns nonzero and reports on errors
+    int load(const std::string& path, const Interner& symbols, std::ostream& errors);
+    // Counters recorded for a function, or null if there are none
+    const std::vector<uint64_t>* function(Symbol name) const;
+    // Entry count of the most frequently called function
+    uint64_t max_entry_count() const { return max_entry; }
+};
+
+// Number of counters a function's profile has
+size_t profile_counter_count(FunctionDefNode* func);
+// Number of if, while and for statements in stmt or stmts, nested ones included
+size_t profile_site_count(StmtNode* stmt);
+size_t profile_site_count(const StmtList& stmts);
+
+#endif // PROFILE_H
@@ -0,0 +1,113 @@
+#include "purity.h"
+
+// Set flag for every function that transitively calls one in worklist
+static void spread_to_callers(const std::vector<std::vector<Symbol>>& callers, std::vector<bool>& flag,
+                              std::vector<Symbol>& worklist) {
+    while (!worklist.empty()) {
+        Symbol callee = worklist.back();
+        worklist.pop_back();
+        for (Symbol caller : callers[callee]) {
+            if (!flag[caller]) {
+                flag[caller] = true;
+                worklist.push_back(caller);
+            }
+        }
+    }
+}
+
+PurityAnalysis::PurityAnalysis(ProgramNode* program)
+    : impure(program->symbols->size(), true), uses_memo(program->symbols->size(), false) {
+    size_t count = program->functions.size();
+    std::vector<bool> defined(program->symbols->size(), false);
+    for (FunctionDefNode* func : program->functions) {
+        defined[func->name] = true;
+        impure[func->name] = false;
+    }
+
+    // Functions are impure if they call something impure directly; the
+    // property then spreads from callees to their callers
+    std::vector<std::vector<Symbol>> callers(program->symbols->size());
+    std::vector<Symbol> worklist;
+    for (size_t i = 0; i < count; i++) {
+        FunctionDefNode* func = program->functions[i];
+        std::vector<CallNode*> calls;
+        collect_calls(func->body, calls);
+        for (CallNode* call : calls) {
+            Symbol callee = call->function_name;
+            if (callee == SYM_PRINT || !defined[callee]) {
+                if (!impure[func->name]) {
+                    impure[func->name] = true;
+                    worklist.push_back(func->name);
+                }
+            } else {
+                callers[callee].push_back(func->name);
+            }
+        }
+    }
+    spread_to_callers(callers, impure, worklist);
+
+    // Likewise for reaching a memo table
+    for (FunctionDefNode* func : program->functions) {
+        if (func->memoize) {
+            uses_memo[func->name] = true;
+            worklist.push_back(func->name);
+        }
+    }
+    spread_to_callers(callers, uses_memo, worklist);
+}
+
+bool PurityAnalysis::is_pure(Symbol function) const {
+    return function < impure.size() && !impure[function];
+}
+
+bool PurityAnalysis::is_parallel_safe(const StmtList& stmts) const {
+    std::vector<CallNode*> calls;
+    collect_calls(stmts, calls);
+    for (CallNode* call : calls) {
+        if (!is_pure(call->function_name) || uses_memo[call->function_name]) return false;
+    }
+    return true;
+}
+
+bool is_effect_free(ExprNode* expr) {
+    switch (expr->type) {
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            return is_effect_free(node->left) && is_effect_free(node->right);
+        }
+        case NodeType::UNARY_OP:
+            return is_effect_free(static_cast<UnaryOpNode*>(expr)->operand);
+        case NodeType::CALL:
+        case NodeType::INDEX:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Counts the nodes against budget; division is the only way an
+// effect-free expression can trap
+static bool small_and_safe(ExprNode* expr, unsigned& budget) {
+    if (budget == 0) return false;
+    budget--;
+    switch (expr->type) {
+        case NodeType::UNARY_OP:
+            return small_and_safe(static_cast<UnaryOpNode*>(expr)->operand, budget);
+        case NodeType::BINARY_OP: {
+            BinaryOpNode* node = static_cast<BinaryOpNode*>(expr);
+            if (node->op == BinaryOp::DIV || node->op == BinaryOp::MOD) {
+                // Division by zero traps and INT_MIN / -1 overflows
+                if (node->right->type != NodeType::INTEGER) return false;
+                int divisor = static_cast<IntegerNode*>(node->right)->value;
+                if (divisor == 0 || divisor == -1) return false;
+            }
+            return small_and_safe(node->left, budget) && small_and_safe(node->right, budget);
+        }
+        default:
+            return true;
+    }
+}
+
+bool is_speculatable(ExprNode* expr, unsigned max_nodes) {
+    return is_effect_free(expr) && small_and_safe(expr, max_nodes);
+}
@@ -0,0 +1,34 @@
+#ifndef PURITY_H
+#define PURITY_H
+
+#include <vector>
+#include "ast.h"
+
+// Which functions of a program are free of side effects. A function is pure
+// unless it prints, calls a function the program does not define, or calls a
+// function that is not pure; the result holds for the AST as analyzed.
+// Memoization relies on it: skipping a call to a pure function is invisible.
+class PurityAnalysis {
+private:
+    std::vector<bool> impure;   // Indexed by Symbol; true for unknown names too
+    std::vector<bool> uses_memo;  // Indexed by Symbol; calls a memoized function
+
+public:
+    explicit PurityAnalysis(ProgramNode* program);
+    bool is_pure(Symbol function) const;
+    // True if stmts can run on several threads at once: they call no impure
+    // function, and none that reaches a memo table, which is unsynchronized
+    bool is_parallel_safe(const StmtList& stmts) const;
+};
+
+// True if expr calls nothing and indexes no list (which may be out of
+// range), so it can be dropped or duplicated without changing the program
+bool is_effect_free(ExprNode* expr);
+
+// True if expr may be evaluated when its value is not needed, like the
+// right operand of `and` computed without a branch: it is effect-free, cannot
+// trap (no division but by a constant other than 0 and -1) and has at most
+// max_nodes nodes, so evaluating it anyway is cheap
+bool is_speculatable(ExprNode* expr, unsigned max_nodes);
+
+#endif // PURITY_H
@@ -0,0 +1,541 @@
+#include "pyc.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ast.h"
+#include "cache.h"
+#include "fast_backend.h"
+#include "codegen.h"
+#include "parser.tab.hpp"
+#include "profile.h"
+#include "purity.h"
+#include "thread_pool.h"
+#ifdef PYC_HAVE_LLVM
+#include "llvm_backend.h"
+#endif
+
+extern char** environ;
+
+// runtime.o, embedded by the Makefile with `ld -b binary`
+extern "C" const char _binary_runtime_o_start[];
+extern "C" const char _binary_runtime_o_end[];
+// runtime.c built freestanding for --static-runtime, embedded the same way
+extern "C" const char _binary_runtime_static_o_start[];
+extern "C" const char _binary_runtime_static_o_end[];
+
+namespace pyc {
+
+namespace {
+
+// Run a program directly (no shell) and wait for it to finish
+int run_process(const std::vector<std::string>& args, std::ostream& errors) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) {
+        errors << "Error: could not run " << args[0] << "\n";
+        return 1;
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        return 1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+int write_file(const std::string& path, const std::string& data, std::ostream& errors) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        errors << "Error: Could not create file " << path << "\n";
+        return 1;
+    }
+    out.write(data.data(), data.size());
+    return out ? 0 : 1;
+}
+
+int read_file(const std::string& path, std::string& data, std::ostream& errors) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        errors << "Error: Could not read file " << path << "\n";
+        return 1;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    data = contents.str();
+    return 0;
+}
+
+// Private temporary directory for the files one compile hands to external
+// tools. It is created on first use and removed, with every file handed
+// out, when the compile is done, so concurrent compiles never collide.
+class ScratchDir {
+private:
+    std::mutex lock;
+    std::string path;
+    std::vector<std::string> files;
+
+public:
+    ScratchDir() {}
+    ScratchDir(const ScratchDir&) = delete;
+    ScratchDir& operator=(const ScratchDir&) = delete;
+
+    ~ScratchDir() {
+        for (const std::string& file : files) {
+            remove(file.c_str());
+        }
+        if (!path.empty()) {
+            rmdir(path.c_str());
+        }
+    }
+
+    // Path for a new file called name, or "" if the directory can't be made
+    std::string file(const std::string& name, std::ostream& errors) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (path.empty()) {
+            const char* tmp = getenv("TMPDIR");
+            std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/pyc-XXXXXX";
+            std::vector<char> buffer(pattern.begin(), pattern.end());
+            buffer.push_back('\0');
+            if (!mkdtemp(buffer.data())) {
+                errors << "Error: Could not create temporary directory " << pattern << "\n";
+                return "";
+            }
+            path = buffer.data();
+        }
+        files.push_back(path + "/" + name);
+        return files.back();
+    }
+};
+
+CodegenOptions codegen_options(const Options& options, const Interner* symbols, const Profile* profile) {
+    CodegenOptions codegen;
+    codegen.symbols = symbols;
+    codegen.jobs = options.jobs == 0 ? 1 : options.jobs;
+    codegen.report_tail_calls = options.report_tail_calls;
+    codegen.unbuffered_print = options.unbuffered_print;
+    codegen.profile_file = options.profile_generate;
+    codegen.profile = profile;
+    return codegen;
+}
+
+// Load the --profile-use file into profile, if there is one
+int load_profile(const Options& options, const Interner& symbols, Profile& profile, std::ostream& errors) {
+    if (options.profile_use.empty()) {
+        return 0;
+    }
+    return profile.load(options.profile_use, symbols, errors);
+}
+
+// Write the runtime object into scratch and return its path
+std::string runtime_file(ScratchDir& scratch, bool static_runtime, std::ostream& errors) {
+    std::string path = scratch.file("runtime.o", errors);
+    std::string runtime = static_runtime
+        ? std::string(_binary_runtime_static_o_start, _binary_runtime_static_o_end - _binary_runtime_static_o_start)
+        : std::string(_binary_runtime_o_start, _binary_runtime_o_end - _binary_runtime_o_start);
+    if (path.empty() || write_file(path, runtime, errors) != 0) {
+        return "";
+    }
+    return path;
+}
+
+// Compile one IR module to object code, in process or with opt and llc
+int emit_object(const std::string& ir_code, std::string& object_code, const Options& options,
+                ScratchDir& scratch, const std::string& name, std::ostream& errors) {
+#ifdef PYC_HAVE_LLVM
+    if (!options.use_llc) {
+        return emit_object_in_process(ir_code, object_code, options.opt_level, options.passes, errors);
+    }
+#endif
+
+    std::string ir_file = scratch.file(name + ".ll", errors);
+    std::string obj_file = scratch.file(name + ".o", errors);
+    if (ir_file.empty() || obj_file.empty() || write_file(ir_file, ir_code, errors) != 0) {
+        return 1;
+    }
+
+    // Optimize the IR file in place with opt
+    std::string pipeline = !options.passes.empty() ? "-passes=" + options.passes
+                         : options.opt_level == 0  ? std::string("-passes=") + O0_PIPELINE
+                                                   : "-O" + std::to_string(options.opt_level);
+    if (run_process({"opt", "-S", pipeline, ir_file, "-o", ir_file}, errors) != 0) {
+        errors << "Error: opt failed\n";
+        return 1;
+    }
+    if (run_process({"llc", "-O" + std::to_string(options.opt_level), "-filetype=obj",
+                     ir_file, "-o", obj_file}, errors) != 0) {
+        errors << "Error: llc failed\n";
+        return 1;
+    }
+    return read_file(obj_file, object_code, errors);
+}
+
+// Compile every function as its own module through the cache: unchanged
+// functions come straight from their cached objects and only the others are
+// generated and compiled, in parallel. The objects are then combined into one.
+int compile_incremental(ProgramNode* program, const Options& options, const Profile& profile,
+                        Result& result, std::ostream& errors) {
+    CompileCache cache(options.cache_dir);
+    if (cache.open(errors) != 0) {
+        return 1;
+    }
+    std::string key_options = compiler_fingerprint() + " O" + std::to_string(options.opt_level) +
+                              (options.use_llc ? " llc" : " llvm") +
+                              (options.unbuffered_print ? " unbuffered" : "") + " passes=" + options.passes +
+                              " profile-generate=" + options.profile_generate;
+    CodeGenerator codegen(codegen_options(options, program->symbols, &profile));
+    codegen.declare_functions(program);
+
+    ScratchDir scratch;
+    size_t count = program->functions.size();
+    std::vector<std::string> objects(count);
+    std::vector<std::string> diagnostics(count);
+    std::vector<int> failed(count, 0);
+    std::vector<size_t> ir_instructions(count, 0);
+    std::vector<size_t> ir_bytes(count, 0);
+    ThreadPool pool(options.jobs);
+    pool.parallel_for(count, [&](size_t i, unsigned) {
+        FunctionDefNode* func = program->functions[i];
+        std::string key = function_cache_key(func, codegen, key_options);
+        objects[i] = cache.object_path(key);
+        if (cache.lookup(key)) {
+            return;
+        }
+
+        std::ostringstream function_errors;
+        std::string name = "f" + std::to_string(i);
+        std::string notes;
+        std::string ir_code = codegen.generate_function(func, diagnostics[i], notes);
+        ir_instructions[i] = count_ir_instructions(ir_code);
+        ir_bytes[i] = ir_code.size();
+        std::string object_code;
+        bool clean = diagnostics[i].empty();
+        if (options.report_tail_calls) diagnostics[i] += notes;
+        if (emit_object(ir_code, object_code, options, scratch, name, function_errors) != 0) {
+            failed[i] = 1;
+        } else if (clean) {
+            failed[i] = cache.store(key, object_code, function_errors);
+        } else {
+            // Keep functions with diagnostics out of the cache so they are reported again
+            objects[i] = scratch.file(name + ".obj", function_errors);
+            failed[i] = objects[i].empty() || write_file(objects[i], object_code, function_errors) != 0;
+        }
+        diagnostics[i] += function_errors.str();
+    });
+
+    int status = 0;
+    for (size_t i = 0; i < count; i++) {
+        errors << diagnostics[i];
+        status |= failed[i];
+        result.time_report.ir_instructions += ir_instructions[i];
+        result.time_report.ir_bytes += ir_bytes[i];
+    }
+    result.cache_hits = cache.get_hits();
+    result.cache_misses = cache.get_misses();
+    if (status != 0) {
+        return 1;
+    }
+
+    std::string merged = scratch.file("program.o", errors);
+    if (merged.empty()) {
+        return 1;
+    }
+    std::vector<std::string> args = {"ld", "-r", "-o", merged};
+    args.insert(args.end(), objects.begin(), objects.end());
+    if (run_process(args, errors) != 0) {
+        errors << "Error: ld failed\n";
+        return 1;
+    }
+    return read_file(merged, result.object, errors);
+}
+
+// prange loops anywhere in stmts, outermost first
+void collect_parallel_loops(const StmtList& stmts, std::vector<ForRangeNode*>& loops) {
+    for (StmtNode* stmt : stmts) {
+        switch (stmt->type) {
+            case NodeType::IF_STMT: {
+                IfNode* node = static_cast<IfNode*>(stmt);
+                collect_parallel_loops(node->then_block, loops);
+                collect_parallel_loops(node->else_block, loops);
+                break;
+            }
+            case NodeType::WHILE_STMT:
+                collect_parallel_loops(static_cast<WhileNode*>(stmt)->body, loops);
+                break;
+            case NodeType::FOR_RANGE_STMT: {
+                ForRangeNode* node = static_cast<ForRangeNode*>(stmt);
+                if (node->parallel) loops.push_back(node);
+                collect_parallel_loops(node->body, loops);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+// Parse, check and optimize source; the AST is allocated in arena and its
+// identifiers are interned in symbols
+ProgramNode* front_end(SourceBuffer& source, const Options& options, Arena& arena, Interner& symbols,
+                       Result& result, std::ostream& errors) {
+    PhaseTimer parse_timer("parse");
+    ParseContext ctx(&arena, &symbols, &errors);
+    int parse_status = parse_source(source.data(), source.size(), ctx);
+    result.time_report.phases.push_back(parse_timer.stop());
+    if (parse_status != 0) {
+        errors << "Error: Parsing failed\n";
+        return nullptr;
+    }
+
+    ProgramNode* program = ctx.root;
+    if (!program) {
+        errors << "Error: No program parsed\n";
+        return nullptr;
+    }
+    result.time_report.ast_nodes = count_ast_nodes(program);
+    result.time_report.functions = program->functions.size();
+
+    PhaseTimer check_timer("check");
+
+    // Check for main function
+    bool has_main = false;
+    for (FunctionDefNode* func : program->functions) {
+        if (func->name == SYM_MAIN) {
+            has_main = true;
+            break;
+        }
+    }
+
+    if (!has_main) {
+        errors << "Error: Program must have a main() function\n";
+        return nullptr;
+    }
+
+    // Memoizing skips repeated calls, and with them any side effects
+    PurityAnalysis purity(program);
+    for (FunctionDefNode* func : program->functions) {
+        if (func->memoize && !purity.is_pure(func->name)) {
+            errors << "Warning: " << symbols.name(func->name) << " is memoized but not pure "
+                   << "(it prints or calls a function that does); cached calls will not repeat its side effects\n";
+        }
+    }
+
+    // The iterations of a prange loop run concurrently and in no set order
+    bool parallel_ok = true;
+    for (FunctionDefNode* func : program->functions) {
+        std::vector<ForRangeNode*> loops;
+        collect_parallel_loops(func->body, loops);
+        for (ForRangeNode* loop : loops) {
+            if (!purity.is_parallel_safe(loop->body)) {
+                errors << "Error: a prange loop in " << symbols.name(func->name)
+                       << " prints, or calls a function that is not pure or is memoized\n";
+                parallel_ok = false;
+                break;
+            }
+        }
+    }
+    if (!parallel_ok) {
+        return nullptr;
+    }
+    result.time_report.phases.push_back(check_timer.stop());
+
+    // Fold constants and drop dead code before generating IR
+    if (options.ast_opt) {
+        PhaseTimer timer("ast-opt");
+        ASTOptimizer optimizer(arena);
+        optimizer.optimize(program);
+        result.opt_stats = optimizer.get_stats();
+        result.time_report.phases.push_back(timer.stop());
+    }
+
+    result.arena_bytes_used = arena.bytes_used();
+    result.arena_bytes_reserved = arena.bytes_reserved();
+    result.arena_blocks = arena.block_count();
+    return program;
+}
+
+int compile_program(SourceBuffer& source, const Options& options, Result& result,
+                    std::ostream& errors) {
+    // The whole AST lives in this arena and is freed in one go when the
+    // compile ends, along with the compile's own symbol table
+    Arena arena;
+    Interner symbols;
+    ProgramNode* program = front_end(source, options, arena, symbols, result, errors);
+    if (!program) {
+        return 1;
+    }
+
+    // The static runtime has no C library to run the constructors that
+    // register profile counters, or the destructor that writes them
+    if (options.static_runtime && !options.profile_generate.empty()) {
+        errors << "Error: --profile-generate cannot be used with --static-runtime\n";
+        return 1;
+    }
+
+    Profile profile;
+    if (load_profile(options, symbols, profile, errors) != 0) {
+        return 1;
+    }
+
+    // No IR at all: the optimization level, passes and cache do not apply
+    if (options.fast_backend) {
+        if (!options.profile_generate.empty()) {
+            errors << "Error: --profile-generate needs an LLVM backend\n";
+            return 1;
+        }
+        PhaseTimer timer("codegen");
+        std::string diagnostics;
+        int status = emit_object_fast(program, codegen_options(options, &symbols, &profile), result.object, diagnostics);
+        errors << diagnostics;
+        result.time_report.phases.push_back(timer.stop());
+        return status;
+    }
+
+    if (!options.cache_dir.empty()) {
+        PhaseTimer timer("incremental");
+        int status = compile_incremental(program, options, profile, result, errors);
+        result.time_report.phases.push_back(timer.stop());
+        return status;
+    }
+
+    // Generate LLVM IR
+    PhaseTimer codegen_timer("codegen");
+    CodeGenerator codegen(codegen_options(options, &symbols, &profile));
+    std::string diagnostics;
+    std::string ir_code = codegen.generate(program, diagnostics);
+    errors << diagnostics;
+    result.time_report.phases.push_back(codegen_timer.stop());
+    result.time_report.ir_instructions = count_ir_instructions(ir_code);
+    result.time_report.ir_bytes = ir_code.size();
+
+    PhaseTimer backend_timer("backend");
+    ScratchDir scratch;
+    int status = emit_object(ir_code, result.object, options, scratch, "program", errors);
+    result.time_report.phases.push_back(backend_timer.stop());
+    return status;
+}
+
+} // namespace
+
+Result compile(const std::string& source, const Options& options) {
+    SourceBuffer buffer;
+    buffer.assign(source.data(), source.size());
+    return compile(buffer, options);
+}
+
+Result compile(SourceBuffer& source, const Options& options) {
+    Options effective = options;
+    if (!has_llvm_backend()) {
+        effective.use_llc = true;
+    }
+    if (effective.jobs == 0) {
+        effective.jobs = 1;
+    }
+
+    Result result;
+    std::ostringstream errors;
+    result.success = compile_program(source, effective, result, errors) == 0;
+    result.diagnostics = errors.str();
+    return result;
+}
+
+Result run(const std::string& source, const Options& options, int& exit_code) {
+    SourceBuffer buffer;
+    buffer.assign(source.data(), source.size());
+    return run(buffer, options, exit_code);
+}
+
+Result run(SourceBuffer& source, const Options& options, int& exit_code) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    std::ostringstream errors;
+    exit_code = 1;
+#ifdef PYC_HAVE_LLVM
+    Arena arena;
+    Interner symbols;
+    ProgramNode* program = front_end(source, options, arena, symbols, result, errors);
+    Profile profile;
+    if (program && load_profile(options, symbols, profile, errors) == 0) {
+        PhaseTimer codegen_timer("codegen");
+        CodeGenerator codegen(codegen_options(options, &symbols, &profile));
+        std::string diagnostics;
+        std::string ir_code = codegen.generate(program, diagnostics);
+        errors << diagnostics;
+        result.time_report.phases.push_back(codegen_timer.stop());
+        result.time_report.ir_instructions = count_ir_instructions(ir_code);
+        result.time_report.ir_bytes = ir_code.size();
+
+        // Compiling, then running the program
+        PhaseTimer run_timer("jit-and-run");
+        result.success = run_in_process(ir_code, options.opt_level, options.passes, start,
+                                        result.startup_seconds, exit_code, errors) == 0;
+        result.time_report.phases.push_back(run_timer.stop());
+    }
+#else
+    (void)source;
+    (void)options;
+    (void)start;
+    errors << "Error: pyc was built without the LLVM library backend, which --run needs\n";
+#endif
+    result.diagnostics = errors.str();
+    return result;
+}
+
+bool link_executable(const std::string& object, const std::string& output_file,
+                     std::string& diagnostics, bool static_runtime) {
+    std::ostringstream errors;
+    ScratchDir scratch;
+    std::string obj_file = scratch.file("program.o", errors);
+    bool ok = !obj_file.empty() && write_file(obj_file, object, errors) == 0;
+    std::string runtime = ok ? runtime_file(scratch, static_runtime, errors) : "";
+    ok = ok && !runtime.empty();
+    // The static runtime is built with a section per function, so the parts
+    // the program does not call are dropped
+    std::vector<std::string> args =
+        static_runtime ? std::vector<std::string>{"gcc", "-static", "-nostdlib", "-no-pie", "-Wl,--gc-sections",
+                                                  "-Wl,--build-id=none", "-Wl,-z,noexecstack", obj_file, runtime,
+                                                  "-o", output_file}
+                       : std::vector<std::string>{"gcc", "-no-pie", obj_file, runtime, "-pthread", "-o", output_file};
+    if (ok && run_process(args, errors) != 0) {
+        errors << "Error: gcc linking failed\n";
+        ok = false;
+    }
+    diagnostics += errors.str();
+    return ok;
+}
+
+bool link_object(const std::string& object, const std::string& output_file,
+                 std::string& diagnostics, bool static_runtime) {
+    std::ostringstream errors;
+    ScratchDir scratch;
+    std::string obj_file = scratch.file("program.o", errors);
+    bool ok = !obj_file.empty() && write_file(obj_file, object, errors) == 0;
+    std::string runtime = ok ? runtime_file(scratch, static_runtime, errors) : "";
+    ok = ok && !runtime.empty();
+    if (ok && run_process({"ld", "-r", obj_file, runtime, "-o", output_file}, errors) != 0) {
+        errors << "Error: ld failed\n";
+        ok = false;
+    }
+    diagnostics += errors.str();
+    return ok;
+}
+
+bool has_llvm_backend() {
+#ifdef PYC_HAVE_LLVM
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace pyc
@@ -0,0 +1,79 @@
+#ifndef PYC_H
+#define PYC_H
+
+#include <cstddef>
+#include <string>
+#include "ast_opt.h"
+#include "source.h"
+#include "timing.h"
+
+// libpyc: the compiler behind a single call. Each compile owns its arena,
+// identifier interner, scanner and parser state, so compile() may be called
+// from many threads at once without sharing anything.
+namespace pyc {
+
+struct Options {
+    int opt_level = 0;       // LLVM optimization level, 0-3
+    std::string passes;      // Custom LLVM pass pipeline instead of -O<n>'s
+    bool ast_opt = true;     // Constant folding, simplification and DCE on the AST
+    unsigned jobs = 1;       // Threads used to generate and compile functions
+    bool use_llc = false;    // Run the external opt/llc tools (always, without LLVM)
+    bool fast_backend = false;  // Write machine code directly, without LLVM (fast_backend.h)
+    std::string cache_dir;   // Per-function object cache; empty for none
+    bool report_tail_calls = false;  // Add a note for every tail call transformed
+    bool unbuffered_print = false;   // print() writes every line out immediately
+    std::string profile_generate;    // Count branches and calls, written here at exit
+    std::string profile_use;         // Profile from such a run to optimize with
+    bool static_runtime = false;     // Will be linked with static_runtime set (below)
+};
+
+struct Result {
+    bool success = false;
+    std::string object;      // Relocatable object code for the whole program
+    std::string diagnostics; // Errors and warnings, one per line
+
+    ASTOptStats opt_stats;
+    size_t arena_bytes_used = 0;
+    size_t arena_bytes_reserved = 0;
+    size_t arena_blocks = 0;
+    unsigned cache_hits = 0;
+    unsigned cache_misses = 0;
+    double startup_seconds = 0;  // run(): from the call to main's first instruction
+    TimeReport time_report;      // Per-phase time and memory, and what the phases produced
+};
+
+// Compile the Python source in source to object code
+Result compile(const std::string& source, const Options& options);
+// The same, scanning source in place, e.g. straight from a mapped file
+Result compile(SourceBuffer& source, const Options& options);
+
+// JIT-compile source in memory and call its main() in this process, which
+// also receives its output; main's return value is stored in exit_code. An
+// IndexError or MemoryError sets exit_code to 1 instead of exiting, except
+// in a prange loop, whose threads cannot be stopped midway: a program with
+// one can still exit the host process.
+// Needs the LLVM library backend; the cache, use_llc and fast_backend do
+// not apply.
+Result run(const std::string& source, const Options& options, int& exit_code);
+Result run(SourceBuffer& source, const Options& options, int& exit_code);
+
+// Link object code from compile() and the pyc runtime (print and friends)
+// into an executable with the system compiler driver; returns false and
+// appends to diagnostics on failure. With static_runtime the executable is
+// static and has no C library: the runtime brings its own startup code and
+// makes system calls directly, and prange loops run serially.
+bool link_executable(const std::string& object, const std::string& output_file,
+                     std::string& diagnostics, bool static_runtime = false);
+
+// Combine object code from compile() with the pyc runtime into one
+// relocatable object file that links on its own (with static_runtime, only
+// with -static -nostdlib)
+bool link_object(const std::string& object, const std::string& output_file,
+                 std::string& diagnostics, bool static_runtime = false);
+
+// Whether the in-process LLVM backend was built in
+bool has_llvm_backend();
+
+} // namespace pyc
+
+#endif // PYC_H
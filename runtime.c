@@ -0,0 +1,580 @@
+#include "runtime.h"
+
+#ifdef PYC_STATIC_RUNTIME
+// --static-runtime: this file is built a second time, freestanding, as the
+// whole runtime of a static executable. The few system calls it needs are
+// made directly, _start stands in for the C library's startup code, and
+// prange loops run on the calling thread.
+#include <stddef.h>
+
+typedef long ssize_t;
+
+#define EINTR 4
+#define PROT_READ 1
+#define PROT_WRITE 2
+#define MAP_PRIVATE 2
+#define MAP_ANONYMOUS 0x20
+#define MAP_FAILED ((void*)-1)
+#define _Thread_local
+
+#if defined(__x86_64__)
+#define SYS_WRITE 1
+#define SYS_MMAP 9
+#define SYS_MUNMAP 11
+#define SYS_EXIT_GROUP 231
+
+static long syscall6(long number, long a, long b, long c, long d, long e, long f) {
+    register long r10 __asm__("r10") = d;
+    register long r8 __asm__("r8") = e;
+    register long r9 __asm__("r9") = f;
+    long result;
+    __asm__ volatile("syscall"
+                     : "=a"(result)
+                     : "a"(number), "D"(a), "S"(b), "d"(c), "r"(r10), "r"(r8), "r"(r9)
+                     : "rcx", "r11", "memory");
+    return result;
+}
+
+// The stack pointer is 16-byte aligned on entry; the call keeps the ABI's
+// alignment for the C code it enters
+__asm__(".text\n"
+        ".global _start\n"
+        ".type _start, @function\n"
+        "_start:\n"
+        "  xor %ebp, %ebp\n"
+        "  call pyc_start\n"
+        "  hlt\n");
+#elif defined(__aarch64__)
+#define SYS_WRITE 64
+#define SYS_MMAP 222
+#define SYS_MUNMAP 215
+#define SYS_EXIT_GROUP 94
+
+static long syscall6(long number, long a, long b, long c, long d, long e, long f) {
+    register long x8 __asm__("x8") = number;
+    register long x0 __asm__("x0") = a;
+    register long x1 __asm__("x1") = b;
+    register long x2 __asm__("x2") = c;
+    register long x3 __asm__("x3") = d;
+    register long x4 __asm__("x4") = e;
+    register long x5 __asm__("x5") = f;
+    __asm__ volatile("svc #0"
+                     : "+r"(x0)
+                     : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+                     : "memory");
+    return x0;
+}
+
+__asm__(".text\n"
+        ".global _start\n"
+        ".type _start, %function\n"
+        "_start:\n"
+        "  mov x29, #0\n"
+        "  mov x30, #0\n"
+        "  bl pyc_start\n");
+#else
+#error "--static-runtime supports x86-64 and AArch64 Linux"
+#endif
+
+// Stand-ins for the C library functions the rest of the file calls. The
+// system calls return -errno on failure.
+static int errno;
+
+static ssize_t write(int fd, const void* data, size_t length) {
+    long result = syscall6(SYS_WRITE, fd, (long)data, (long)length, 0, 0, 0);
+    if (result < 0) {
+        errno = (int)-result;
+        return -1;
+    }
+    return result;
+}
+
+static void* mmap(void* address, size_t length, int protection, int flags, int fd, long offset) {
+    long result = syscall6(SYS_MMAP, (long)address, (long)length, protection, flags, fd, offset);
+    return result < 0 && result > -4096 ? MAP_FAILED : (void*)result;
+}
+
+static int munmap(void* address, size_t length) {
+    return syscall6(SYS_MUNMAP, (long)address, (long)length, 0, 0, 0, 0) < 0 ? -1 : 0;
+}
+
+__attribute__((noreturn)) static void exit(int status) {
+    pyc_flush();
+    for (;;) syscall6(SYS_EXIT_GROUP, status, 0, 0, 0, 0, 0);
+}
+
+// Fresh mappings are zeroed
+static void* calloc(size_t count, size_t size) {
+    void* memory = mmap(0, count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? 0 : memory;
+}
+
+// LLVM turns fill and copy loops into calls to these. The build passes
+// -fno-tree-loop-distribute-patterns so GCC does not do the same to them.
+void* memset(void* destination, int value, size_t length) {
+    unsigned char* p = destination;
+    while (length--) *p++ = (unsigned char)value;
+    return destination;
+}
+
+void* memcpy(void* destination, const void* source, size_t length) {
+    unsigned char* d = destination;
+    const unsigned char* s = source;
+    while (length--) *d++ = *s++;
+    return destination;
+}
+
+void* memmove(void* destination, const void* source, size_t length) {
+    unsigned char* d = destination;
+    const unsigned char* s = source;
+    if (d < s) {
+        while (length--) *d++ = *s++;
+    } else {
+        while (length--) d[length] = s[length];
+    }
+    return destination;
+}
+
+int32_t main(void);
+
+// Called by _start. Output is flushed by exit, which is what the C
+// library's startup code would call with main's result.
+__attribute__((noreturn, used)) void pyc_start(void) {
+    exit(main());
+}
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define BUFFER_SIZE (1 << 16)
+// "-2147483648\n"
+#define MAX_LINE 12
+
+static char buffer[BUFFER_SIZE];
+static size_t buffered;
+
+static void write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+// Format value and a newline ending at end; returns where the text starts
+static char* format_line(int32_t value, char* end) {
+    char* p = end;
+    *--p = '\n';
+    // Work in unsigned so that INT32_MIN negates cleanly
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+void pyc_flush(void) {
+    write_all(1, buffer, buffered);
+    buffered = 0;
+}
+
+void pyc_print_i32(int32_t value) {
+    if (buffered > BUFFER_SIZE - MAX_LINE) {
+        pyc_flush();
+    }
+    char line[MAX_LINE];
+    char* start = format_line(value, line + MAX_LINE);
+    size_t length = (size_t)(line + MAX_LINE - start);
+    for (size_t i = 0; i < length; i++) {
+        buffer[buffered + i] = start[i];
+    }
+    buffered += length;
+}
+
+void pyc_print_i32_unbuffered(int32_t value) {
+    char line[MAX_LINE];
+    char* start = format_line(value, line + MAX_LINE);
+    write_all(1, start, (size_t)(line + MAX_LINE - start));
+}
+
+// Set while a thread runs its part of a prange loop
+static _Thread_local int in_parallel_loop;
+static _Thread_local pyc_error_handler error_handler;
+
+void pyc_set_error_handler(pyc_error_handler handler) {
+    error_handler = handler;
+}
+
+// Report a fatal error and leave the program with status 1. The handler is
+// skipped inside a prange loop, whose other threads still use the frames it
+// would unwind.
+__attribute__((noreturn)) static void fail(const char* message, size_t length) {
+    pyc_flush();
+    write_all(2, message, length);
+    if (error_handler && !in_parallel_loop) {
+        error_handler(1);
+    }
+    exit(1);
+}
+
+// Arena chunks are mapped as needed and stacked; the first one is kept for
+// the life of the thread, so functions that make a list on every call do not
+// map and unmap memory each time
+#define ARENA_CHUNK (1 << 20)
+#define LIST_ALIGN 64
+
+struct arena_chunk {
+    struct arena_chunk* prev;
+    size_t size;         // Mapped bytes, this header included
+    char* end;
+};
+
+static _Thread_local struct arena_chunk* arena_chunk;
+static _Thread_local char* arena_top;
+
+static char* chunk_start(struct arena_chunk* chunk) {
+    return (char*)chunk + LIST_ALIGN;
+}
+
+void* pyc_arena_save(void) {
+    return arena_top;
+}
+
+void pyc_arena_restore(void* mark) {
+    char* top = mark;
+    while (arena_chunk && !(top >= chunk_start(arena_chunk) && top <= arena_chunk->end)) {
+        struct arena_chunk* prev = arena_chunk->prev;
+        if (!prev) {
+            // Saved before anything was allocated: empty the first chunk
+            top = chunk_start(arena_chunk);
+            break;
+        }
+        munmap(arena_chunk, arena_chunk->size);
+        arena_chunk = prev;
+    }
+    arena_top = top;
+}
+
+int32_t* pyc_list_alloc(int32_t length) {
+    size_t bytes = ((size_t)length * sizeof(int32_t) + LIST_ALIGN - 1) & ~(size_t)(LIST_ALIGN - 1);
+    if (!arena_chunk || bytes > (size_t)(arena_chunk->end - arena_top)) {
+        size_t size = LIST_ALIGN + (bytes > ARENA_CHUNK ? bytes : ARENA_CHUNK);
+        void* memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            fail("MemoryError\n", 12);
+        }
+        struct arena_chunk* chunk = memory;
+        chunk->prev = arena_chunk;
+        chunk->size = size;
+        chunk->end = (char*)memory + size;
+        arena_chunk = chunk;
+        arena_top = chunk_start(chunk);
+    }
+    int32_t* list = (int32_t*)arena_top;
+    arena_top += bytes;
+    return list;
+}
+
+void pyc_index_error(void) {
+    fail("IndexError: list index out of range\n", 36);
+}
+
+#define MEMO_SIZE (1 << 16)
+#define MEMO_PROBES 8
+
+// Entries are { used, value, args[count] }; a function without arguments
+// has a single one
+static int32_t* memo_entry(void** table, uint32_t count, uint32_t slot) {
+    if (!*table) {
+        *table = calloc(count ? MEMO_SIZE : 1, (2 + count) * sizeof(int32_t));
+        if (!*table) {
+            fail("MemoryError\n", 12);
+        }
+    }
+    return (int32_t*)*table + (size_t)slot * (2 + count);
+}
+
+static uint32_t memo_hash(const int32_t* args, uint32_t count) {
+    uint32_t hash = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        hash = (hash ^ (uint32_t)args[i]) * 2654435761u;
+    }
+    return (hash ^ hash >> 16) & (MEMO_SIZE - 1);
+}
+
+// The entry args are in, or else the first free one they may go in; null
+// if every slot they probe is taken
+static int32_t* memo_find(void** table, const int32_t* args, uint32_t count) {
+    uint32_t start = memo_hash(args, count);
+    for (uint32_t i = 0; i < (count ? MEMO_PROBES : 1); i++) {
+        int32_t* entry = memo_entry(table, count, (start + i) & (MEMO_SIZE - 1));
+        if (!entry[0]) return entry;
+        uint32_t k = 0;
+        while (k < count && entry[2 + k] == args[k]) k++;
+        if (k == count) return entry;
+    }
+    return 0;
+}
+
+int pyc_memo_lookup(void** table, const int32_t* args, uint32_t count, int32_t* value) {
+    int32_t* entry = memo_find(table, args, count);
+    if (!entry || !entry[0]) return 0;
+    *value = entry[1];
+    return 1;
+}
+
+void pyc_memo_store(void** table, const int32_t* args, uint32_t count, int32_t value) {
+    int32_t* entry = memo_find(table, args, count);
+    if (!entry) entry = memo_entry(table, count, memo_hash(args, count));
+    entry[0] = 1;
+    entry[1] = value;
+    for (uint32_t i = 0; i < count; i++) {
+        entry[2 + i] = args[i];
+    }
+}
+
+#ifdef PYC_STATIC_RUNTIME
+// Without threads every loop runs where it is started
+void pyc_parallel_for(pyc_loop_body body, void* env, uint32_t count) {
+    if (count > 0) body(env, 0, count);
+}
+#else
+// Thread pool for prange loops. Thread 0 is the one that starts a loop; the
+// workers sleep between loops until the generation counter moves on.
+#define MAX_THREADS 256
+// Chunks a thread's share is split into, so stealing has work to balance
+#define CHUNKS_PER_THREAD 16
+
+// Iterations still to run of one thread's share: begin in the low half, end
+// in the high half, so the owner and thieves can update it with one CAS
+struct loop_range {
+    _Alignas(64) _Atomic uint64_t bounds;
+};
+
+static struct loop_range loop_ranges[MAX_THREADS];
+static int thread_count;
+static pyc_loop_body loop_body;
+static void* loop_env;
+static uint32_t loop_chunk;
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static uint64_t generation;
+static int pool_busy;            // Workers still running the current loop
+
+static uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return (uint64_t)end << 32 | begin;
+}
+
+// Take up to chunk iterations from the front of range
+static int claim_front(struct loop_range* range, uint32_t chunk, uint32_t* begin, uint32_t* end) {
+    uint64_t bounds = atomic_load(&range->bounds);
+    for (;;) {
+        uint32_t first = (uint32_t)bounds;
+        uint32_t last = (uint32_t)(bounds >> 32);
+        if (first >= last) return 0;
+        uint32_t size = last - first < chunk ? last - first : chunk;
+        if (atomic_compare_exchange_weak(&range->bounds, &bounds, pack_range(first + size, last))) {
+            *begin = first;
+            *end = first + size;
+            return 1;
+        }
+    }
+}
+
+// Take the back half, rounded up, of what is left of range
+static int steal_back(struct loop_range* range, uint32_t* begin, uint32_t* end) {
+    uint64_t bounds = atomic_load(&range->bounds);
+    for (;;) {
+        uint32_t first = (uint32_t)bounds;
+        uint32_t last = (uint32_t)(bounds >> 32);
+        if (first >= last) return 0;
+        uint32_t middle = last - (last - first + 1) / 2;
+        if (atomic_compare_exchange_weak(&range->bounds, &bounds, pack_range(first, middle))) {
+            *begin = middle;
+            *end = last;
+            return 1;
+        }
+    }
+}
+
+// Run thread self's share of the current loop, then whatever it can steal.
+// Stolen work goes into its own range, where others can steal from it again.
+static void run_share(int self) {
+    struct loop_range* own = &loop_ranges[self];
+    uint32_t begin, end;
+    in_parallel_loop = 1;
+    for (;;) {
+        while (claim_front(own, loop_chunk, &begin, &end)) {
+            loop_body(loop_env, begin, end);
+        }
+        int found = 0;
+        for (int i = 1; i < thread_count && !found; i++) {
+            found = steal_back(&loop_ranges[(self + i) % thread_count], &begin, &end);
+        }
+        if (!found) break;
+        atomic_store(&own->bounds, pack_range(begin, end));
+    }
+    in_parallel_loop = 0;
+}
+
+static void* worker_main(void* arg) {
+    int self = (int)(intptr_t)arg;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (generation == seen) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        seen = generation;
+        pthread_mutex_unlock(&pool_lock);
+        run_share(self);
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_busy == 0) {
+            pthread_cond_signal(&work_done);
+        }
+    }
+    return 0;
+}
+
+static void start_pool(void) {
+    const char* setting = getenv("PYC_NUM_THREADS");
+    long threads = setting ? strtol(setting, 0, 10) : 0;
+    if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    thread_count = 1;
+    for (long i = 1; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, worker_main, (void*)(intptr_t)i) != 0) break;
+        pthread_detach(thread);
+        thread_count++;
+    }
+}
+
+void pyc_parallel_for(pyc_loop_body body, void* env, uint32_t count) {
+    if (count > 1 && !in_parallel_loop) {
+        pthread_once(&pool_once, start_pool);
+    }
+    if (count <= 1 || in_parallel_loop || thread_count <= 1) {
+        if (count > 0) body(env, 0, count);
+        return;
+    }
+
+    // Contiguous shares, so each thread mostly walks its own part of a list
+    uint32_t share = count / (uint32_t)thread_count;
+    uint32_t extra = count % (uint32_t)thread_count;
+    uint32_t begin = 0;
+    for (int i = 0; i < thread_count; i++) {
+        uint32_t size = share + ((uint32_t)i < extra);
+        atomic_store(&loop_ranges[i].bounds, pack_range(begin, begin + size));
+        begin += size;
+    }
+    loop_body = body;
+    loop_env = env;
+    loop_chunk = count / ((uint32_t)thread_count * CHUNKS_PER_THREAD);
+    if (loop_chunk == 0) loop_chunk = 1;
+
+    pthread_mutex_lock(&pool_lock);
+    pool_busy = thread_count - 1;
+    generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_share(0);
+
+    pthread_mutex_lock(&pool_lock);
+    while (pool_busy > 0) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+#endif
+
+// --profile-generate programs are linked against the C library, which runs
+// the constructors that register their records and the destructor below
+#ifndef PYC_STATIC_RUNTIME
+static struct pyc_profile_record* profile_records;
+
+void pyc_profile_register(struct pyc_profile_record* record) {
+    record->next = profile_records;
+    profile_records = record;
+}
+
+// Profile output goes through its own small buffer
+struct profile_writer {
+    int fd;
+    size_t used;
+    char data[4096];
+};
+
+static void profile_text(struct profile_writer* out, const char* text, size_t length) {
+    if (out->used + length > sizeof(out->data)) {
+        write_all(out->fd, out->data, out->used);
+        out->used = 0;
+    }
+    // Text too long for the empty buffer, such as a long function name
+    if (length > sizeof(out->data)) {
+        write_all(out->fd, text, length);
+        return;
+    }
+    for (size_t i = 0; i < length; i++) {
+        out->data[out->used++] = text[i];
+    }
+}
+
+static void profile_number(struct profile_writer* out, uint64_t value) {
+    char digits[21];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    profile_text(out, " ", 1);
+    profile_text(out, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// One line per function: name, number of counters, counters
+void pyc_profile_write(void) {
+    if (!profile_records) return;
+    struct profile_writer out;
+    out.fd = open(profile_records->file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    out.used = 0;
+    if (out.fd >= 0) {
+        profile_text(&out, "pyc-profile 1\n", 14);
+        for (struct pyc_profile_record* record = profile_records; record; record = record->next) {
+            const char* name = record->function;
+            size_t length = 0;
+            while (name[length]) length++;
+            profile_text(&out, name, length);
+            profile_number(&out, record->count);
+            for (uint32_t i = 0; i < record->count; i++) {
+                profile_number(&out, record->counters[i]);
+            }
+            profile_text(&out, "\n", 1);
+        }
+        write_all(out.fd, out.data, out.used);
+        close(out.fd);
+    }
+    profile_records = 0;
+}
+
+// Runs when main returns or the program calls exit
+__attribute__((destructor)) static void flush_at_exit(void) {
+    pyc_flush();
+    pyc_profile_write();
+}
+#endif
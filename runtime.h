@@ -0,0 +1,74 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stdint.h>
+
+// Runtime support called by compiled programs. It is linked into every
+// executable pyc produces and, for --run, into pyc itself.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// print(x): formats x and a newline into a static output buffer that is
+// written out when it fills up and when the program exits
+void pyc_print_i32(int32_t value);
+// print(x) for --unbuffered: writes the line immediately
+void pyc_print_i32_unbuffered(int32_t value);
+// Write out whatever is buffered
+void pyc_flush(void);
+
+// Lists that are not constant-size stack arrays live in a per-thread arena
+// of 64-byte aligned blocks. A function that makes such lists saves the
+// arena's top on entry and restores it before it returns, releasing them.
+void* pyc_arena_save(void);
+void pyc_arena_restore(void* mark);
+// Room for length ints, length >= 0; the caller fills it in
+int32_t* pyc_list_alloc(int32_t length);
+// A list index was out of range: report it like Python and exit with status 1
+void pyc_index_error(void) __attribute__((cold, noreturn));
+
+// Fatal errors (IndexError, MemoryError) exit the process with status 1. A
+// host running a program in process installs a handler on the thread that
+// calls main instead: it gets the status and must not return, typically by
+// longjmp-ing back out of the program. Errors on prange loop threads, the
+// calling one included, still exit.
+typedef void (*pyc_error_handler)(int status);
+void pyc_set_error_handler(pyc_error_handler handler);
+
+// Memo tables for --backend=fast, which has no tables of its own: *table
+// starts out null and is allocated by the first lookup. They work like the
+// ones CodeGenerator emits, keeping the most recent results for each hash.
+// pyc_memo_lookup returns nonzero and sets *value if args were recorded.
+int pyc_memo_lookup(void** table, const int32_t* args, uint32_t count, int32_t* value);
+void pyc_memo_store(void** table, const int32_t* args, uint32_t count, int32_t value);
+
+// A prange loop: runs body(env, begin, end) on chunks covering the iterations
+// [0, count), count taken as unsigned, across a pool of PYC_NUM_THREADS
+// threads (one per CPU by default) started by the first loop that needs it.
+// Each thread works through its share front to back and, once it runs dry,
+// steals the back half of another thread's remainder. Returns when every
+// iteration is done; loops started from a loop body run on the calling thread.
+typedef void (*pyc_loop_body)(void* env, uint32_t begin, uint32_t end);
+void pyc_parallel_for(pyc_loop_body body, void* env, uint32_t count);
+
+// Counters of one function built with --profile-generate: its entry count,
+// then an execution count and a taken count for every if and loop. The
+// compiler emits a record per function and registers it from a constructor.
+struct pyc_profile_record {
+    const char* file;
+    const char* function;
+    uint64_t* counters;
+    uint32_t count;
+    struct pyc_profile_record* next;
+};
+
+void pyc_profile_register(struct pyc_profile_record* record);
+// Write the registered counters to their profile file, replacing it, and
+// forget the records; runs at exit
+void pyc_profile_write(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RUNTIME_H
@@ -0,0 +1,74 @@
+#include "source.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void SourceBuffer::unmap() {
+    if (mapped) munmap(text, mapped);
+    mapped = 0;
+}
+
+void SourceBuffer::assign(const char* source, size_t size) {
+    unmap();
+    copy.assign(size + 2, '\0');
+    if (size) memcpy(copy.data(), source, size);
+    text = copy.data();
+    length = size;
+}
+
+bool SourceBuffer::load_file(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+
+    // Reserve zeroed pages for the file and the terminator, then map the
+    // file over the front of them. Past the end of the file, the rest of its
+    // last page reads as zeros and the pages after are the reserved ones.
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t total = (size + 2 + page - 1) & ~(page - 1);
+        void* reserved = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved != MAP_FAILED) {
+            void* file = mmap(reserved, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+            if (file != MAP_FAILED) {
+                close(fd);
+                madvise(file, size, MADV_SEQUENTIAL);
+                unmap();
+                copy.clear();
+                text = static_cast<char*>(file);
+                length = size;
+                mapped = total;
+                return true;
+            }
+            munmap(reserved, total);
+        }
+    }
+
+    std::vector<char> contents;
+    char chunk[65536];
+    for (;;) {
+        ssize_t got = read(fd, chunk, sizeof(chunk));
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return false;
+        }
+        if (got == 0) break;
+        contents.insert(contents.end(), chunk, chunk + got);
+    }
+    close(fd);
+    assign(contents.data(), contents.size());
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <vector>
+
+// A program's source text followed by the two '\0' bytes the scanner needs
+// to scan it in place (parse_source). A file is mapped into memory
+// copy-on-write rather than read, so the scanner's tokens point straight
+// into the page cache; the scanner writes to the text as it goes, which
+// never reaches the file.
+class SourceBuffer {
+private:
+    char* text;
+    size_t length;
+    size_t mapped;             // Bytes mapped at text; 0 if it is in copy
+    std::vector<char> copy;
+
+    void unmap();
+
+public:
+    SourceBuffer() : text(nullptr), length(0), mapped(0) {}
+    ~SourceBuffer() { unmap(); }
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // Map path, or read it if it can't be mapped (a pipe, say); false, with
+    // errno set, if it can't be read at all
+    bool load_file(const char* path);
+    // A copy of text[0..length)
+    void assign(const char* source, size_t size);
+
+    char* data() { return text; }
+    size_t size() const { return length; }
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,64 @@
+#include "symbol.h"
+#include <cstring>
+
+static const uint32_t EMPTY = UINT32_MAX;
+
+static uint32_t hash_bytes(const char* text, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+Interner::Interner() : slots(256, EMPTY) {
+    intern("print", 5);
+    intern("main", 4);
+}
+
+// Slot holding text, or the empty slot where it belongs
+size_t Interner::probe(const char* text, size_t length, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    for (; slots[i] != EMPTY; i = (i + 1) & mask) {
+        const Entry& existing = entries[slots[i]];
+        if (existing.hash == hash && existing.length == length &&
+            memcmp(existing.text, text, length) == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+Symbol Interner::intern(const char* text, size_t length) {
+    uint32_t hash = hash_bytes(text, length);
+    size_t i = probe(text, length, hash);
+    if (slots[i] != EMPTY) return slots[i];
+
+    Symbol sym = static_cast<Symbol>(entries.size());
+    entries.push_back(Entry{storage.copy_string(text, length), static_cast<uint32_t>(length), hash});
+    slots[i] = sym;
+    // Keep the table at most half full so probe sequences stay short
+    if (entries.size() * 2 > slots.size()) {
+        grow();
+    }
+    return sym;
+}
+
+Symbol Interner::find(const char* text, size_t length) const {
+    size_t i = probe(text, length, hash_bytes(text, length));
+    return slots[i] == EMPTY ? NO_SYMBOL : slots[i];
+}
+
+void Interner::grow() {
+    std::vector<uint32_t> grown(slots.size() * 2, EMPTY);
+    size_t mask = grown.size() - 1;
+    for (Symbol sym = 0; sym < entries.size(); sym++) {
+        size_t i = entries[sym].hash & mask;
+        while (grown[i] != EMPTY) i = (i + 1) & mask;
+        grown[i] = sym;
+    }
+    slots.swap(grown);
+}
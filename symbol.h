@@ -0,0 +1,52 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "arena.h"
+
+// Identifiers are interned once, when the lexer produces them, and are then
+// passed around as dense integer IDs that index flat symbol tables.
+typedef uint32_t Symbol;
+
+// Names the compiler itself looks for, interned up front with fixed IDs
+enum : Symbol {
+    SYM_PRINT = 0,
+    SYM_MAIN = 1
+};
+
+// Returned by Interner::find for a name that was never interned
+static const Symbol NO_SYMBOL = UINT32_MAX;
+
+// Each compile has its own interner, filled in while its source is parsed and
+// only read afterwards, so it needs no lock, and tables indexed by Symbol are
+// sized by the program's own identifier count and freed with it.
+class Interner {
+private:
+    struct Entry {
+        const char* text;
+        uint32_t length;
+        uint32_t hash;
+    };
+
+    Arena storage;                 // Owns the interned text
+    std::vector<Entry> entries;    // Indexed by Symbol
+    std::vector<uint32_t> slots;   // Open-addressed hash table of Symbols
+
+    size_t probe(const char* text, size_t length, uint32_t hash) const;
+    void grow();
+
+public:
+    Interner();
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    Symbol intern(const char* text, size_t length);
+    // The Symbol of an interned name, or NO_SYMBOL
+    Symbol find(const char* text, size_t length) const;
+    const char* name(Symbol sym) const { return entries[sym].text; }
+    size_t size() const { return entries.size(); }
+};
+
+#endif // SYMBOL_H
@@ -0,0 +1,102 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned threads)
+    : current_task(nullptr), remaining(0), generation(0), stopping(false) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; i++) {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, unsigned)>& task) {
+    if (workers.empty() || count < 2) {
+        for (size_t i = 0; i < count; i++) task(i, 0);
+        return;
+    }
+
+    // Publish the task before any item becomes visible to a worker
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        current_task = &task;
+        remaining = count;
+    }
+
+    // Deal out contiguous chunks so neighbouring items start on the same worker
+    for (size_t i = 0; i < count; i++) {
+        WorkQueue& queue = *queues[i * queues.size() / count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.items.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        generation++;
+    }
+    wake.notify_all();
+
+    run_items(0);
+
+    std::unique_lock<std::mutex> lock(state_lock);
+    done.wait(lock, [this] { return remaining == 0; });
+    current_task = nullptr;
+}
+
+void ThreadPool::worker_loop(unsigned id) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(state_lock);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        run_items(id);
+    }
+}
+
+void ThreadPool::run_items(unsigned id) {
+    size_t item;
+    while (next_item(id, item)) {
+        (*current_task)(item, id);
+        std::lock_guard<std::mutex> guard(state_lock);
+        if (--remaining == 0) {
+            done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::next_item(unsigned id, size_t& item) {
+    {
+        WorkQueue& own = *queues[id];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.items.empty()) {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkQueue& victim = *queues[(id + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing pool. Each worker has its own queue of item
+// indices; it takes work from the front of its own queue and, once that runs
+// dry, steals from the back of the others. The calling thread participates
+// as worker 0, so a pool of size 1 runs everything inline.
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    std::mutex state_lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, unsigned)>* current_task;
+    size_t remaining;
+    unsigned generation;
+    bool stopping;
+
+    void worker_loop(unsigned id);
+    void run_items(unsigned id);
+    bool next_item(unsigned id, size_t& item);
+
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Run task(index, worker) for every index in [0, count) and wait for all
+    // of them; worker is in [0, size()) and identifies the executing thread.
+    void parallel_for(size_t count, const std::function<void(size_t, unsigned)>& task);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,113 @@
+#include "timing.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sys/resource.h>
+
+static uint64_t (*allocation_counter)() = nullptr;
+
+void set_allocation_counter(uint64_t (*counter)()) {
+    allocation_counter = counter;
+}
+
+uint64_t allocation_count() {
+    return allocation_counter ? allocation_counter() : 0;
+}
+
+static double seconds(const timeval& t) {
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+// CPU time of this process and of the waited-for tools it ran
+static double cpu_time() {
+    rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    return seconds(self.ru_utime) + seconds(self.ru_stime) +
+           seconds(children.ru_utime) + seconds(children.ru_stime);
+}
+
+static long tool_peak_rss() {
+    rusage children;
+    getrusage(RUSAGE_CHILDREN, &children);
+    return children.ru_maxrss;
+}
+
+PhaseTimer::PhaseTimer(const std::string& name)
+    : name(name), wall_start(std::chrono::steady_clock::now()), cpu_start(cpu_time()),
+      tool_rss_start(tool_peak_rss()), allocations_start(allocation_count()) {}
+
+PhaseTiming PhaseTimer::stop() const {
+    PhaseTiming timing;
+    timing.name = name;
+    timing.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    timing.cpu_seconds = cpu_time() - cpu_start;
+    rusage self;
+    getrusage(RUSAGE_SELF, &self);
+    timing.peak_rss_kb = self.ru_maxrss;
+    // Only the largest tool ever run is known, so it counts for the phase
+    // that raised it
+    long tool_rss = tool_peak_rss();
+    if (tool_rss > tool_rss_start && tool_rss > timing.peak_rss_kb) {
+        timing.peak_rss_kb = tool_rss;
+    }
+    timing.allocations = allocation_count() - allocations_start;
+    return timing;
+}
+
+void TimeReport::print(std::ostream& os) const {
+    os << "Time report:\n";
+    os << "  phase          wall ms     cpu ms  peak RSS KB  allocations\n";
+    os << std::fixed << std::setprecision(2);
+    PhaseTiming total;
+    for (const PhaseTiming& phase : phases) {
+        os << "  " << std::left << std::setw(12) << phase.name << std::right
+           << std::setw(10) << phase.wall_seconds * 1000
+           << std::setw(11) << phase.cpu_seconds * 1000 << std::setw(13) << phase.peak_rss_kb
+           << std::setw(13) << phase.allocations << "\n";
+        total.wall_seconds += phase.wall_seconds;
+        total.cpu_seconds += phase.cpu_seconds;
+        total.peak_rss_kb = std::max(total.peak_rss_kb, phase.peak_rss_kb);
+        total.allocations += phase.allocations;
+    }
+    os << "  " << std::left << std::setw(12) << "total" << std::right << std::setw(10)
+       << total.wall_seconds * 1000 << std::setw(11) << total.cpu_seconds * 1000
+       << std::setw(13) << total.peak_rss_kb << std::setw(13) << total.allocations << "\n";
+    os << "  " << ast_nodes << " AST nodes, " << functions << " functions, " << ir_instructions
+       << " IR instructions, " << ir_bytes << " IR bytes\n";
+}
+
+void TimeReport::print_json(std::ostream& os) const {
+    // Phase names are fixed identifiers, so nothing needs escaping
+    os << "{\"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const PhaseTiming& phase = phases[i];
+        char times[64];
+        snprintf(times, sizeof(times), "\"wall_ms\": %.3f, \"cpu_ms\": %.3f",
+                 phase.wall_seconds * 1000, phase.cpu_seconds * 1000);
+        os << (i > 0 ? ", " : "") << "{\"name\": \"" << phase.name << "\", " << times
+           << ", \"peak_rss_kb\": " << phase.peak_rss_kb << ", \"allocations\": " << phase.allocations << "}";
+    }
+    os << "], \"ast_nodes\": " << ast_nodes << ", \"functions\": " << functions
+       << ", \"ir_instructions\": " << ir_instructions << ", \"ir_bytes\": " << ir_bytes << "}\n";
+}
+
+size_t count_ast_nodes(ProgramNode* program) {
+    size_t count = 1;
+    for (FunctionDefNode* func : program->functions) {
+        count += 1 + count_nodes(func->body);
+    }
+    return count;
+}
+
+size_t count_ir_instructions(const std::string& ir) {
+    size_t count = 0;
+    size_t line = 0;
+    while (line < ir.size()) {
+        if (ir.compare(line, 2, "  ") == 0) count++;
+        size_t end = ir.find('\n', line);
+        if (end == std::string::npos) break;
+        line = end + 1;
+    }
+    return count;
+}
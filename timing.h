@@ -0,0 +1,59 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+// Resources one compiler phase used, reported by --time-report
+struct PhaseTiming {
+    std::string name;
+    double wall_seconds = 0;
+    double cpu_seconds = 0;      // User and system time of pyc and the tools it ran
+    long peak_rss_kb = 0;        // Peak resident set size so far, of pyc or of a tool the phase ran
+    uint64_t allocations = 0;    // Heap allocations on every thread, if a counter is set
+};
+
+struct TimeReport {
+    std::vector<PhaseTiming> phases;
+    size_t ast_nodes = 0;        // As parsed, before the AST optimizer
+    size_t functions = 0;
+    // Emitted IR, before any LLVM pass; with the cache, only for the
+    // functions that were compiled
+    size_t ir_instructions = 0;
+    size_t ir_bytes = 0;
+
+    void print(std::ostream& os) const;
+    void print_json(std::ostream& os) const;
+};
+
+// Measures the phase between construction and stop()
+class PhaseTimer {
+private:
+    std::string name;
+    std::chrono::steady_clock::time_point wall_start;
+    double cpu_start;
+    long tool_rss_start;
+    uint64_t allocations_start;
+
+public:
+    explicit PhaseTimer(const std::string& name);
+    PhaseTiming stop() const;
+};
+
+// The library leaves the host's allocator alone, so allocations are only
+// counted if the host counts them itself and passes its counter here, as the
+// pyc command does
+void set_allocation_counter(uint64_t (*counter)());
+// Allocations so far as the counter reports them, or 0 without one
+uint64_t allocation_count();
+
+size_t count_ast_nodes(ProgramNode* program);
+// Instructions in textual LLVM IR as the code generator writes it: every
+// indented line
+size_t count_ir_instructions(const std::string& ir);
+
+#endif // TIMING_H